@@ -9,6 +9,7 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <string_view>
 
 #include <commdlg.h>
@@ -1061,11 +1062,13 @@ App::App(HINSTANCE hInstance, HWND hwnd) : hInstance_(hInstance), hwnd_(hwnd) {
     lua_.Init(&replayer_);
     luaEditor_ = "set_speed(1.0)\nmouse_move(500, 500)\nmouse_down('left')\nwait_ms(60)\nmouse_up('left')\n";
     LoadConfig();
+    scheduler_.SetMaxConcurrency(schedulerWorkers_);
     scheduler_.Start([this](const ScheduledTask& task) { OnSchedulerTaskFired(task); });
     LOG_INFO("App::App", "Application initialized successfully");
 }
 App::~App() {
     LOG_INFO("App::~App", "Application shutting down");
+    schedShutdown_.Set();
     scheduler_.Stop();
     SaveWindowGeometry();
     SaveConfig();
@@ -1146,6 +1149,8 @@ void App::OnFrame() {
         lastBlockInputState_ = blockState;
     }
 
+    ProcessSchedulerRuns();
+
     if (recorder_.IsRecording()) {
         const int64_t elapsed = timing::QpcDeltaToMicros(timing::QpcNow() - recordStartQpc_);
         overlay_.SetElapsedMicros(elapsed);
@@ -1275,6 +1280,17 @@ static std::string FormatEvent(const trc::RawEvent& e) {
     return std::string(buf);
 }
 
+void App::CacheEventRows(size_t first, size_t count) {
+    if (first >= eventRowsFirst_ && first + count <= eventRowsFirst_ + eventRows_.size()) return;
+    // Fetch a margin on both sides so scrolling a few rows reuses the cache.
+    const size_t margin = std::max<size_t>(count, 32);
+    const size_t from = first > margin ? first - margin : 0;
+    eventRowsFirst_ = recorder_.CopyRange(from, count + 2 * margin, eventRowScratch_);
+    eventRows_.clear();
+    eventRows_.reserve(eventRowScratch_.size());
+    for (const auto& e : eventRowScratch_) eventRows_.push_back(FormatEvent(e));
+}
+
 // ═══════════════════════════════════════════════════════════════════════════
 // SIMPLE MODE
 // ═══════════════════════════════════════════════════════════════════════════
@@ -1350,12 +1366,25 @@ void App::DrawSimpleMode() {
             ImGui::PopStyleColor(2);
             ImGui::Checkbox("屏蔽输入", &blockInput_);
             if (ImGui::IsItemHovered()) ImGui::SetTooltip("回放时屏蔽物理键鼠输入");
+            ImGui::Checkbox("录制直接写盘", &streamRecording_);
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("录制时直接写入临时文件，内存中只保留最近的事件，适合长时间录制");
+            const char* filterModes[] = { "不过滤", "最小间隔", "最小距离", "轨迹简化" };
+            ImGui::AlignTextToFramePadding();
+            ImGui::Text("移动过滤");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(-1);
+            ImGui::Combo("##move_filter", &moveFilterMode_, filterModes, IM_ARRAYSIZE(filterModes));
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("录制时合并高回报率鼠标的细碎移动；点击、按键和滚轮始终完整保留");
         }
         EndGlassCard();
 
         ImGui::Spacing();
         ImGui::TextColored(ImVec4(0.55f, 0.50f, 0.75f, 0.8f), "事件: %zu", recorder_.EventCount());
         ImGui::TextColored(ImVec4(0.55f, 0.50f, 0.75f, 0.8f), "时长: %.1f 秒", recorder_.TotalDurationMicros() / 1'000'000.0);
+        if (const MoveFilterStats moves = recorder_.MoveStats(); moves.inputMoves != moves.outputMoves) {
+            ImGui::TextColored(ImVec4(0.55f, 0.50f, 0.75f, 0.8f), "移动压缩: %llu → %llu (%.1f:1)",
+                (unsigned long long)moves.inputMoves, (unsigned long long)moves.outputMoves, moves.Ratio());
+        }
 
         // ─── MIDDLE COLUMN: Actions ─────────────────────────────────────
         ImGui::TableNextColumn();
@@ -1404,6 +1433,11 @@ void App::DrawSimpleMode() {
                     dl->AddCircleFilled(ImVec2(barPos.x + barW * progress, barPos.y + barH * 0.5f), 4.0f * s, IM_COL32(100, 200, 255, 150));
                 }
                 ImGui::Dummy(ImVec2(0, barH + 6.0f * s));
+                const ReplayTimingStats timingStats = replayer_.TimingStats();
+                if (timingStats.events > 0) {
+                    ImGui::TextColored(ImVec4(0.55f, 0.50f, 0.75f, 0.8f), "时序偏差: p99 ≤ %lld µs  最大 %lld µs",
+                        (long long)timingStats.PercentileMicros(0.99), (long long)timingStats.maxLatenessMicros);
+                }
                 if (replayer_.IsPaused()) {
                     if (GlowButton("继续回放", ImVec2(-1, btnH), IM_COL32(40, 160, 80, 255), IM_COL32(30, 200, 120, 255)))
                         replayer_.Resume();
@@ -1440,20 +1474,30 @@ void App::DrawSimpleMode() {
             const float listH = ImGui::GetContentRegionAvail().y;
             BeginGlassScrollCard("##event_list_card", "事件列表", ImVec2(-1, listH));
             {
-                // Take a locked snapshot to avoid data races with the drain thread.
-                const auto evSnap = recorder_.EventsCopy();
-                if (evSnap.empty()) {
+                // Only the visible rows are copied out of the recorder; their
+                // text is cached until the recording is replaced.
+                const auto range = recorder_.AvailableRange();
+                if (range.generation != eventRowsGeneration_) {
+                    eventRowsGeneration_ = range.generation;
+                    eventRows_.clear();
+                }
+                if (range.count == 0) {
                     ImGui::Spacing(); ImGui::Spacing();
                     ImGui::TextColored(ImVec4(0.55f, 0.50f, 0.75f, 0.6f), "暂无事件\n\n点击「开始录制」捕获操作\n或「加载文件」打开已有录制");
                 } else {
                     ImGuiListClipper clipper;
-                    clipper.Begin((int)evSnap.size());
+                    // A fixed row height skips the clipper's measuring pass over row 0.
+                    clipper.Begin((int)range.count, ImGui::GetTextLineHeightWithSpacing());
                     while (clipper.Step()) {
+                        const size_t first = range.firstIndex + (size_t)clipper.DisplayStart;
+                        CacheEventRows(first, (size_t)(clipper.DisplayEnd - clipper.DisplayStart));
                         for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
-                            const auto& evt = evSnap[i];
-                            ImGui::TextColored(ImVec4(0.45f, 0.40f, 0.65f, 0.8f), "%06d", i + 1);
+                            const size_t index = range.firstIndex + (size_t)i;
+                            // Streaming may have trimmed the row since AvailableRange().
+                            const bool cached = index >= eventRowsFirst_ && index - eventRowsFirst_ < eventRows_.size();
+                            ImGui::TextColored(ImVec4(0.45f, 0.40f, 0.65f, 0.8f), "%06zu", index + 1);
                             ImGui::SameLine();
-                            ImGui::TextColored(ImVec4(0.82f, 0.80f, 0.92f, 1.0f), "%s", FormatEvent(evt).c_str());
+                            ImGui::TextColored(ImVec4(0.82f, 0.80f, 0.92f, 1.0f), "%s", cached ? eventRows_[index - eventRowsFirst_].c_str() : "");
                         }
                     }
                     if (recorder_.IsRecording() && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) ImGui::SetScrollHereY(1.0f);
@@ -1576,8 +1620,18 @@ void App::DrawAdvancedMode() {
             if (ImGui::InputFloat("##tol_input", &tol, 0.0f, 0.0f, "%.1f"))
                 tol = std::clamp(tol, 0.5f, 20.0f);
             ImGui::Checkbox("高保真导出", &exportFull_);
+            ImGui::BeginDisabled(!exportFull_);
+            ImGui::SameLine();
+            ImGui::Checkbox("紧凑格式", &exportCompact_);
+            if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+                ImGui::SetTooltip("事件打包为 play_events() 数据，脚本体积小、加载快");
+            ImGui::EndDisabled();
             if (ImGui::Button("执行转换", ImVec2(-1, 0))) {
-                bool ok = exportFull_ ? Converter::TrcToLuaFull(Utf8ToWide(trcPath_), Utf8ToWide(luaPath_)) : Converter::TrcToLua(Utf8ToWide(trcPath_), Utf8ToWide(luaPath_), tol);
+                const std::wstring trcFile = Utf8ToWide(trcPath_);
+                const std::wstring luaFile = Utf8ToWide(luaPath_);
+                bool ok = !exportFull_ ? Converter::TrcToLua(trcFile, luaFile, tol)
+                    : exportCompact_ ? Converter::TrcToLuaCompact(trcFile, luaFile)
+                    : Converter::TrcToLuaFull(trcFile, luaFile);
                 if (ok) { luaEditor_ = ReadTextFile(Utf8ToWide(luaPath_)); luaLastError_.clear(); SetStatusOk("导出成功"); ImGui::CloseCurrentPopup(); }
                 else SetStatusError("导出失败");
             }
@@ -1642,33 +1696,68 @@ void App::DrawAdvancedMode() {
 // SCHEDULER MODE
 // ═══════════════════════════════════════════════════════════════════════════
 
+// Runs on a scheduler executor thread. The run itself is started by the UI
+// thread on its next frame; this thread then waits for the replay or script
+// to finish, so the scheduler's exclusiveInput and maxConcurrent limits cover
+// the whole run rather than just starting it.
 void App::OnSchedulerTaskFired(const ScheduledTask& task) {
     LOG_INFO("App::OnSchedulerTaskFired", "Task fired: id=%d name='%s' actionMode=%d path='%s'",
         task.id, task.name.c_str(), task.actionMode, task.actionPath.c_str());
-    SchedulerExecuteTask(task);
+    auto run = std::make_shared<SchedulerRun>();
+    run->task = task;
+    {
+        std::scoped_lock lk(schedRunsMutex_);
+        schedRuns_.push_back(run);
+    }
+    if (!WaitSchedulerEvent(run->handled)) return;
+    // A run the UI thread could not start is a failure: the scheduler records
+    // it and applies the task's retry policy. Shutdown is not.
+    if (!run->started) {
+        if (schedShutdown_.IsSet()) return;
+        throw std::runtime_error("failed to start");
+    }
+    WaitSchedulerEvent(task.actionMode == 0 ? replayer_.IdleEvent() : lua_.IdleEvent());
+    LOG_INFO("App::OnSchedulerTaskFired", "Task finished: id=%d", task.id);
+}
+
+bool App::WaitSchedulerEvent(const threading::Event& event) const {
+    const HANDLE handles[2] = { event.NativeHandle(), schedShutdown_.NativeHandle() };
+    return WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0;
 }
 
-void App::SchedulerExecuteTask(const ScheduledTask& task) {
+void App::ProcessSchedulerRuns() {
+    std::deque<std::shared_ptr<SchedulerRun>> runs;
+    {
+        std::scoped_lock lk(schedRunsMutex_);
+        runs.swap(schedRuns_);
+    }
+    for (auto& run : runs) {
+        run->started = SchedulerExecuteTask(run->task);
+        run->handled.Set();
+    }
+}
+
+bool App::SchedulerExecuteTask(const ScheduledTask& task) {
     if (task.actionMode == 0) {
         // TRC replay
         trcPath_ = task.actionPath;
-        StartReplayConfirmed();
-    } else {
-        // Lua script
-        std::string code = ReadTextFile(Utf8ToWide(task.actionPath));
-        if (code.empty()) {
-            LOG_ERROR("App::SchedulerExecuteTask", "Failed to read script: %s", task.actionPath.c_str());
-            SetStatusError("定时任务：脚本读取失败");
-            return;
-        }
-        if (!lua_.StartAsync(code)) {
-            LOG_ERROR("App::SchedulerExecuteTask", "Failed to start script: %s", task.actionPath.c_str());
-            SetStatusError("定时任务：脚本启动失败");
-        } else {
-            LOG_INFO("App::SchedulerExecuteTask", "Script started: %s", task.actionPath.c_str());
-            SetStatusOk("定时任务：脚本已启动");
-        }
+        return StartReplayConfirmed();
+    }
+    // Lua script
+    std::string code = ReadTextFile(Utf8ToWide(task.actionPath));
+    if (code.empty()) {
+        LOG_ERROR("App::SchedulerExecuteTask", "Failed to read script: %s", task.actionPath.c_str());
+        SetStatusError("定时任务：脚本读取失败");
+        return false;
     }
+    if (!lua_.StartAsync(code)) {
+        LOG_ERROR("App::SchedulerExecuteTask", "Failed to start script: %s", task.actionPath.c_str());
+        SetStatusError("定时任务：脚本启动失败");
+        return false;
+    }
+    LOG_INFO("App::SchedulerExecuteTask", "Script started: %s", task.actionPath.c_str());
+    SetStatusOk("定时任务：脚本已启动");
+    return true;
 }
 
 void App::DrawSchedulerMode() {
@@ -1679,9 +1768,11 @@ void App::DrawSchedulerMode() {
     const float fullW = avail.x;
     const float fullH = avail.y - 36.0f * s; // reserve space for status bar
 
-    auto tasks = scheduler_.GetTasks();
+    // Shared, immutable view; only rebuilt after the scheduler changed a task.
+    const std::shared_ptr<const TaskSnapshot> snapshot = scheduler_.Snapshot();
+    const auto& tasks = snapshot->tasks;
     const int taskCount = (int)tasks.size();
-    const int activeCount = scheduler_.ActiveTaskCount();
+    const int activeCount = snapshot->activeCount;
 
     ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.08f, 0.06f, 0.18f, 0.60f));
 
@@ -1723,7 +1814,8 @@ void App::DrawSchedulerMode() {
             }
 
             // Stats on the right
-            const float statsX = fullW - 320.0f * s;
+            const SchedulerMetrics metrics = scheduler_.Metrics();
+            const float statsX = fullW - 420.0f * s;
             if (statsX > ImGui::GetCursorPosX()) ImGui::SameLine(statsX);
             ImGui::SetCursorPosY(cy);
             ImGui::TextColored(ImVec4(0.6f, 0.8f, 1.0f, 1.0f), "总任务: %d", taskCount);
@@ -1731,6 +1823,15 @@ void App::DrawSchedulerMode() {
             ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.6f, 1.0f), "活跃: %d", activeCount);
             ImGui::SameLine(0, 16.0f * s);
             ImGui::TextColored(ImVec4(0.6f, 0.5f, 0.8f, 0.8f), "完成: %d", taskCount - activeCount);
+            ImGui::SameLine(0, 16.0f * s);
+            ImGui::TextColored(ImVec4(1.0f, 0.85f, 0.4f, 0.9f), "执行: %d/%d 排队: %d",
+                metrics.running, scheduler_.MaxConcurrency(), metrics.queued);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("已执行 %llu 次, 合并触发 %llu 次\n排队等待: 平均 %.1f ms, 最长 %.1f ms\n运行时间: 平均 %.1f ms, 最长 %.1f ms",
+                    (unsigned long long)metrics.completed, (unsigned long long)metrics.coalesced,
+                    metrics.MeanQueueMillis(), metrics.maxQueueMicros / 1000.0,
+                    metrics.MeanRunMillis(), metrics.maxRunMicros / 1000.0);
+            }
         }
         ImGui::EndChild();
         ImGui::PopStyleVar();
@@ -2005,6 +2106,16 @@ void App::DrawSchedulerMode() {
                     ImGui::SameLine(0, 16.0f * s);
                     ImGui::Checkbox("屏蔽输入", &editTask_.actionBlockInput);
                 }
+                ImGui::SameLine(0, 16.0f * s);
+                ImGui::Text("并发:");
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(50.0f * s);
+                ImGui::InputInt("##task_max_conc", &editTask_.maxConcurrent, 0, 0);
+                if (editTask_.maxConcurrent < 0) editTask_.maxConcurrent = 0;
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("同一任务允许同时运行的数量 (0=不限)");
+                ImGui::SameLine(0, 12.0f * s);
+                ImGui::Checkbox("独占鼠标键盘", &editTask_.exclusiveInput);
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("勾选的任务之间互斥执行，不会同时操作鼠标键盘");
 
                 // ── Second row: validation message + buttons ──
                 if (!schedValidationMsg_.empty()) {
@@ -2115,7 +2226,7 @@ void App::DrawSchedulerMode() {
                     ImGui::TextColored(ImVec4(0.55f, 0.50f, 0.75f, 0.6f), "暂无定时任务，请在上方添加");
                 } else {
                     for (int ti = 0; ti < taskCount; ++ti) {
-                        const auto& t = tasks[ti];
+                        const ScheduledTask& t = *tasks[ti];
                         ImGui::PushID(t.id);
 
                         const float rowW = ImGui::GetContentRegionAvail().x;
@@ -2289,7 +2400,7 @@ void App::DrawSchedulerMode() {
             BeginGlassScrollCard("##sched_detail", "任务详情", ImVec2(-1, detH));
             {
                 if (schedSelectedTask_ >= 0 && schedSelectedTask_ < taskCount) {
-                    const auto& sel = tasks[schedSelectedTask_];
+                    const ScheduledTask& sel = *tasks[schedSelectedTask_];
 
                     ImGui::PushStyleColor(ImGuiCol_Tab, ImVec4(0.15f, 0.12f, 0.25f, 0.8f));
                     ImGui::PushStyleColor(ImGuiCol_TabSelected, ImVec4(0.30f, 0.25f, 0.50f, 1.0f));
@@ -2366,6 +2477,8 @@ void App::DrawSchedulerMode() {
                         if (sel.actionMode == 0)
                             ImGui::Text("速度: %.1fx  屏蔽输入: %s",
                                 sel.actionSpeed, sel.actionBlockInput ? "是" : "否");
+                        ImGui::Text("并发上限: %d  独占鼠标键盘: %s",
+                            sel.maxConcurrent, sel.exclusiveInput ? "是" : "否");
                         if (sel.windowStartHour != 0 || sel.windowEndHour != 0) {
                             ImGui::SameLine(0, 12.0f * s);
                             ImGui::Text("时间窗: %d:00~%d:00", sel.windowStartHour, sel.windowEndHour);
@@ -2459,7 +2572,7 @@ void App::DrawSchedulerMode() {
                 if (schedDeleteConfirmId_ >= 0) {
                     // Find index of the task being deleted
                     for (int di = 0; di < taskCount; ++di) {
-                        if (tasks[di].id == schedDeleteConfirmId_) {
+                        if (tasks[di]->id == schedDeleteConfirmId_) {
                             if (schedSelectedTask_ == di) schedSelectedTask_ = -1;
                             else if (schedSelectedTask_ > di) schedSelectedTask_--;
                             break;
@@ -2534,6 +2647,19 @@ void App::DrawLogMode() {
                 Logger::Instance().SetFileOutput(logFileOutput_, logFilePath_);
             }
             ImGui::PopStyleColor();
+
+            ImGui::SameLine();
+            const char* formatLabels[] = { "文本", "二进制" };
+            ImGui::SetNextItemWidth(70.0f * s);
+            ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.08f, 0.06f, 0.18f, 0.60f));
+            if (ImGui::Combo("##log_format", &logFileFormat_, formatLabels, 2)) {
+                Logger::Instance().SetFileFormat((LogFileFormat)logFileFormat_);
+            }
+            ImGui::PopStyleColor();
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("二进制日志体积更小、写入更快，用 acp_logdump 转为文本或 JSON\n超过 %d MB 时轮转，保留 %d 个文件",
+                    logMaxFileMB_, logMaxFiles_);
+            }
         }
 
         ImGui::SameLine(0, 14.0f * s);
@@ -2584,12 +2710,13 @@ void App::DrawLogMode() {
         const float logLineH = ImGui::GetTextLineHeight();
         const float logScrollY = ImGui::GetScrollY();
         
-        auto entries = Logger::Instance().GetEntries((LogLevel)logFilterLevel_);
+        SyncLogRows();
+        const auto& visible = logByLevel_[std::clamp(logFilterLevel_, 0, 4)];
         ImGuiListClipper clipper;
-        clipper.Begin((int)entries.size());
+        clipper.Begin((int)visible.size());
         while (clipper.Step()) {
             for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
-                const auto& e = entries[i];
+                const auto& e = logRows_[(size_t)(visible[i] - logRows_.front().seq)];
                 
                 // Draw line number in gutter
                 const float lineY = logWinPos.y + ImGui::GetStyle().WindowPadding.y + (i * logLineH) - logScrollY;
@@ -2644,6 +2771,26 @@ void App::DrawLogMode() {
     ImGui::PopStyleColor();
 }
 
+void App::SyncLogRows() {
+    auto& logger = Logger::Instance();
+    auto fresh = logger.GetEntriesSince(logSeenSeq_);
+    if (!fresh.empty() && fresh.front().seq != logSeenSeq_ + 1) {
+        // Fell behind the ring (or it was cleared); start over from what it holds.
+        logRows_.clear();
+        for (auto& idx : logByLevel_) idx.clear();
+    }
+    for (auto& e : fresh) {
+        logSeenSeq_ = e.seq;
+        for (int l = 0; l <= (int)e.level && l < 5; ++l) logByLevel_[l].push_back(e.seq);
+        logRows_.push_back(std::move(e));
+    }
+    const uint64_t oldest = logger.OldestSequence();
+    while (!logRows_.empty() && logRows_.front().seq < oldest) logRows_.pop_front();
+    for (auto& idx : logByLevel_) {
+        while (!idx.empty() && idx.front() < oldest) idx.pop_front();
+    }
+}
+
 // ─── Status bar ─────────────────────────────────────────────────────────────
 
 void App::DrawStatusBar() {
@@ -2767,7 +2914,27 @@ void App::SetStatusError(const std::string& text)  { std::scoped_lock lk(statusM
 
 void App::StartRecording() {
     LOG_INFO("App::StartRecording", "Starting recording");
-    EmergencyStop(); recorder_.Start(); hooks_.Install(&recorder_);
+    EmergencyStop();
+    MoveFilterConfig filter;
+    filter.mode = static_cast<MoveFilterMode>(std::clamp(moveFilterMode_, 0, 3));
+    filter.minIntervalMicros = std::max(moveFilterIntervalUs_, 1);
+    filter.minDistancePx = std::max(moveFilterDistancePx_, 1);
+    filter.rdpTolerancePx = std::max(moveFilterTolerancePx_, 0.0f);
+    recorder_.SetMoveFilter(filter);
+    bool streaming = false;
+    if (streamRecording_) {
+        // Unique per process and recording: another instance, or a replay still
+        // reading the previous recording, must not share the file.
+        wchar_t name[64];
+        swprintf(name, 64, L"AutoClickerPro_%lu_%lld.trc", static_cast<unsigned long>(GetCurrentProcessId()),
+            static_cast<long long>(timing::QpcNow()));
+        std::error_code ec;
+        const auto spillPath = std::filesystem::temp_directory_path(ec) / name;
+        streaming = !ec && recorder_.StartStreaming(spillPath.wstring(), Recorder::kDefaultTailEvents, true);
+        if (!streaming) LOG_WARN("App::StartRecording", "Streaming unavailable, recording in memory");
+    }
+    if (!streaming) recorder_.Start();
+    hooks_.Install(&recorder_);
     recordStartQpc_ = timing::QpcNow(); overlay_.SetRecording(true); overlay_.SetElapsedMicros(0); overlay_.Show();
 }
 void App::StopRecording() {
@@ -2788,28 +2955,35 @@ void App::StartReplay() {
     if (blockInput_) { pendingStartReplay_ = true; blockInputConfirmOpen_ = true; return; }
     StartReplayConfirmed();
 }
-void App::StartReplayConfirmed() {
+bool App::StartReplayConfirmed() {
     if (recorder_.IsRecording()) StopRecording();
     // If no events in memory, try loading from file
     if (recorder_.EventCount() == 0) {
         if (!recorder_.LoadFromFile(Utf8ToWide(trcPath_))) {
             LOG_ERROR("App::StartReplayConfirmed", "No events and failed to load trc file: %s", trcPath_.c_str());
-            SetStatusError("回放失败：无事件且无法读取 .trc"); return;
+            SetStatusError("回放失败：无事件且无法读取 .trc"); return false;
         }
     }
-    auto copy = recorder_.EventsCopy();
-    if (copy.empty()) {
-        SetStatusError("回放失败：事件列表为空"); return;
+    // A loaded file is replayed straight from its mapping; only a live
+    // recording needs a snapshot of the in-memory events.
+    auto view = recorder_.MappedView();
+    std::vector<trc::RawEvent> copy;
+    if (!view) copy = recorder_.EventsCopy();
+    const size_t evCount = view ? view->EventCount() : copy.size();
+    if (evCount == 0) {
+        SetStatusError("回放失败：事件列表为空"); return false;
     }
-    const size_t evCount = copy.size();
     replayer_.SetSpeed(speedFactor_);
-    if (replayer_.Start(std::move(copy), blockInput_, speedFactor_)) {
+    const bool started = view ? replayer_.Start(std::move(view), blockInput_, speedFactor_)
+                              : replayer_.Start(std::move(copy), blockInput_, speedFactor_);
+    if (started) {
         LOG_INFO("App::StartReplayConfirmed", "Replay started, events=%zu speed=%.1f", evCount, speedFactor_);
         SetStatusOk("已开始回放");
     } else {
         LOG_ERROR("App::StartReplayConfirmed", "Replay failed to start");
         SetStatusError("回放失败");
     }
+    return started;
 }
 void App::StopReplay() {
     LOG_INFO("App::StopReplay", "Stopping replay");
@@ -2869,9 +3043,15 @@ void App::LoadConfig() {
         if (key == "mode") mode_ = std::atoi(value.c_str());
         else if (key == "blockInput") blockInput_ = (value == "1" || value == "true");
         else if (key == "speedFactor") speedFactor_ = (float)std::atof(value.c_str());
+        else if (key == "streamRecording") streamRecording_ = (value == "1" || value == "true");
+        else if (key == "moveFilterMode") moveFilterMode_ = std::clamp(std::atoi(value.c_str()), 0, 3);
+        else if (key == "moveFilterIntervalUs") moveFilterIntervalUs_ = std::max(std::atoi(value.c_str()), 1);
+        else if (key == "moveFilterDistancePx") moveFilterDistancePx_ = std::max(std::atoi(value.c_str()), 1);
+        else if (key == "moveFilterTolerancePx") moveFilterTolerancePx_ = std::max((float)std::atof(value.c_str()), 0.0f);
         else if (key == "trcPath") trcPath_ = value;
         else if (key == "luaPath") luaPath_ = value;
         else if (key == "exportFull") exportFull_ = (value == "1" || value == "true");
+        else if (key == "exportCompact") exportCompact_ = (value == "1" || value == "true");
         else if (key == "minimizeOnScriptRun") minimizeOnScriptRun_ = (value == "1" || value == "true");
         else if (key == "docsOpen") luaUi_.docsOpen = (value == "1" || value == "true");
         else if (key == "assistEnabled") luaUi_.assistEnabled = (value == "1" || value == "true");
@@ -2879,6 +3059,7 @@ void App::LoadConfig() {
         else if (key == "simpleCol1Ratio") simpleCol1Ratio_ = std::clamp((float)std::atof(value.c_str()), 0.15f, 0.60f);
         else if (key == "simpleCol2Ratio") simpleCol2Ratio_ = std::clamp((float)std::atof(value.c_str()), 0.15f, 0.60f);
         else if (key == "schedCol1Ratio") schedCol1Ratio_ = std::clamp((float)std::atof(value.c_str()), 0.20f, 0.80f);
+        else if (key == "schedulerWorkers") schedulerWorkers_ = std::clamp(std::atoi(value.c_str()), 1, 64);
         // Window geometry
         else if (key == "windowX") savedWinX_ = std::atoi(value.c_str());
         else if (key == "windowY") savedWinY_ = std::atoi(value.c_str());
@@ -2890,8 +3071,13 @@ void App::LoadConfig() {
         else if (key == "logFileOutput") { logFileOutput_ = (value == "1"); }
         else if (key == "logFilePath") { logFilePath_ = value; }
         else if (key == "logMaxEntries") { logMaxEntries_ = std::atoi(value.c_str()); Logger::Instance().SetMaxEntries(logMaxEntries_); }
+        else if (key == "logFileFormat") { logFileFormat_ = std::clamp(std::atoi(value.c_str()), 0, 1); }
+        else if (key == "logMaxFileMB") { logMaxFileMB_ = std::max(std::atoi(value.c_str()), 0); }
+        else if (key == "logMaxFiles") { logMaxFiles_ = std::clamp(std::atoi(value.c_str()), 1, 100); }
     }
 
+    Logger::Instance().SetFileFormat((LogFileFormat)logFileFormat_);
+    Logger::Instance().SetFileRotation((int64_t)logMaxFileMB_ * 1024 * 1024, logMaxFiles_);
     if (logFileOutput_) Logger::Instance().SetFileOutput(true, logFilePath_);
     if (!schedulerData.empty()) scheduler_.Deserialize(schedulerData);
     LOG_INFO("App::LoadConfig", "Configuration loaded");
@@ -2910,14 +3096,20 @@ void App::SaveConfig() {
 
     out << "# Playback Settings\n";
     out << "blockInput=" << (blockInput_ ? "1" : "0") << "\n";
-    out << "speedFactor=" << speedFactor_ << "\n\n";
+    out << "speedFactor=" << speedFactor_ << "\n";
+    out << "streamRecording=" << (streamRecording_ ? "1" : "0") << "\n";
+    out << "moveFilterMode=" << moveFilterMode_ << "\n";
+    out << "moveFilterIntervalUs=" << moveFilterIntervalUs_ << "\n";
+    out << "moveFilterDistancePx=" << moveFilterDistancePx_ << "\n";
+    out << "moveFilterTolerancePx=" << moveFilterTolerancePx_ << "\n\n";
 
     out << "# File Paths\n";
     out << "trcPath=" << trcPath_ << "\n";
     out << "luaPath=" << luaPath_ << "\n\n";
 
     out << "# Export Settings\n";
-    out << "exportFull=" << (exportFull_ ? "1" : "0") << "\n\n";
+    out << "exportFull=" << (exportFull_ ? "1" : "0") << "\n";
+    out << "exportCompact=" << (exportCompact_ ? "1" : "0") << "\n\n";
 
     out << "# Script Settings\n";
     out << "minimizeOnScriptRun=" << (minimizeOnScriptRun_ ? "1" : "0") << "\n";
@@ -2940,7 +3132,13 @@ void App::SaveConfig() {
     out << "logLevel=" << logFilterLevel_ << "\n";
     out << "logFileOutput=" << (logFileOutput_ ? "1" : "0") << "\n";
     out << "logFilePath=" << logFilePath_ << "\n";
-    out << "logMaxEntries=" << logMaxEntries_ << "\n\n";
+    out << "logMaxEntries=" << logMaxEntries_ << "\n";
+    out << "logFileFormat=" << logFileFormat_ << "\n";
+    out << "logMaxFileMB=" << logMaxFileMB_ << "\n";
+    out << "logMaxFiles=" << logMaxFiles_ << "\n\n";
+
+    out << "# Scheduler\n";
+    out << "schedulerWorkers=" << schedulerWorkers_ << "\n\n";
 
     out << "# Scheduled Tasks\n";
     out << "[scheduler_tasks]\n";
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -14,6 +16,7 @@
 #include "core/Recorder.h"
 #include "core/Replayer.h"
 #include "core/Scheduler.h"
+#include "core/SyncEvent.h"
 
 struct LuaScriptUiState {
     bool docsOpen{ true };
@@ -61,9 +64,14 @@ private:
     // UI drawing
     void DrawBackground();
     void DrawSimpleMode();
+    // Makes eventRows_ cover recording indices [first, first + count).
+    void CacheEventRows(size_t first, size_t count);
     void DrawAdvancedMode();
     void DrawSchedulerMode();
     void DrawLogMode();
+    // Appends entries logged since the last call to logRows_ and drops the
+    // ones the logger no longer holds.
+    void SyncLogRows();
     void DrawStatusBar();
     void DrawBlockInputConfirmModal();
     void DrawExitConfirmModal();
@@ -71,7 +79,12 @@ private:
 
     // Scheduler
     void OnSchedulerTaskFired(const ScheduledTask& task);
-    void SchedulerExecuteTask(const ScheduledTask& task);
+    // UI thread: starts the runs executors handed over; called every frame.
+    void ProcessSchedulerRuns();
+    // Starts the task's replay or script; returns false if nothing started.
+    bool SchedulerExecuteTask(const ScheduledTask& task);
+    // Executor thread: waits for event, or returns false once the app shuts down.
+    bool WaitSchedulerEvent(const threading::Event& event) const;
 
     // Status helpers
     void SetStatusInfo(const std::string& text);
@@ -83,7 +96,7 @@ private:
     void StartRecording();
     void StopRecording();
     void StartReplay();
-    void StartReplayConfirmed();
+    bool StartReplayConfirmed();
     void StopReplay();
     void EmergencyStop();
 
@@ -117,8 +130,21 @@ private:
 
     int64_t recordStartQpc_{ 0 };
 
+    // Formatted rows of the event list around the visible range; only the
+    // rows on screen are copied out of the recorder each frame.
+    uint64_t eventRowsGeneration_{ ~0ull };
+    size_t eventRowsFirst_{ 0 };
+    std::vector<std::string> eventRows_;
+    std::vector<trc::RawEvent> eventRowScratch_;
+
     bool blockInput_{ false };
     float speedFactor_{ 1.0f };
+    bool streamRecording_{ true };   // spill recordings to a temp .trc while capturing
+    // Record-time MouseMove filter (see core/MoveFilter.h)
+    int moveFilterMode_{ 0 };
+    int moveFilterIntervalUs_{ 4000 };
+    int moveFilterDistancePx_{ 2 };
+    float moveFilterTolerancePx_{ 1.0f };
 
     int mode_{ 0 };
 
@@ -129,6 +155,7 @@ private:
     std::string luaLastError_;
 
     bool exportFull_{ true };
+    bool exportCompact_{ false };   // full export as play_events() packed data
 
     // Status text — modified from any thread (including Scheduler), so guarded.
     int statusLevel_{ 0 };
@@ -161,12 +188,23 @@ private:
 
     // Scheduler
     Scheduler scheduler_;
+    // A task run handed from an executor thread to the UI thread, which owns
+    // replayer_, lua_ and the rest of the App state.
+    struct SchedulerRun {
+        ScheduledTask task;
+        bool started{ false };
+        threading::Event handled;   // set by the UI thread once it tried to start it
+    };
+    std::mutex schedRunsMutex_;
+    std::deque<std::shared_ptr<SchedulerRun>> schedRuns_;
+    threading::Event schedShutdown_;   // releases executors waiting on the UI thread
 
     // Scheduler UI state
     ScheduledTask editTask_{};
     int schedSelectedTask_{ -1 };
     int schedDetailTab_{ 0 };       // 0=info, 1=history
     bool schedEditingExisting_{ false }; // true = editing selected task, false = new task
+    int schedulerWorkers_{ 4 };     // executor pool size (persisted)
     bool schedFormExpanded_{ true };     // top form collapsed/expanded
     int  schedDeleteConfirmId_{ -1 };    // task id pending delete confirmation
     std::string schedValidationMsg_;     // inline validation error message
@@ -182,6 +220,14 @@ private:
     bool logFileOutput_{ false };
     std::string logFilePath_{ "autoclicker.log" };
     int logMaxEntries_{ 10000 };
+    int logFileFormat_{ 0 };        // LogFileFormat: 0 = text, 1 = binary (decode with acp_logdump)
+    int logMaxFileMB_{ 16 };        // rotate the log file past this size; 0 = never
+    int logMaxFiles_{ 5 };          // files kept including the current one
+    // Incremental copy of the logger's ring, contiguous in seq, plus the seqs
+    // of the entries at or above each level for the level filter.
+    std::deque<LogEntry> logRows_;
+    std::deque<uint64_t> logByLevel_[5];
+    uint64_t logSeenSeq_{ 0 };
 
 public:
     // Screen rect of the scrollable editor area (set each frame by DrawLuaEditorWithLineNumbers)
@@ -1,96 +1,86 @@
 #include "core/Converter.h"
 
 #include <algorithm>
-#include <cmath>
+#include <charconv>
+#include <concepts>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
-#include <set>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include <windows.h>
 
-#include "core/Recorder.h"
+#include "core/PathSimplify.h"
+#include "core/TrcCodec.h"
 #include "core/TrcFormat.h"
+#include "core/TrcIO.h"
 
-struct PathPoint {
-    int x;
-    int y;
-    int64_t tMicros;
-};
+namespace {
 
-static double PerpDistance(const PathPoint& p, const PathPoint& a, const PathPoint& b) {
-    const double x = static_cast<double>(p.x);
-    const double y = static_cast<double>(p.y);
-    const double x1 = static_cast<double>(a.x);
-    const double y1 = static_cast<double>(a.y);
-    const double x2 = static_cast<double>(b.x);
-    const double y2 = static_cast<double>(b.y);
-    const double dx = x2 - x1;
-    const double dy = y2 - y1;
-    const double denom = std::sqrt(dx * dx + dy * dy);
-    if (denom < 1e-6) {
-        const double ex = x - x1;
-        const double ey = y - y1;
-        return std::sqrt(ex * ex + ey * ey);
-    }
-    const double num = std::abs(dy * x - dx * y + x2 * y1 - y2 * x1);
-    return num / denom;
-}
+// Lua text is formatted with std::to_chars (no locale, no per-token stream
+// calls) into a large buffer that goes to the file in big writes.
+class LuaBuffer {
+public:
+    explicit LuaBuffer(std::ofstream& out) : out_(out), buf_(kCapacity) {}
 
-static void RdpRecursive(const std::vector<PathPoint>& pts, int start, int end, double eps, std::set<int>& keep) {
-    if (end <= start + 1) return;
-    double maxD = 0.0;
-    int idx = -1;
-    for (int i = start + 1; i < end; ++i) {
-        const double d = PerpDistance(pts[i], pts[start], pts[end]);
-        if (d > maxD) {
-            maxD = d;
-            idx = i;
-        }
+    template <typename... Parts>
+    void Line(const Parts&... parts) {
+        if (kCapacity - size_ < kMaxLine) Flush();
+        (Put(parts), ...);
+        buf_[size_++] = '\n';
     }
-    if (idx >= 0 && maxD > eps) {
-        keep.insert(idx);
-        RdpRecursive(pts, start, idx, eps, keep);
-        RdpRecursive(pts, idx, end, eps, keep);
+
+    // Appends text of any length as is.
+    void Text(std::string_view text) {
+        if (kCapacity - size_ < text.size()) Flush();
+        if (text.size() > kCapacity) {
+            out_.write(text.data(), static_cast<std::streamsize>(text.size()));
+            return;
+        }
+        Put(text);
     }
-}
 
-static std::vector<int> OptimizePath(const std::vector<PathPoint>& pts, double eps) {
-    if (pts.size() <= 2) {
-        std::vector<int> out;
-        for (int i = 0; i < static_cast<int>(pts.size()); ++i) out.push_back(i);
-        return out;
+    bool Finish() {
+        Flush();
+        return out_.good();
     }
-    std::set<int> keep;
-    keep.insert(0);
-    keep.insert(static_cast<int>(pts.size() - 1));
-    RdpRecursive(pts, 0, static_cast<int>(pts.size() - 1), eps, keep);
 
-    std::vector<int> idx(keep.begin(), keep.end());
-    std::sort(idx.begin(), idx.end());
-    return idx;
-}
+private:
+    static constexpr size_t kCapacity = 1 << 20;
+    static constexpr size_t kMaxLine = 128;   // longer than any line below
 
-static void WriteWaitUs(std::ofstream& out, int64_t* carryMicros, int64_t dtMicros) {
-    dtMicros = std::max<int64_t>(0, dtMicros);
-    const int64_t total = dtMicros + (carryMicros ? *carryMicros : 0);
-    const int64_t us = total;
-    if (carryMicros) *carryMicros = 0;
-    if (us > 0) out << "wait_us(" << us << ")\n";
-}
+    void Put(std::string_view text) {
+        std::memcpy(buf_.data() + size_, text.data(), text.size());
+        size_ += text.size();
+    }
+    template <std::integral T>
+    void Put(T value) {
+        size_ = static_cast<size_t>(std::to_chars(buf_.data() + size_, buf_.data() + kCapacity, value).ptr - buf_.data());
+    }
+    void Flush() {
+        out_.write(buf_.data(), static_cast<std::streamsize>(size_));
+        size_ = 0;
+    }
 
-static void WriteEvent(std::ofstream& out, const trc::RawEvent& e) {
+    std::ofstream& out_;
+    std::vector<char> buf_;
+    size_t size_{ 0 };
+};
+
+void WriteEvent(LuaBuffer& lua, const trc::RawEvent& e) {
     const auto type = static_cast<trc::EventType>(e.type);
     if (type == trc::EventType::MouseMove) {
-        out << "mouse_move(" << e.x << "," << e.y << ")\n";
+        lua.Line("mouse_move(", e.x, ",", e.y, ")");
         return;
     }
     if (type == trc::EventType::MouseDown) {
-        out << "mouse_down(" << e.data << "," << e.x << "," << e.y << ")\n";
+        lua.Line("mouse_down(", e.data, ",", e.x, ",", e.y, ")");
         return;
     }
     if (type == trc::EventType::MouseUp) {
-        out << "mouse_up(" << e.data << "," << e.x << "," << e.y << ")\n";
+        lua.Line("mouse_up(", e.data, ",", e.x, ",", e.y, ")");
         return;
     }
     if (type == trc::EventType::Wheel) {
@@ -98,73 +88,119 @@ static void WriteEvent(std::ofstream& out, const trc::RawEvent& e) {
         if ((static_cast<uint32_t>(e.data) & 0xFFFF0000u) == 0xFFFF0000u) horizontal = false;
         const int16_t delta16 = static_cast<int16_t>(e.data & 0xFFFF);
         const int delta = static_cast<int>(delta16);
-        out << "mouse_wheel(" << delta << "," << e.x << "," << e.y << "," << (horizontal ? 1 : 0) << ")\n";
+        lua.Line("mouse_wheel(", delta, ",", e.x, ",", e.y, horizontal ? ",1)" : ",0)");
         return;
     }
     if (type == trc::EventType::KeyDown) {
         const bool ext = (e.data & LLKHF_EXTENDED) != 0;
-        out << "vk_down(" << e.x << "," << (ext ? 1 : 0) << ")\n";
+        lua.Line("vk_down(", e.x, ext ? ",1)" : ",0)");
         return;
     }
     if (type == trc::EventType::KeyUp) {
         const bool ext = (e.data & LLKHF_EXTENDED) != 0;
-        out << "vk_up(" << e.x << "," << (ext ? 1 : 0) << ")\n";
+        lua.Line("vk_up(", e.x, ext ? ",1)" : ",0)");
         return;
     }
 }
 
+} // namespace
+
 bool Converter::TrcToLua(const std::wstring& trcFile, const std::wstring& luaFile, double tolerancePx) {
-    Recorder rec;
-    if (!rec.LoadFromFile(trcFile)) return false;
+    trc::TrcBlockReader reader;
+    if (!reader.Open(trcFile)) return false;
 
-    const auto allEvents = rec.EventsCopy();
-    std::vector<PathPoint> points;
-    points.reserve(allEvents.size());
+    CursorPath path;
+    std::vector<size_t> segmentStarts;
 
     int64_t t = 0;
-    for (const auto& e : allEvents) {
-        t += e.timeDelta;
-        if (static_cast<trc::EventType>(e.type) == trc::EventType::MouseMove) {
-            points.push_back(PathPoint{ e.x, e.y, t });
+    bool split = false;
+    std::vector<trc::RawEvent> block;
+    while (reader.Next(block)) {
+        for (const auto& e : block) {
+            t += e.timeDelta;
+            if (static_cast<trc::EventType>(e.type) != trc::EventType::MouseMove) {
+                split = true;
+                continue;
+            }
+            if (path.Size() > 0 && (split || t - path.tMicros.back() >= kSegmentPauseMicros)) {
+                segmentStarts.push_back(path.Size());
+            }
+            split = false;
+            path.Push(e.x, e.y, t);
         }
     }
+    if (reader.Failed()) return false;
 
-    std::vector<int> keyIdx = OptimizePath(points, std::clamp(tolerancePx, 0.5, 20.0));
+    std::vector<uint8_t> keep;
+    SimplifyRdpSegments(path.x, path.y, segmentStarts, std::clamp(tolerancePx, 0.5, 20.0), keep);
 
     std::ofstream out(std::filesystem::path(luaFile), std::ios::binary);
     if (!out) return false;
-
-    out << "set_speed(1.0)\n";
-    if (!points.empty()) {
-        const auto& p0 = points[keyIdx.front()];
-        out << "human_move(" << p0.x << "," << p0.y << ",1.0)\n";
-        for (size_t i = 1; i < keyIdx.size(); ++i) {
-            const auto& p = points[keyIdx[i]];
-            const auto& prev = points[keyIdx[i - 1]];
-            const int64_t dt = p.tMicros - prev.tMicros;
+    LuaBuffer lua(out);
+
+    lua.Line("set_speed(1.0)");
+    if (path.Size() > 0) {
+        lua.Line("human_move(", path.x[0], ",", path.y[0], ",1.0)");
+        size_t prevIdx = 0;
+        for (size_t i = 1; i < path.Size(); ++i) {
+            if (!keep[i]) continue;
+            const int64_t dt = path.tMicros[i] - path.tMicros[prevIdx];
+            prevIdx = i;
             const int64_t ms = std::max<int64_t>(0, dt / 1000);
-            out << "human_move(" << p.x << "," << p.y << ",1.0)\n";
-            if (ms > 0) out << "wait_ms(" << ms << ")\n";
+            lua.Line("human_move(", path.x[i], ",", path.y[i], ",1.0)");
+            if (ms > 0) lua.Line("wait_ms(", ms, ")");
         }
     }
 
-    return out.good();
+    return lua.Finish();
 }
 
 bool Converter::TrcToLuaFull(const std::wstring& trcFile, const std::wstring& luaFile) {
-    Recorder rec;
-    if (!rec.LoadFromFile(trcFile)) return false;
+    trc::TrcBlockReader reader;
+    if (!reader.Open(trcFile)) return false;
 
     std::ofstream out(std::filesystem::path(luaFile), std::ios::binary);
     if (!out) return false;
+    LuaBuffer lua(out);
+
+    lua.Line("set_speed(1.0)");
+    std::vector<trc::RawEvent> block;
+    while (reader.Next(block)) {
+        for (const auto& e : block) {
+            if (e.timeDelta > 0) lua.Line("wait_us(", e.timeDelta, ")");
+            WriteEvent(lua, e);
+        }
+    }
+
+    return lua.Finish() && !reader.Failed();
+}
 
-    out << "set_speed(1.0)\n";
+bool Converter::TrcToLuaCompact(const std::wstring& trcFile, const std::wstring& luaFile) {
+    trc::TrcBlockReader reader;
+    if (!reader.Open(trcFile)) return false;
 
-    int64_t carryMicros = 0;
-    for (const auto& e : rec.EventsCopy()) {
-        WriteWaitUs(out, &carryMicros, e.timeDelta);
-        WriteEvent(out, e);
+    std::ofstream out(std::filesystem::path(luaFile), std::ios::binary);
+    if (!out) return false;
+    LuaBuffer lua(out);
+
+    lua.Line("set_speed(1.0)");
+    lua.Line("-- ", reader.Header().totalEvents, " recorded events, packed for play_events()");
+    std::vector<trc::RawEvent> chunk;
+    std::vector<trc::RawEvent> block;
+    std::string packed;
+    auto emit = [&] {
+        packed.clear();
+        trc::PackEventsText(chunk, packed);
+        lua.Line("play_events([[");
+        lua.Text(packed);
+        lua.Line("]])");
+        chunk.clear();
+    };
+    while (reader.Next(block)) {
+        chunk.insert(chunk.end(), block.begin(), block.end());
+        if (chunk.size() >= kCompactChunkEvents) emit();
     }
+    if (!chunk.empty()) emit();
 
-    return out.good();
+    return lua.Finish() && !reader.Failed();
 }
@@ -1,9 +1,22 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 class Converter {
 public:
+    // Cursor path only, simplified with RDP. Clicks, key and wheel events and
+    // pauses of at least kSegmentPauseMicros split the path into segments that
+    // are simplified independently (in parallel) and always keep their ends.
     static bool TrcToLua(const std::wstring& trcFile, const std::wstring& luaFile, double tolerancePx);
+    static constexpr int64_t kSegmentPauseMicros = 250'000;
+    // Every event, streamed from the .trc one block at a time, so memory use
+    // does not grow with the length of the recording.
     static bool TrcToLuaFull(const std::wstring& trcFile, const std::wstring& luaFile);
+    // Every event as packed data (trc::PackEventsText) in play_events() calls
+    // of kCompactChunkEvents events each: the script stays small, loads fast
+    // and replays through the Replayer instead of one Lua call per event.
+    static bool TrcToLuaCompact(const std::wstring& trcFile, const std::wstring& luaFile);
+    static constexpr size_t kCompactChunkEvents = 65536;
 };
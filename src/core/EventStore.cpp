@@ -0,0 +1,120 @@
+#include "core/EventStore.h"
+
+#include <cstring>
+#include <mutex>
+
+// Recycles chunk memory between recordings. Chunks come back when the last
+// store or snapshot referencing them lets go, possibly on another thread.
+class EventStore::ChunkPool {
+public:
+    ~ChunkPool() {
+        for (Chunk* c : free_) delete c;
+    }
+
+    Chunk* Acquire() {
+        {
+            std::scoped_lock lock(mutex_);
+            if (!free_.empty()) {
+                Chunk* c = free_.back();
+                free_.pop_back();
+                return c;
+            }
+        }
+        return new Chunk;
+    }
+
+    void Release(Chunk* c) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (free_.size() < kMaxFree) {
+                free_.push_back(c);
+                return;
+            }
+        }
+        delete c;
+    }
+
+private:
+    static constexpr size_t kMaxFree = 64;   // ~5.5 MB of RawEvents kept warm
+
+    std::mutex mutex_;
+    std::vector<Chunk*> free_;
+};
+
+namespace {
+
+template <typename Chunks>
+void CopyChunkRange(const Chunks& chunks, size_t size, size_t first, size_t count, std::vector<trc::RawEvent>& out) {
+    constexpr size_t kChunkEvents = EventStore::kChunkEvents;
+    if (first >= size) return;
+    count = std::min(count, size - first);
+    out.reserve(out.size() + count);
+    while (count > 0) {
+        const auto& chunk = chunks[first / kChunkEvents];
+        const size_t offset = first % kChunkEvents;
+        const size_t n = std::min(kChunkEvents - offset, count);
+        out.insert(out.end(), chunk->events + offset, chunk->events + offset + n);
+        first += n;
+        count -= n;
+    }
+}
+
+} // namespace
+
+void EventStore::Snapshot::CopyRange(size_t first, size_t count, std::vector<trc::RawEvent>& out) const {
+    CopyChunkRange(chunks_, size_, first, count, out);
+}
+
+std::vector<trc::RawEvent> EventStore::Snapshot::ToVector() const {
+    std::vector<trc::RawEvent> out;
+    CopyRange(0, size_, out);
+    return out;
+}
+
+EventStore::EventStore() : pool_(std::make_shared<ChunkPool>()) {}
+
+std::shared_ptr<EventStore::Chunk> EventStore::NewChunk() {
+    auto pool = pool_;
+    return std::shared_ptr<Chunk>(pool->Acquire(), [pool](Chunk* c) { pool->Release(c); });
+}
+
+void EventStore::Append(std::span<const trc::RawEvent> events) {
+    while (!events.empty()) {
+        if (tailFill_ == kChunkEvents) {
+            chunks_.push_back(NewChunk());
+            tailFill_ = 0;
+        }
+        const size_t n = std::min(kChunkEvents - tailFill_, events.size());
+        std::memcpy(chunks_.back()->events + tailFill_, events.data(), n * sizeof(trc::RawEvent));
+        tailFill_ += n;
+        size_ += n;
+        events = events.subspan(n);
+    }
+}
+
+void EventStore::Clear() {
+    chunks_.clear();
+    tailFill_ = kChunkEvents;
+    size_ = 0;
+    firstIndex_ = 0;
+}
+
+void EventStore::TrimFront(size_t keep) {
+    while (chunks_.size() > 1 && size_ - kChunkEvents >= keep) {
+        chunks_.pop_front();
+        size_ -= kChunkEvents;
+        firstIndex_ += kChunkEvents;
+    }
+}
+
+void EventStore::CopyRange(size_t first, size_t count, std::vector<trc::RawEvent>& out) const {
+    CopyChunkRange(chunks_, size_, first, count, out);
+}
+
+EventStore::Snapshot EventStore::TakeSnapshot() const {
+    Snapshot snap;
+    snap.chunks_.assign(chunks_.begin(), chunks_.end());
+    snap.size_ = size_;
+    snap.firstIndex_ = firstIndex_;
+    return snap;
+}
@@ -0,0 +1,87 @@
+#pragma once
+// EventStore.h — append-only event storage in fixed-size chunks.
+// Appending never moves existing events, so the cost of an append is
+// proportional to the batch, not to the history. Snapshots share the chunks
+// (reference counted) and stay valid after the store moves on or is cleared.
+// The store itself is not synchronized; the owner guards it with its lock and
+// reads snapshots outside of it.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "core/TrcFormat.h"
+
+class EventStore {
+public:
+    static constexpr size_t kChunkEvents = 4096;
+
+    struct Chunk {
+        trc::RawEvent events[kChunkEvents];
+    };
+
+    // Immutable view over the first Size() events at the time it was taken.
+    class Snapshot {
+    public:
+        size_t Size() const { return size_; }
+        bool Empty() const { return size_ == 0; }
+        // Recording index of the first event (non-zero once the store dropped
+        // older chunks via TrimFront()).
+        size_t FirstIndex() const { return firstIndex_; }
+
+        const trc::RawEvent& operator[](size_t i) const {
+            return chunks_[i / kChunkEvents]->events[i % kChunkEvents];
+        }
+
+        // Calls fn(std::span<const trc::RawEvent>) for each contiguous run, in order.
+        template <typename Fn>
+        void ForEachSpan(Fn&& fn) const {
+            size_t remaining = size_;
+            for (const auto& chunk : chunks_) {
+                if (remaining == 0) break;
+                const size_t n = std::min(kChunkEvents, remaining);
+                fn(std::span<const trc::RawEvent>(chunk->events, n));
+                remaining -= n;
+            }
+        }
+
+        // Appends events [first, first + count) (clamped to Size()) to out.
+        void CopyRange(size_t first, size_t count, std::vector<trc::RawEvent>& out) const;
+        std::vector<trc::RawEvent> ToVector() const;
+
+    private:
+        friend class EventStore;
+        std::vector<std::shared_ptr<const Chunk>> chunks_;
+        size_t size_{ 0 };
+        size_t firstIndex_{ 0 };
+    };
+
+    EventStore();
+
+    void Append(std::span<const trc::RawEvent> events);
+    void Clear();
+    // Drops whole chunks from the front while at least keep events remain.
+    void TrimFront(size_t keep);
+
+    size_t Size() const { return size_; }
+    size_t FirstIndex() const { return firstIndex_; }
+    Snapshot TakeSnapshot() const;
+    // Same as Snapshot::CopyRange, for small reads under the owner's lock
+    // without taking a reference on every chunk.
+    void CopyRange(size_t first, size_t count, std::vector<trc::RawEvent>& out) const;
+
+private:
+    class ChunkPool;
+
+    std::shared_ptr<Chunk> NewChunk();
+
+    std::shared_ptr<ChunkPool> pool_;
+    std::deque<std::shared_ptr<Chunk>> chunks_;
+    size_t tailFill_{ kChunkEvents };   // events used in chunks_.back()
+    size_t size_{ 0 };
+    size_t firstIndex_{ 0 };
+};
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <cstdint>
+#include <thread>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <time.h>
+#endif
 
 namespace timing {
 
+#ifdef _WIN32
 inline int64_t QpcFrequency() {
     static int64_t freq = [] {
         LARGE_INTEGER f{};
@@ -19,14 +25,46 @@ inline int64_t QpcNow() {
     QueryPerformanceCounter(&v);
     return static_cast<int64_t>(v.QuadPart);
 }
+#else
+// CLOCK_MONOTONIC in nanoseconds stands in for the performance counter.
+inline int64_t QpcFrequency() {
+    return 1'000'000'000LL;
+}
+
+inline int64_t QpcNow() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000LL + ts.tv_nsec;
+}
+#endif
 
 inline int64_t QpcDeltaToMicros(int64_t qpcDelta) {
     const int64_t freq = QpcFrequency();
-    return (qpcDelta * 1'000'000LL) / freq;
+    // Split so absolute counter values (days of uptime) don't overflow.
+    return (qpcDelta / freq) * 1'000'000LL + ((qpcDelta % freq) * 1'000'000LL) / freq;
 }
 
 inline int64_t MicrosNow() {
     return QpcDeltaToMicros(QpcNow());
 }
 
+// First counter value at which MicrosNow() >= micros; lets spin loops compare
+// raw counter values instead of converting on every iteration.
+inline int64_t MicrosToQpcCeil(int64_t micros) {
+    const int64_t freq = QpcFrequency();
+    return (micros / 1'000'000LL) * freq + ((micros % 1'000'000LL) * freq + 999'999LL) / 1'000'000LL;
+}
+
+// Spin-loop hint (PAUSE on x86) so a busy wait yields pipeline resources to
+// the sibling hyperthread.
+inline void CpuRelax() {
+#ifdef _WIN32
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
 } // namespace timing
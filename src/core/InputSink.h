@@ -0,0 +1,33 @@
+#pragma once
+// InputSink.h — injection backend used by Replayer.
+// The replayer hands over every event that is due at the same instant as one
+// batch of INPUTs, preceded by at most one focus request, so a dense burst
+// costs a single SendInput call. Tests substitute a recording sink.
+
+#include <cstddef>
+#include <span>
+#include <windows.h>
+
+#include "core/InputUtils.h"
+
+class InputSink {
+public:
+    virtual ~InputSink() = default;
+
+    // Activates the window under (x, y) before the next batch is sent.
+    virtual void FocusAt(int x, int y) = 0;
+    // Injects inputs in order; returns how many were accepted.
+    virtual size_t Send(std::span<INPUT> inputs) = 0;
+};
+
+class SendInputSink final : public InputSink {
+public:
+    void FocusAt(int x, int y) override {
+        input::FocusWindowAt(x, y);
+    }
+
+    size_t Send(std::span<INPUT> inputs) override {
+        if (inputs.empty()) return 0;
+        return SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
+    }
+};
@@ -3,6 +3,7 @@
 // Extracted to eliminate code duplication across those translation units.
 
 #include <algorithm>
+#include <cstdint>
 #include <windows.h>
 
 namespace input {
@@ -32,6 +33,35 @@ inline void SendMouseMoveAbs(int x, int y) {
     SendInput(1, &in, sizeof(in));
 }
 
+// Virtual desktop bounds, queried once per batch rather than per input.
+struct VirtualScreen {
+    int x{ 0 };
+    int y{ 0 };
+    int width{ 0 };
+    int height{ 0 };
+};
+
+inline VirtualScreen QueryVirtualScreen() {
+    return { GetSystemMetrics(SM_XVIRTUALSCREEN), GetSystemMetrics(SM_YVIRTUALSCREEN),
+        GetSystemMetrics(SM_CXVIRTUALSCREEN), GetSystemMetrics(SM_CYVIRTUALSCREEN) };
+}
+
+// Absolute move that lands exactly on pixel (x, y): Windows maps dx to
+// dx * width / 65536, so round the inverse up.
+inline INPUT MakeAbsoluteMove(const VirtualScreen& screen, int x, int y) {
+    auto axis = [](int v, int origin, int extent) -> LONG {
+        if (extent <= 1) return 0;
+        const int64_t p = std::clamp<int64_t>(static_cast<int64_t>(v) - origin, 0, extent - 1);
+        return static_cast<LONG>(std::min<int64_t>((p * 65536 + extent - 1) / extent, 65535));
+    };
+    INPUT in{};
+    in.type = INPUT_MOUSE;
+    in.mi.dx = axis(x, screen.x, screen.width);
+    in.mi.dy = axis(y, screen.y, screen.height);
+    in.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    return in;
+}
+
 inline void MoveCursorBestEffort(int x, int y) {
     if (SetCursorPos(x, y) != FALSE) return;
     SendMouseMoveAbs(x, y);
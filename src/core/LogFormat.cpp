@@ -0,0 +1,695 @@
+#include "core/LogFormat.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+
+namespace logfmt {
+
+namespace {
+
+// One printf conversion: %[flags][width][.precision][length]conv
+struct PrintfSpec {
+    std::string_view flags;
+    std::string_view width;       // digits, "*" or empty
+    std::string_view precision;   // ".digits", ".*", "." or empty
+    std::string_view length;
+    char conv{ 0 };
+};
+
+// Parses the conversion starting after '%'; returns the position after it, or
+// nullptr if the format is malformed.
+const char* ParsePrintfSpec(const char* p, const char* end, PrintfSpec& spec) {
+    const char* start = p;
+    while (p < end && std::strchr("-+ #0", *p)) ++p;
+    spec.flags = std::string_view(start, static_cast<size_t>(p - start));
+
+    start = p;
+    if (p < end && *p == '*') ++p;
+    else while (p < end && *p >= '0' && *p <= '9') ++p;
+    spec.width = std::string_view(start, static_cast<size_t>(p - start));
+
+    start = p;
+    if (p < end && *p == '.') {
+        ++p;
+        if (p < end && *p == '*') ++p;
+        else while (p < end && *p >= '0' && *p <= '9') ++p;
+    }
+    spec.precision = std::string_view(start, static_cast<size_t>(p - start));
+
+    start = p;
+    if (end - p >= 3 && std::string_view(p, 3) == "I64") p += 3;
+    else if (end - p >= 3 && std::string_view(p, 3) == "I32") p += 3;
+    else while (p < end && std::strchr("hlLqjztwI", *p)) ++p;
+    spec.length = std::string_view(start, static_cast<size_t>(p - start));
+
+    if (p >= end) return nullptr;
+    spec.conv = *p++;
+    return p;
+}
+
+enum class IntSize { Int, Long, LongLong, Size, IntMax, PtrDiff };
+
+bool IntSizeOf(std::string_view length, IntSize& size) {
+    if (length.empty() || length == "h" || length == "hh" || length == "I32") size = IntSize::Int;
+    else if (length == "l") size = IntSize::Long;
+    else if (length == "ll" || length == "q" || length == "I64") size = IntSize::LongLong;
+    else if (length == "z") size = IntSize::Size;
+    else if (length == "j") size = IntSize::IntMax;
+    else if (length == "t" || length == "I") size = IntSize::PtrDiff;
+    else return false;
+    return true;
+}
+
+// Stands in for a missing or mismatched argument.
+constexpr std::string_view kBadArg = "<?>";
+
+template <typename... T>
+void AppendPrintf(std::string& out, const char* spec, T... values) {
+    char buf[256];
+    const int n = std::snprintf(buf, sizeof(buf), spec, values...);
+    if (n < 0) return;
+    if (static_cast<size_t>(n) < sizeof(buf)) {
+        out.append(buf, static_cast<size_t>(n));
+        return;
+    }
+    const size_t at = out.size();
+    out.resize(at + static_cast<size_t>(n) + 1);
+    std::snprintf(out.data() + at, static_cast<size_t>(n) + 1, spec, values...);
+    out.resize(at + static_cast<size_t>(n));
+}
+
+// Calls AppendPrintf with the star arguments in front of value.
+template <typename T>
+void AppendWithStars(std::string& out, const std::string& spec, const int* stars, int starCount, T value) {
+    switch (starCount) {
+    case 0: AppendPrintf(out, spec.c_str(), value); break;
+    case 1: AppendPrintf(out, spec.c_str(), stars[0], value); break;
+    default: AppendPrintf(out, spec.c_str(), stars[0], stars[1], value); break;
+    }
+}
+
+void AppendVarint(std::string& out, uint64_t v) {
+    char buf[10];
+    out.append(buf, static_cast<size_t>(PutVarint(buf, v) - buf));
+}
+
+// ─── std::format replacement fields ──────────────────────────────────────────
+
+struct BraceSpec {
+    char fill{ ' ' };
+    char align{ 0 };     // '<', '>', '^' or 0 for the type's default
+    char sign{ 0 };
+    bool alt{ false };
+    bool zero{ false };
+    int width{ 0 };
+    int precision{ -1 };
+    char type{ 0 };
+};
+
+bool IsAlign(char c) { return c == '<' || c == '>' || c == '^'; }
+
+int ParseInt(std::string_view& s) {
+    int v = 0;
+    while (!s.empty() && s.front() >= '0' && s.front() <= '9') {
+        v = v * 10 + (s.front() - '0');
+        s.remove_prefix(1);
+    }
+    return v;
+}
+
+BraceSpec ParseBraceSpec(std::string_view s) {
+    BraceSpec spec;
+    if (s.size() >= 2 && IsAlign(s[1])) {
+        spec.fill = s[0];
+        spec.align = s[1];
+        s.remove_prefix(2);
+    } else if (!s.empty() && IsAlign(s[0])) {
+        spec.align = s[0];
+        s.remove_prefix(1);
+    }
+    if (!s.empty() && (s[0] == '+' || s[0] == '-' || s[0] == ' ')) {
+        spec.sign = s[0];
+        s.remove_prefix(1);
+    }
+    if (!s.empty() && s[0] == '#') {
+        spec.alt = true;
+        s.remove_prefix(1);
+    }
+    if (!s.empty() && s[0] == '0') {
+        spec.zero = true;
+        s.remove_prefix(1);
+    }
+    spec.width = ParseInt(s);
+    if (!s.empty() && s[0] == '.') {
+        s.remove_prefix(1);
+        spec.precision = ParseInt(s);
+    }
+    if (!s.empty()) spec.type = s[0];
+    return spec;
+}
+
+// Formats one value as std::format would (without width/fill, which the
+// caller applies). Returns false for text values so padding defaults left.
+bool FormatBraceValue(std::string& out, const ArgValue& v, const BraceSpec& spec) {
+    std::string flags = "%";
+    if (spec.sign == '+' || spec.sign == ' ') flags += spec.sign;
+    if (spec.alt) flags += '#';
+    const char type = spec.type;
+
+    auto integer = [&](bool isSigned) {
+        if (type == 'c') {
+            out += static_cast<char>(isSigned ? v.i : static_cast<int64_t>(v.u));
+            return;
+        }
+        if (type == 'b' || type == 'B') {
+            uint64_t u = isSigned ? static_cast<uint64_t>(v.i < 0 ? -v.i : v.i) : v.u;
+            if (isSigned && v.i < 0) out += '-';
+            else if (spec.sign == '+' || spec.sign == ' ') out += spec.sign;
+            if (spec.alt) out += type == 'b' ? "0b" : "0B";
+            char bits[64];
+            int n = 0;
+            do { bits[n++] = static_cast<char>('0' + (u & 1)); u >>= 1; } while (u);
+            while (n) out += bits[--n];
+            return;
+        }
+        const char conv = (type == 'x' || type == 'X' || type == 'o') ? type : (isSigned ? 'd' : 'u');
+        const std::string f = flags + "ll" + conv;
+        if (conv == 'd') AppendPrintf(out, f.c_str(), static_cast<long long>(v.i));
+        else AppendPrintf(out, f.c_str(), isSigned ? static_cast<unsigned long long>(v.i) : static_cast<unsigned long long>(v.u));
+    };
+
+    switch (v.tag) {
+    case ArgTag::Int: integer(true); return true;
+    case ArgTag::UInt: integer(false); return true;
+    case ArgTag::Char:
+        if (type == 'd' || type == 'x' || type == 'X' || type == 'o' || type == 'b') { integer(false); return true; }
+        out += static_cast<char>(v.u);
+        return false;
+    case ArgTag::Bool:
+        if (type && type != 's') { integer(false); return true; }
+        out += v.u ? "true" : "false";
+        return false;
+    case ArgTag::Ptr:
+        AppendPrintf(out, "0x%llx", static_cast<unsigned long long>(v.u));
+        return true;
+    case ArgTag::Float: {
+        if (!type && spec.precision < 0) {
+            if (spec.sign == '+' && v.f >= 0) out += '+';
+            else if (spec.sign == ' ' && v.f >= 0) out += ' ';
+            char buf[64];
+            const auto r = std::to_chars(buf, buf + sizeof(buf), v.f);
+            out.append(buf, r.ptr);
+            return true;
+        }
+        std::string f = flags;
+        if (spec.precision >= 0) f += "." + std::to_string(spec.precision);
+        f += type ? type : 'g';
+        AppendPrintf(out, f.c_str(), v.f);
+        return true;
+    }
+    case ArgTag::Str:
+        out.append(spec.precision >= 0 ? v.s.substr(0, static_cast<size_t>(spec.precision)) : v.s);
+        return false;
+    }
+    return false;
+}
+
+} // namespace
+
+bool GetVarint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        const uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool NextArg(const char*& p, const char* end, ArgValue& out) {
+    if (p >= end) return false;
+    out.tag = static_cast<ArgTag>(*p++);
+    uint64_t v = 0;
+    switch (out.tag) {
+    case ArgTag::Int:
+        if (!GetVarint(p, end, v)) return false;
+        out.i = UnZigZag(v);
+        return true;
+    case ArgTag::UInt:
+    case ArgTag::Ptr:
+    case ArgTag::Bool:
+    case ArgTag::Char:
+        return GetVarint(p, end, out.u);
+    case ArgTag::Float:
+        if (end - p < static_cast<ptrdiff_t>(sizeof(double))) return false;
+        std::memcpy(&out.f, p, sizeof(double));
+        p += sizeof(double);
+        return true;
+    case ArgTag::Str:
+        if (!GetVarint(p, end, v) || v > static_cast<uint64_t>(end - p)) return false;
+        out.s = std::string_view(p, static_cast<size_t>(v));
+        p += v;
+        return true;
+    }
+    return false;
+}
+
+bool CapturePrintfArgs(const char* fmt, va_list args, char* out, size_t capacity, size_t& used) {
+    char* w = out;
+    char* const wend = out + capacity;
+    auto room = [&](size_t n) { return static_cast<size_t>(wend - w) >= n; };
+
+    const char* p = fmt;
+    const char* end = fmt + std::strlen(fmt);
+    while (p < end) {
+        if (*p++ != '%') continue;
+        if (p < end && *p == '%') {
+            ++p;
+            continue;
+        }
+        PrintfSpec spec;
+        p = ParsePrintfSpec(p, end, spec);
+        if (!p) return false;
+
+        int precision = -1;
+        if (spec.width == "*") {
+            if (!room(kMaxScalarBytes)) return false;
+            w = PutInt(w, va_arg(args, int));
+        }
+        if (spec.precision == ".*") {
+            if (!room(kMaxScalarBytes)) return false;
+            precision = va_arg(args, int);
+            w = PutInt(w, precision);
+        } else if (spec.precision.size() > 1) {
+            precision = std::atoi(spec.precision.data() + 1);
+        } else if (spec.precision == ".") {
+            precision = 0;
+        }
+
+        IntSize size = IntSize::Int;
+        switch (spec.conv) {
+        case 'd': case 'i': {
+            if (!IntSizeOf(spec.length, size) || !room(kMaxScalarBytes)) return false;
+            int64_t v = 0;
+            switch (size) {
+            case IntSize::Int:      v = va_arg(args, int); break;
+            case IntSize::Long:     v = va_arg(args, long); break;
+            case IntSize::LongLong: v = va_arg(args, long long); break;
+            case IntSize::Size:     v = static_cast<int64_t>(static_cast<ptrdiff_t>(va_arg(args, size_t))); break;
+            case IntSize::IntMax:   v = va_arg(args, intmax_t); break;
+            case IntSize::PtrDiff:  v = va_arg(args, ptrdiff_t); break;
+            }
+            // hh/h print the truncated value.
+            if (spec.length == "hh") v = static_cast<signed char>(v);
+            else if (spec.length == "h") v = static_cast<short>(v);
+            w = PutInt(w, v);
+            break;
+        }
+        case 'u': case 'o': case 'x': case 'X': {
+            if (!IntSizeOf(spec.length, size) || !room(kMaxScalarBytes)) return false;
+            uint64_t v = 0;
+            switch (size) {
+            case IntSize::Int:      v = va_arg(args, unsigned int); break;
+            case IntSize::Long:     v = va_arg(args, unsigned long); break;
+            case IntSize::LongLong: v = va_arg(args, unsigned long long); break;
+            case IntSize::Size:     v = va_arg(args, size_t); break;
+            case IntSize::IntMax:   v = va_arg(args, uintmax_t); break;
+            case IntSize::PtrDiff:  v = static_cast<uint64_t>(va_arg(args, ptrdiff_t)); break;
+            }
+            // hh/h print the truncated value.
+            if (spec.length == "hh") v = static_cast<unsigned char>(v);
+            else if (spec.length == "h") v = static_cast<unsigned short>(v);
+            w = PutUInt(w, v);
+            break;
+        }
+        case 'c':
+            if (!spec.length.empty() || !room(kMaxScalarBytes)) return false;
+            w = PutUInt(w, static_cast<unsigned char>(va_arg(args, int)), ArgTag::Char);
+            break;
+        case 's': {
+            if (!spec.length.empty()) return false;   // wide strings
+            const char* s = va_arg(args, const char*);
+            if (!s) s = "(null)";
+            const size_t len = precision >= 0 ? strnlen(s, static_cast<size_t>(precision)) : std::strlen(s);
+            if (!room(MaxStrBytes(len))) return false;
+            w = PutStr(w, std::string_view(s, len));
+            break;
+        }
+        case 'p':
+            if (!room(kMaxScalarBytes)) return false;
+            w = PutUInt(w, reinterpret_cast<uintptr_t>(va_arg(args, void*)), ArgTag::Ptr);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (!room(kMaxScalarBytes)) return false;
+            if (spec.length == "L") w = PutFloat(w, static_cast<double>(va_arg(args, long double)));
+            else if (spec.length.empty() || spec.length == "l") w = PutFloat(w, va_arg(args, double));
+            else return false;
+            break;
+        default:
+            return false;   // %n, %S, %C and anything unknown
+        }
+    }
+    used = static_cast<size_t>(w - out);
+    return true;
+}
+
+void FormatPrintf(std::string& out, std::string_view fmt, std::string_view args) {
+    const char* a = args.data();
+    const char* aend = a + args.size();
+    const char* p = fmt.data();
+    const char* end = p + fmt.size();
+    while (p < end) {
+        const char* pct = static_cast<const char*>(std::memchr(p, '%', static_cast<size_t>(end - p)));
+        if (!pct) {
+            out.append(p, end);
+            return;
+        }
+        out.append(p, pct);
+        p = pct + 1;
+        if (p < end && *p == '%') {
+            out += '%';
+            ++p;
+            continue;
+        }
+        PrintfSpec spec;
+        const char* next = ParsePrintfSpec(p, end, spec);
+        if (!next) {
+            out.append(pct, end);
+            return;
+        }
+        p = next;
+
+        int stars[2]{};
+        int starCount = 0;
+        bool ok = true;
+        for (const bool star : { spec.width == "*", spec.precision == ".*" }) {
+            if (!star) continue;
+            ArgValue v;
+            if (!NextArg(a, aend, v) || v.tag != ArgTag::Int) { ok = false; break; }
+            stars[starCount++] = static_cast<int>(v.i);
+        }
+        ArgValue v;
+        if (!ok || !NextArg(a, aend, v)) {
+            out += kBadArg;
+            continue;
+        }
+
+        std::string f = "%";
+        f += spec.flags;
+        f += spec.width;
+        f += spec.precision;
+        switch (v.tag) {
+        case ArgTag::Int:
+            f += "ll";
+            f += spec.conv;
+            AppendWithStars(out, f, stars, starCount, static_cast<long long>(v.i));
+            break;
+        case ArgTag::UInt:
+            f += "ll";
+            f += spec.conv;
+            AppendWithStars(out, f, stars, starCount, static_cast<unsigned long long>(v.u));
+            break;
+        case ArgTag::Char:
+        case ArgTag::Bool:
+            f += 'c';
+            AppendWithStars(out, f, stars, starCount, static_cast<int>(v.u));
+            break;
+        case ArgTag::Str: {
+            const std::string s(v.s);
+            f += 's';
+            AppendWithStars(out, f, stars, starCount, s.c_str());
+            break;
+        }
+        case ArgTag::Ptr:
+            f += 'p';
+            AppendWithStars(out, f, stars, starCount, reinterpret_cast<void*>(static_cast<uintptr_t>(v.u)));
+            break;
+        case ArgTag::Float:
+            f += spec.conv;
+            AppendWithStars(out, f, stars, starCount, v.f);
+            break;
+        default:
+            out += kBadArg;
+            break;
+        }
+    }
+}
+
+void FormatBraces(std::string& out, std::string_view fmt, std::string_view args) {
+    std::vector<ArgValue> values;
+    for (const char* a = args.data(), *aend = a + args.size(); a < aend;) {
+        ArgValue v;
+        if (!NextArg(a, aend, v)) break;
+        values.push_back(v);
+    }
+
+    size_t nextIndex = 0;
+    for (size_t i = 0; i < fmt.size(); ++i) {
+        const char c = fmt[i];
+        if (c == '}' && i + 1 < fmt.size() && fmt[i + 1] == '}') {
+            out += '}';
+            ++i;
+            continue;
+        }
+        if (c != '{') {
+            out += c;
+            continue;
+        }
+        if (i + 1 < fmt.size() && fmt[i + 1] == '{') {
+            out += '{';
+            ++i;
+            continue;
+        }
+        const size_t close = fmt.find('}', i);
+        if (close == std::string_view::npos) {
+            out.append(fmt.substr(i));
+            return;
+        }
+        std::string_view field = fmt.substr(i + 1, close - i - 1);
+        i = close;
+
+        size_t index = nextIndex++;
+        if (!field.empty() && field[0] >= '0' && field[0] <= '9') index = static_cast<size_t>(ParseInt(field));
+        if (!field.empty() && field[0] == ':') field.remove_prefix(1);
+        if (index >= values.size()) {
+            out += kBadArg;
+            continue;
+        }
+
+        const BraceSpec spec = ParseBraceSpec(field);
+        std::string text;
+        const bool numeric = FormatBraceValue(text, values[index], spec);
+        const size_t len = text.size();
+        if (spec.width <= 0 || len >= static_cast<size_t>(spec.width)) {
+            out += text;
+            continue;
+        }
+        const size_t pad = static_cast<size_t>(spec.width) - len;
+        if (!spec.align && spec.zero && numeric) {
+            // Zero padding goes after the sign and base prefix.
+            size_t at = 0;
+            if (at < len && (text[at] == '-' || text[at] == '+' || text[at] == ' ')) ++at;
+            if (at + 1 < len && text[at] == '0' && std::strchr("xXbB", text[at + 1])) at += 2;
+            text.insert(at, pad, '0');
+            out += text;
+            continue;
+        }
+        const char align = spec.align ? spec.align : (numeric ? '>' : '<');
+        const size_t before = align == '>' ? pad : (align == '^' ? pad / 2 : 0);
+        out.append(before, spec.fill);
+        out += text;
+        out.append(pad - before, spec.fill);
+    }
+}
+
+void RenderMessage(std::string& out, FormatStyle style, std::string_view fmt, std::string_view args) {
+    switch (style) {
+    case FormatStyle::Printf:
+        FormatPrintf(out, fmt, args);
+        return;
+    case FormatStyle::StdFormat:
+        FormatBraces(out, fmt, args);
+        return;
+    case FormatStyle::Text: {
+        const char* a = args.data();
+        ArgValue v;
+        if (NextArg(a, a + args.size(), v) && v.tag == ArgTag::Str) out.append(v.s);
+        return;
+    }
+    }
+}
+
+const char* LevelName(uint8_t level) {
+    switch (level) {
+    case 0: return "DEBUG";
+    case 1: return "INFO";
+    case 2: return "WARN";
+    case 3: return "ERROR";
+    case 4: return "FATAL";
+    default: return "?";
+    }
+}
+
+std::string FormatTimestamp(int64_t ms) {
+    const time_t sec = static_cast<time_t>(ms / 1000);
+    const int millis = static_cast<int>(ms % 1000);
+    struct tm t{};
+#ifdef _WIN32
+    localtime_s(&t, &sec);
+#else
+    localtime_r(&sec, &t);
+#endif
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+        t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
+        t.tm_hour, t.tm_min, t.tm_sec, millis);
+    return buf;
+}
+
+void AppendJsonString(std::string& out, std::string_view s) {
+    out += '"';
+    for (const char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+// ─── BinaryWriter ────────────────────────────────────────────────────────────
+
+void BinaryWriter::Reset() {
+    sources_.clear();
+    formats_.clear();
+    lastTimestampMs_ = 0;
+}
+
+void BinaryWriter::AppendHeader(std::string& out) {
+    out.append(kMagic, sizeof(kMagic));
+}
+
+uint32_t BinaryWriter::InternSource(std::string& out, std::string_view source) {
+    const auto [it, added] = sources_.try_emplace(std::string(source), static_cast<uint32_t>(sources_.size()));
+    if (added) {
+        out += static_cast<char>(RecordTag::Source);
+        AppendVarint(out, it->second);
+        AppendVarint(out, source.size());
+        out.append(source);
+    }
+    return it->second;
+}
+
+uint32_t BinaryWriter::InternFormat(std::string& out, FormatStyle style, std::string_view fmt) {
+    std::string key(1, static_cast<char>(style));
+    key.append(fmt);
+    const auto [it, added] = formats_.try_emplace(std::move(key), static_cast<uint32_t>(formats_.size()));
+    if (added) {
+        out += static_cast<char>(RecordTag::Format);
+        AppendVarint(out, it->second);
+        out += static_cast<char>(style);
+        AppendVarint(out, fmt.size());
+        out.append(fmt);
+    }
+    return it->second;
+}
+
+void BinaryWriter::AppendEntry(std::string& out, int64_t timestampMs, uint8_t level, uint32_t threadId,
+    std::string_view source, FormatStyle style, std::string_view fmt, std::string_view args) {
+    const uint32_t sourceId = InternSource(out, source);
+    const uint32_t formatId = InternFormat(out, style, fmt);
+    out += static_cast<char>(RecordTag::Entry);
+    AppendVarint(out, ZigZag(timestampMs - lastTimestampMs_));
+    lastTimestampMs_ = timestampMs;
+    out += static_cast<char>(level);
+    AppendVarint(out, threadId);
+    AppendVarint(out, sourceId);
+    AppendVarint(out, formatId);
+    AppendVarint(out, args.size());
+    out.append(args);
+}
+
+// ─── BinaryReader ────────────────────────────────────────────────────────────
+
+bool BinaryReader::Open(std::string_view data) {
+    sources_.clear();
+    formats_.clear();
+    lastTimestampMs_ = 0;
+    failed_ = data.size() < sizeof(kMagic) || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0;
+    p_ = data.data() + (failed_ ? data.size() : sizeof(kMagic));
+    end_ = data.data() + data.size();
+    return !failed_;
+}
+
+bool BinaryReader::Next(BinaryEntry& entry) {
+    auto fail = [this] {
+        failed_ = true;
+        p_ = end_;
+        return false;
+    };
+    auto readText = [&](std::string& text) {
+        uint64_t len = 0;
+        if (!GetVarint(p_, end_, len) || len > static_cast<uint64_t>(end_ - p_)) return false;
+        text.assign(p_, static_cast<size_t>(len));
+        p_ += len;
+        return true;
+    };
+
+    while (p_ < end_) {
+        const auto tag = static_cast<RecordTag>(*p_++);
+        uint64_t id = 0;
+        switch (tag) {
+        case RecordTag::Source: {
+            std::string text;
+            if (!GetVarint(p_, end_, id) || id != sources_.size() || !readText(text)) return fail();
+            sources_.push_back(std::move(text));
+            break;
+        }
+        case RecordTag::Format: {
+            if (!GetVarint(p_, end_, id) || id != formats_.size() || p_ >= end_) return fail();
+            Format f{ static_cast<FormatStyle>(*p_++), {} };
+            if (!readText(f.text)) return fail();
+            formats_.push_back(std::move(f));
+            break;
+        }
+        case RecordTag::Entry: {
+            uint64_t delta = 0, thread = 0, sourceId = 0, formatId = 0, argsLen = 0;
+            if (!GetVarint(p_, end_, delta) || p_ >= end_) return fail();
+            entry.level = static_cast<uint8_t>(*p_++);
+            if (!GetVarint(p_, end_, thread) || !GetVarint(p_, end_, sourceId) || !GetVarint(p_, end_, formatId) ||
+                !GetVarint(p_, end_, argsLen) || sourceId >= sources_.size() || formatId >= formats_.size() ||
+                argsLen > static_cast<uint64_t>(end_ - p_)) {
+                return fail();
+            }
+            lastTimestampMs_ += UnZigZag(delta);
+            entry.timestampMs = lastTimestampMs_;
+            entry.threadId = static_cast<uint32_t>(thread);
+            entry.source = sources_[sourceId];
+            entry.style = formats_[formatId].style;
+            entry.fmt = formats_[formatId].text;
+            entry.args = std::string_view(p_, static_cast<size_t>(argsLen));
+            p_ += argsLen;
+            return true;
+        }
+        default:
+            return fail();
+        }
+    }
+    return false;
+}
+
+} // namespace logfmt
@@ -0,0 +1,171 @@
+#pragma once
+// LogFormat.h — captured log arguments and the binary log file format.
+// Shared by Logger and the acp_logdump tool, so it has no Windows or Logger
+// dependencies.
+//
+// Arguments are a tagged stream: one ArgTag byte per value, then the value
+// (integers as varints, zig-zag for signed; doubles as 8 raw bytes; strings
+// as a varint length plus bytes). printf-style calls are captured by walking
+// the format string, LOGF_* calls by their static argument types; both can be
+// turned back into text later without the original call site.
+//
+// Binary file: kMagic, then records, each starting with a RecordTag byte.
+//   Source: varint id, varint length, bytes
+//   Format: varint id, style byte, varint length, bytes
+//   Entry:  zig-zag varint ms since the previous entry (the first one is
+//           absolute), level byte, varint thread, varint source id, varint
+//           format id, varint argument length, argument stream
+// Sources and formats are interned per file and defined before first use,
+// so every file (including each rotated one) decodes on its own.
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace logfmt {
+
+enum class ArgTag : uint8_t {
+    Int   = 1,
+    UInt  = 2,
+    Float = 3,
+    Str   = 4,
+    Ptr   = 5,
+    Bool  = 6,
+    Char  = 7
+};
+
+enum class FormatStyle : uint8_t {
+    Text      = 0,   // no format string; args are the message (and stack trace)
+    Printf    = 1,
+    StdFormat = 2
+};
+
+enum class RecordTag : uint8_t {
+    Source = 1,
+    Format = 2,
+    Entry  = 3
+};
+
+inline constexpr char kMagic[8] = { 'A', 'C', 'P', 'L', 'O', 'G', 'B', '1' };
+
+// Upper bounds of one encoded value, for sizing buffers up front.
+inline constexpr size_t kMaxScalarBytes = 1 + 10;
+inline size_t MaxStrBytes(size_t len) { return 1 + 5 + len; }
+
+inline char* PutVarint(char* out, uint64_t v) {
+    while (v >= 0x80) {
+        *out++ = static_cast<char>(v | 0x80);
+        v >>= 7;
+    }
+    *out++ = static_cast<char>(v);
+    return out;
+}
+inline uint64_t ZigZag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t UnZigZag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+inline char* PutInt(char* out, int64_t v) {
+    *out++ = static_cast<char>(ArgTag::Int);
+    return PutVarint(out, ZigZag(v));
+}
+inline char* PutUInt(char* out, uint64_t v, ArgTag tag = ArgTag::UInt) {
+    *out++ = static_cast<char>(tag);
+    return PutVarint(out, v);
+}
+inline char* PutFloat(char* out, double v) {
+    *out++ = static_cast<char>(ArgTag::Float);
+    std::memcpy(out, &v, sizeof(v));
+    return out + sizeof(v);
+}
+inline char* PutStr(char* out, std::string_view s) {
+    *out++ = static_cast<char>(ArgTag::Str);
+    out = PutVarint(out, s.size());
+    std::memcpy(out, s.data(), s.size());
+    return out + s.size();
+}
+
+// Reads one tagged value. Numbers come back in i/u/f by tag, strings in s.
+struct ArgValue {
+    ArgTag tag{ ArgTag::Int };
+    int64_t i{ 0 };
+    uint64_t u{ 0 };
+    double f{ 0.0 };
+    std::string_view s;
+};
+bool GetVarint(const char*& p, const char* end, uint64_t& v);
+bool NextArg(const char*& p, const char* end, ArgValue& out);
+
+// Captures the arguments of a printf-style call. Returns false (args are then
+// in an unspecified state) for conversions it cannot represent, such as wide
+// strings or %n, or when they do not fit in capacity.
+bool CapturePrintfArgs(const char* fmt, va_list args, char* out, size_t capacity, size_t& used);
+// Formats a printf-style format with captured arguments; the result matches
+// vsnprintf for the conversions CapturePrintfArgs accepts.
+void FormatPrintf(std::string& out, std::string_view fmt, std::string_view args);
+// Best-effort std::format replacement-field rendering ({} and {:spec} with
+// fill/align, sign, #, 0, width, precision and type) for offline decoding.
+void FormatBraces(std::string& out, std::string_view fmt, std::string_view args);
+// Renders a message of any style.
+void RenderMessage(std::string& out, FormatStyle style, std::string_view fmt, std::string_view args);
+
+const char* LevelName(uint8_t level);
+// "YYYY-MM-DD HH:MM:SS.mmm" in local time.
+std::string FormatTimestamp(int64_t ms);
+void AppendJsonString(std::string& out, std::string_view s);
+
+// Encodes entries for one binary file. Reset() when a new file starts.
+class BinaryWriter {
+public:
+    void Reset();
+    // Appends the file magic; call once at the start of each file.
+    void AppendHeader(std::string& out);
+    void AppendEntry(std::string& out, int64_t timestampMs, uint8_t level, uint32_t threadId,
+        std::string_view source, FormatStyle style, std::string_view fmt, std::string_view args);
+
+private:
+    uint32_t InternSource(std::string& out, std::string_view source);
+    uint32_t InternFormat(std::string& out, FormatStyle style, std::string_view fmt);
+
+    std::unordered_map<std::string, uint32_t> sources_;
+    std::unordered_map<std::string, uint32_t> formats_;   // keyed by style byte + text
+    int64_t lastTimestampMs_{ 0 };
+};
+
+struct BinaryEntry {
+    int64_t timestampMs{ 0 };
+    uint8_t level{ 0 };
+    uint32_t threadId{ 0 };
+    std::string_view source;
+    FormatStyle style{ FormatStyle::Text };
+    std::string_view fmt;
+    std::string_view args;
+};
+
+// Walks a binary log held in memory. The views in a BinaryEntry stay valid
+// until the next call to Next().
+class BinaryReader {
+public:
+    bool Open(std::string_view data);
+    // False at the end of the data or at the first malformed record.
+    bool Next(BinaryEntry& entry);
+    bool Failed() const { return failed_; }
+
+private:
+    struct Format {
+        FormatStyle style;
+        std::string text;
+    };
+
+    const char* p_{ nullptr };
+    const char* end_{ nullptr };
+    bool failed_{ false };
+    int64_t lastTimestampMs_{ 0 };
+    std::vector<std::string> sources_;
+    std::vector<Format> formats_;
+};
+
+} // namespace logfmt
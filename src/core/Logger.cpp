@@ -1,33 +1,131 @@
 #include "core/Logger.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <windows.h>
 
+#include "core/HighResClock.h"
+#include "core/SpscRing.h"
+
+namespace {
+
+// Ring records are a header slot followed by the source and message bytes,
+// spread over as many consecutive slots as they need. What the message bytes
+// hold depends on the record kind:
+//   Text:      the formatted message
+//   StdFormat: a DeferredHead plus the tagged LOGF_* arguments
+//   Printf:    u16 format length, the format string, the tagged arguments
+enum RecordKind : uint8_t {
+    kText      = 0,
+    kStdFormat = 1,
+    kPrintf    = 2
+};
+
+struct LogSlot {
+    alignas(8) char bytes[64];
+};
+
+struct RecordHeader {
+    int64_t  timestampMs;
+    int64_t  qpc;
+    uint32_t threadId;
+    uint16_t sourceLen;
+    uint16_t messageLen;
+    uint8_t  level;
+    uint8_t  slots;   // including this one
+    uint8_t  kind;    // RecordKind
+};
+static_assert(sizeof(RecordHeader) <= sizeof(LogSlot));
+
+#if ACP_LOG_HAS_FORMAT
+struct DeferredHead {
+    logdetail::FormatFn fn;
+    const char* fmt;    // format strings are literals
+    uint32_t fmtLen;
+};
+#endif
+
+constexpr size_t kMaxSource = 127;
+constexpr size_t kMaxMessage = 2047;   // the old stack buffer was 2048 bytes
+constexpr size_t kMaxFormat = 511;     // longer printf formats are formatted on the spot
+constexpr size_t kMaxRecordSlots = (sizeof(RecordHeader) + kMaxSource + kMaxMessage + 1 + sizeof(LogSlot) - 1) / sizeof(LogSlot);
+static_assert(kMaxRecordSlots <= 255);
+
+constexpr size_t kRingSlots = 1024;   // 64 KB per logging thread
+constexpr auto kDrainInterval = std::chrono::milliseconds(20);
+
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+char* PayloadOf(LogSlot* record) {
+    return record[0].bytes + sizeof(RecordHeader);
+}
+
+// Fills in the header of the record in `record` (payload already written).
+RecordHeader FinishRecord(LogSlot* record, LogLevel level, uint32_t threadId, size_t sourceLen, size_t messageLen, RecordKind kind) {
+    RecordHeader h{};
+    h.timestampMs = NowMs();
+    h.qpc = timing::QpcNow();
+    h.threadId = threadId;
+    h.sourceLen = static_cast<uint16_t>(sourceLen);
+    h.messageLen = static_cast<uint16_t>(messageLen);
+    h.level = static_cast<uint8_t>(level);
+    h.slots = static_cast<uint8_t>((sizeof(RecordHeader) + sourceLen + messageLen + sizeof(LogSlot) - 1) / sizeof(LogSlot));
+    h.kind = kind;
+    std::memcpy(record[0].bytes, &h, sizeof(h));
+    return h;
+}
+
+} // namespace
+
+struct Logger::ThreadQueue {
+    SpscRing<LogSlot, kRingSlots> ring;
+    LogSlot scratch[kMaxRecordSlots];   // producer-side record being built
+    size_t deferredSourceLen{ 0 };      // LOGF_* record between Begin/CommitDeferred
+    uint32_t threadId{ 0 };
+    std::atomic<bool> retired{ false }; // owning thread exited
+};
+
 Logger& Logger::Instance() {
     static Logger inst;
     return inst;
 }
 
-Logger::Logger() = default;
-Logger::~Logger() = default;
+Logger::Logger() {
+    writer_ = std::thread([this] { WriterMain(); });
+}
+
+Logger::~Logger() {
+    {
+        std::scoped_lock lock(writerMutex_);
+        stopWriter_ = true;
+    }
+    writerCv_.notify_one();
+    if (writer_.joinable()) writer_.join();
+}
 
 void Logger::SetLevel(LogLevel level) {
-    std::scoped_lock lock(mutex_);
-    level_ = level;
+    level_.store(level, std::memory_order_relaxed);
 }
 
 LogLevel Logger::GetLevel() const {
-    std::scoped_lock lock(mutex_);
-    return level_;
+    return level_.load(std::memory_order_relaxed);
 }
 
 void Logger::SetMaxEntries(int max) {
     std::scoped_lock lock(mutex_);
     maxEntries_ = max;
-    while (maxEntries_ > 0 && (int)entries_.size() > maxEntries_) {
-        entries_.pop_front();
+    // Unroll the ring oldest-first, then keep the newest maxEntries_.
+    std::rotate(entries_.begin(), entries_.begin() + static_cast<ptrdiff_t>(ringHead_), entries_.end());
+    ringHead_ = 0;
+    if (maxEntries_ > 0 && (int)entries_.size() > maxEntries_) {
+        entries_.erase(entries_.begin(), entries_.end() - maxEntries_);
     }
 }
 
@@ -36,8 +134,29 @@ int Logger::GetMaxEntries() const {
     return maxEntries_;
 }
 
+void Logger::SetFileFormat(LogFileFormat format) {
+    std::scoped_lock lock(fileMutex_);
+    if (format == fileFormat_) return;
+    fileFormat_ = format;
+    if (file_.is_open()) {
+        file_.close();
+        OpenLogFileLocked();
+    }
+}
+
+LogFileFormat Logger::GetFileFormat() const {
+    std::scoped_lock lock(fileMutex_);
+    return fileFormat_;
+}
+
+void Logger::SetFileRotation(int64_t maxBytes, int maxFiles) {
+    std::scoped_lock lock(fileMutex_);
+    maxFileBytes_ = maxBytes;
+    maxFiles_ = std::max(maxFiles, 1);
+}
+
 void Logger::SetFileOutput(bool enabled, const std::string& path) {
-    std::scoped_lock lock(mutex_);
+    std::scoped_lock lock(fileMutex_);
     const bool pathChanged = (!path.empty() && path != filePath_);
     if (pathChanged) filePath_ = path;
     fileOutput_ = enabled;
@@ -50,122 +169,411 @@ void Logger::SetFileOutput(bool enabled, const std::string& path) {
 }
 
 bool Logger::IsFileOutputEnabled() const {
-    std::scoped_lock lock(mutex_);
+    std::scoped_lock lock(fileMutex_);
     return fileOutput_;
 }
 
 std::string Logger::GetFilePath() const {
-    std::scoped_lock lock(mutex_);
+    std::scoped_lock lock(fileMutex_);
     return filePath_;
 }
 
+Logger::ThreadQueue& Logger::LocalQueue() {
+    // Shared with the writer so records logged just before a thread exits
+    // are still drained; the holder only marks the queue retired.
+    struct Holder {
+        std::shared_ptr<ThreadQueue> queue;
+        ~Holder() {
+            if (queue) queue->retired.store(true, std::memory_order_release);
+        }
+    };
+    thread_local Holder holder;
+    if (!holder.queue) {
+        holder.queue = std::make_shared<ThreadQueue>();
+        holder.queue->threadId = GetCurrentThreadId();
+        std::scoped_lock lock(queuesMutex_);
+        queues_.push_back(holder.queue);
+    }
+    return *holder.queue;
+}
+
 void Logger::Log(LogLevel level, const char* source, const char* fmt, ...) {
-    char buf[2048];
+    if (level < GetLevel()) return;
+
+    ThreadQueue& q = LocalQueue();
+    char* payload = PayloadOf(q.scratch);
+    const size_t sourceLen = source ? strnlen(source, kMaxSource) : 0;
+    if (sourceLen) std::memcpy(payload, source, sourceLen);
+    char* message = payload + sourceLen;
+    RecordKind kind = kText;
+    size_t messageLen = 0;
+
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buf, sizeof(buf), fmt, args);
+    // Copy the format and raw arguments; the writer thread formats them. Formats
+    // that are too long or that capture cannot represent are formatted here.
+    const size_t fmtLen = strnlen(fmt, kMaxFormat + 1);
+    if (fmtLen <= kMaxFormat) {
+        const uint16_t n = static_cast<uint16_t>(fmtLen);
+        std::memcpy(message, &n, sizeof(n));
+        std::memcpy(message + sizeof(n), fmt, fmtLen);
+        const size_t head = sizeof(n) + fmtLen;
+        size_t used = 0;
+        va_list capture;
+        va_copy(capture, args);
+        if (logfmt::CapturePrintfArgs(fmt, capture, message + head, kMaxMessage - head, used)) {
+            kind = kPrintf;
+            messageLen = head + used;
+        }
+        va_end(capture);
+    }
+    if (kind == kText) {
+        const int written = vsnprintf(message, kMaxMessage + 1, fmt, args);
+        messageLen = written < 0 ? 0 : std::min<size_t>(static_cast<size_t>(written), kMaxMessage);
+    }
     va_end(args);
 
-    LogEntry entry;
-    auto now = std::chrono::system_clock::now();
-    entry.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-    entry.level = level;
-    entry.threadId = GetCurrentThreadId();
-    entry.source = source ? source : "";
-    entry.message = buf;
+    const RecordHeader h = FinishRecord(q.scratch, level, q.threadId, sourceLen, messageLen, kind);
+    PushRecord(q, h.slots);
+    if (level >= LogLevel::Error) Flush();
+}
 
-    std::scoped_lock lock(mutex_);
-    if (level < level_) return;
-    entries_.push_back(entry);
-    if (maxEntries_ > 0 && (int)entries_.size() > maxEntries_) {
-        entries_.pop_front();
+#if ACP_LOG_HAS_FORMAT
+char* Logger::BeginDeferred(const char* source, size_t maxArgBytes, logdetail::FormatFn fn, std::string_view fmt) {
+    if (sizeof(DeferredHead) + maxArgBytes > kMaxMessage) return nullptr;
+    ThreadQueue& q = LocalQueue();
+    char* payload = PayloadOf(q.scratch);
+    const size_t sourceLen = source ? strnlen(source, kMaxSource) : 0;
+    if (sourceLen) std::memcpy(payload, source, sourceLen);
+    const DeferredHead d{ fn, fmt.data(), static_cast<uint32_t>(fmt.size()) };
+    std::memcpy(payload + sourceLen, &d, sizeof(d));
+    q.deferredSourceLen = sourceLen;
+    return payload + sourceLen + sizeof(d);
+}
+
+void Logger::CommitDeferred(LogLevel level, const char* argsEnd) {
+    ThreadQueue& q = LocalQueue();
+    const size_t messageLen = static_cast<size_t>(argsEnd - (PayloadOf(q.scratch) + q.deferredSourceLen));
+    const RecordHeader h = FinishRecord(q.scratch, level, q.threadId, q.deferredSourceLen, messageLen, kStdFormat);
+    PushRecord(q, h.slots);
+    if (level >= LogLevel::Error) Flush();
+}
+#endif
+
+void Logger::PushRecord(ThreadQueue& q, size_t slots) {
+    if (q.ring.TryPushAll(std::span<const LogSlot>(q.scratch, slots))) return;
+    PushFallback(DecodeRecord(q.scratch));
+}
+
+// Turns a ring record back into an entry; captured messages are formatted here.
+Logger::Pending Logger::DecodeRecord(const void* record) {
+    RecordHeader h;
+    std::memcpy(&h, record, sizeof(h));
+    const char* payload = static_cast<const char*>(record) + sizeof(RecordHeader);
+    Pending p{ h.qpc, LogEntry{ h.timestampMs, static_cast<LogLevel>(h.level), h.threadId, std::string(payload, h.sourceLen), {}, {} },
+        logfmt::FormatStyle::Text, {}, {} };
+    const char* message = payload + h.sourceLen;
+    switch (h.kind) {
+    case kPrintf: {
+        uint16_t fmtLen = 0;
+        std::memcpy(&fmtLen, message, sizeof(fmtLen));
+        const size_t head = sizeof(fmtLen) + fmtLen;
+        p.style = logfmt::FormatStyle::Printf;
+        p.fmt.assign(message + sizeof(fmtLen), fmtLen);
+        p.args.assign(message + head, h.messageLen - head);
+        logfmt::FormatPrintf(p.entry.message, p.fmt, p.args);
+        break;
+    }
+#if ACP_LOG_HAS_FORMAT
+    case kStdFormat: {
+        DeferredHead d;
+        std::memcpy(&d, message, sizeof(d));
+        p.style = logfmt::FormatStyle::StdFormat;
+        p.fmt.assign(d.fmt, d.fmtLen);
+        p.args.assign(message + sizeof(d), h.messageLen - sizeof(d));
+        try {
+            d.fn(p.args, p.fmt, p.entry.message);
+        } catch (const std::exception& ex) {
+            p.entry.message = std::string("<format error: ") + ex.what() + ">";
+        }
+        break;
     }
-    if (fileOutput_) WriteToFile(entry);
+#endif
+    default:
+        p.entry.message.assign(message, h.messageLen);
+        break;
+    }
+    return p;
 }
 
 void Logger::LogWithStack(LogLevel level, const char* source, const char* message, const char* stack) {
+    if (level < GetLevel()) return;
+
+    // Stack traces are unbounded and rare: straight to the locked queue.
     LogEntry entry;
-    auto now = std::chrono::system_clock::now();
-    entry.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    entry.timestampMs = NowMs();
     entry.level = level;
     entry.threadId = GetCurrentThreadId();
     entry.source = source ? source : "";
     entry.message = message ? message : "";
     entry.stackTrace = stack ? stack : "";
+    PushFallback(Pending{ timing::QpcNow(), std::move(entry), logfmt::FormatStyle::Text, {}, {} });
+    if (level >= LogLevel::Error) Flush();
+}
+
+void Logger::PushFallback(Pending&& pending) {
+    std::scoped_lock lock(queuesMutex_);
+    fallback_.push_back(std::move(pending));
+}
+
+void Logger::Flush() {
+    std::unique_lock lock(writerMutex_);
+    if (stopWriter_) return;
+    const uint64_t ticket = ++flushRequested_;
+    writerCv_.notify_one();
+    flushedCv_.wait(lock, [&] { return flushDone_ >= ticket || stopWriter_; });
+}
+
+void Logger::WriterMain() {
+    std::vector<Pending> batch;
+    std::unique_lock lock(writerMutex_);
+    for (;;) {
+        writerCv_.wait_for(lock, kDrainInterval, [this] { return stopWriter_ || flushRequested_ != flushDone_; });
+        const uint64_t ticket = flushRequested_;
+        const bool stopping = stopWriter_;
+        lock.unlock();
+
+        Drain(batch);
+        Publish(batch);
+        batch.clear();
+
+        lock.lock();
+        flushDone_ = ticket;
+        flushedCv_.notify_all();
+        if (stopping) return;
+    }
+}
 
+void Logger::Drain(std::vector<Pending>& batch) {
+    std::vector<std::shared_ptr<ThreadQueue>> queues;
+    {
+        std::scoped_lock lock(queuesMutex_);
+        queues = queues_;
+    }
+
+    LogSlot record[kMaxRecordSlots];
+    for (const auto& q : queues) {
+        // Read retired before draining: anything the thread logged is then visible.
+        const bool retired = q->retired.load(std::memory_order_acquire);
+        for (auto head = q->ring.FrontSpan(1); !head.empty(); head = q->ring.FrontSpan(1)) {
+            RecordHeader h;
+            std::memcpy(&h, head.data(), sizeof(h));
+            q->ring.PopBulk(std::span<LogSlot>(record, h.slots));
+            batch.push_back(DecodeRecord(record));
+        }
+        if (retired) {
+            std::scoped_lock lock(queuesMutex_);
+            queues_.erase(std::remove(queues_.begin(), queues_.end(), q), queues_.end());
+        }
+    }
+
+    // The fallback queue is taken last: a record that spilled from a full ring
+    // is then in this batch or an earlier one than any later record its thread
+    // got into the ring, and Publish orders within the batch.
+    std::scoped_lock lock(queuesMutex_);
+    for (auto& p : fallback_) batch.push_back(std::move(p));
+    fallback_.clear();
+}
+
+void Logger::Publish(std::vector<Pending>& batch) {
+    if (batch.empty()) return;
+    std::stable_sort(batch.begin(), batch.end(), [](const Pending& a, const Pending& b) { return a.qpc < b.qpc; });
+    WriteToFile(batch);
     std::scoped_lock lock(mutex_);
-    if (level < level_) return;
-    entries_.push_back(entry);
-    if (maxEntries_ > 0 && (int)entries_.size() > maxEntries_) {
-        entries_.pop_front();
+    for (auto& p : batch) AppendEntry(std::move(p.entry));
+}
+
+void Logger::AppendEntry(LogEntry&& entry) {
+    entry.seq = ++lastSeq_;
+    if (maxEntries_ <= 0 || (int)entries_.size() < maxEntries_) {
+        entries_.push_back(std::move(entry));
+        return;
     }
-    if (fileOutput_) WriteToFile(entry);
+    entries_[ringHead_] = std::move(entry);
+    ringHead_ = (ringHead_ + 1) % entries_.size();
 }
 
 void Logger::Clear() {
     std::scoped_lock lock(mutex_);
     entries_.clear();
+    ringHead_ = 0;
 }
 
 std::vector<LogEntry> Logger::GetEntries() const {
     std::scoped_lock lock(mutex_);
-    return std::vector<LogEntry>(entries_.begin(), entries_.end());
+    std::vector<LogEntry> result;
+    result.reserve(entries_.size());
+    result.insert(result.end(), entries_.begin() + static_cast<ptrdiff_t>(ringHead_), entries_.end());
+    result.insert(result.end(), entries_.begin(), entries_.begin() + static_cast<ptrdiff_t>(ringHead_));
+    return result;
 }
 
 std::vector<LogEntry> Logger::GetEntries(LogLevel minLevel) const {
     std::scoped_lock lock(mutex_);
     std::vector<LogEntry> result;
-    for (const auto& e : entries_) {
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const LogEntry& e = entries_[(ringHead_ + i) % entries_.size()];
         if (e.level >= minLevel) result.push_back(e);
     }
     return result;
 }
 
+std::vector<LogEntry> Logger::GetEntriesSince(uint64_t afterSeq, LogLevel minLevel) const {
+    std::scoped_lock lock(mutex_);
+    std::vector<LogEntry> result;
+    // The ring holds seqs [lastSeq_ - size + 1, lastSeq_] contiguously.
+    const uint64_t oldest = lastSeq_ - entries_.size() + 1;
+    const size_t skip = afterSeq >= oldest ? static_cast<size_t>(afterSeq - oldest + 1) : 0;
+    for (size_t i = skip; i < entries_.size(); ++i) {
+        const LogEntry& e = entries_[(ringHead_ + i) % entries_.size()];
+        if (e.level >= minLevel) result.push_back(e);
+    }
+    return result;
+}
+
+uint64_t Logger::OldestSequence() const {
+    std::scoped_lock lock(mutex_);
+    return lastSeq_ - entries_.size() + 1;
+}
+
+uint64_t Logger::LastSequence() const {
+    std::scoped_lock lock(mutex_);
+    return lastSeq_;
+}
+
 size_t Logger::EntryCount() const {
     std::scoped_lock lock(mutex_);
     return entries_.size();
 }
 
 const char* Logger::LevelName(LogLevel level) {
-    switch (level) {
-    case LogLevel::Debug: return "DEBUG";
-    case LogLevel::Info:  return "INFO";
-    case LogLevel::Warn:  return "WARN";
-    case LogLevel::Error: return "ERROR";
-    case LogLevel::Fatal: return "FATAL";
-    default: return "?";
-    }
+    return logfmt::LevelName(static_cast<uint8_t>(level));
 }
 
 std::string Logger::FormatTimestamp(int64_t ms) {
-    const time_t sec = static_cast<time_t>(ms / 1000);
-    const int millis = static_cast<int>(ms % 1000);
-    struct tm t{};
-    localtime_s(&t, &sec);
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
-        t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
-        t.tm_hour, t.tm_min, t.tm_sec, millis);
-    return buf;
-}
-
-void Logger::WriteToFile(const LogEntry& entry) {
+    return logfmt::FormatTimestamp(ms);
+}
+
+// One write and one flush per batch instead of per line.
+void Logger::WriteToFile(const std::vector<Pending>& batch) {
+    std::scoped_lock lock(fileMutex_);
+    if (!fileOutput_) return;
     if (!file_.is_open()) {
         OpenLogFileLocked();
         if (!file_.is_open()) return;
     }
-    file_ << FormatTimestamp(entry.timestampMs)
-        << " [" << LevelName(entry.level) << "]"
-        << " [T:" << entry.threadId << "]"
-        << " [" << entry.source << "] "
-        << entry.message;
-    if (!entry.stackTrace.empty()) {
-        file_ << "\n  Stack: " << entry.stackTrace;
+
+    // The date/time part only changes once a second.
+    int64_t stampSecond = -1;
+    std::string stamp;
+    auto appendText = [&](std::string& out, const LogEntry& entry) {
+        if (entry.timestampMs / 1000 != stampSecond) {
+            stampSecond = entry.timestampMs / 1000;
+            stamp = FormatTimestamp(entry.timestampMs).substr(0, 19);
+        }
+        char prefix[96];
+        snprintf(prefix, sizeof(prefix), ".%03d [%s] [T:%u] [", static_cast<int>(entry.timestampMs % 1000),
+            LevelName(entry.level), entry.threadId);
+        out += stamp;
+        out += prefix;
+        out += entry.source;
+        out += "] ";
+        out += entry.message;
+        if (!entry.stackTrace.empty()) {
+            out += "\n  Stack: ";
+            out += entry.stackTrace;
+        }
+        out += '\n';
+    };
+    auto append = [&](std::string& out, const Pending& p) {
+        if (fileFormat_ == LogFileFormat::Binary) AppendBinary(out, p);
+        else appendText(out, p.entry);
+    };
+
+    const int64_t emptySize = fileFormat_ == LogFileFormat::Binary ? static_cast<int64_t>(sizeof(logfmt::kMagic)) : 0;
+    std::string out;
+    for (const auto& p : batch) {
+        const size_t mark = out.size();
+        append(out, p);
+        const int64_t total = fileBytes_ + static_cast<int64_t>(out.size());
+        if (maxFileBytes_ <= 0 || total <= maxFileBytes_ || fileBytes_ + static_cast<int64_t>(mark) <= emptySize) continue;
+        // This entry starts the next file; binary entries are re-encoded
+        // because the new file interns its strings from scratch.
+        out.resize(mark);
+        file_.write(out.data(), static_cast<std::streamsize>(out.size()));
+        file_.close();
+        RotateFilesLocked();
+        OpenLogFileLocked();
+        if (!file_.is_open()) return;
+        out.clear();
+        append(out, p);
     }
-    file_ << "\n";
-    file_.flush();  // ensure log lines hit disk even on crash
+    file_.write(out.data(), static_cast<std::streamsize>(out.size()));
+    file_.flush();  // batches are short-lived; Error/Fatal force one before returning
+    fileBytes_ += static_cast<int64_t>(out.size());
+}
+
+void Logger::AppendBinary(std::string& out, const Pending& p) {
+    const LogEntry& e = p.entry;
+    const uint8_t level = static_cast<uint8_t>(e.level);
+    if (p.style != logfmt::FormatStyle::Text) {
+        binary_.AppendEntry(out, e.timestampMs, level, e.threadId, e.source, p.style, p.fmt, p.args);
+        return;
+    }
+    // Plain messages are stored as a string argument, followed by the stack trace if any.
+    std::string args(logfmt::MaxStrBytes(e.message.size()) + logfmt::MaxStrBytes(e.stackTrace.size()), '\0');
+    char* w = logfmt::PutStr(args.data(), e.message);
+    if (!e.stackTrace.empty()) w = logfmt::PutStr(w, e.stackTrace);
+    args.resize(static_cast<size_t>(w - args.data()));
+    binary_.AppendEntry(out, e.timestampMs, level, e.threadId, e.source, logfmt::FormatStyle::Text, {}, args);
 }
 
 void Logger::OpenLogFileLocked() {
-    file_.open(filePath_, std::ios::app);
+    std::error_code ec;
+    const bool binary = fileFormat_ == LogFileFormat::Binary;
+    int64_t size = static_cast<int64_t>(std::filesystem::file_size(filePath_, ec));
+    if (ec) size = 0;
+    if (size > 0) {
+        // A binary file cannot be resumed (its interned strings are gone) and
+        // text must not be appended to one, so either case starts a new file.
+        char magic[sizeof(logfmt::kMagic)]{};
+        std::ifstream(filePath_, std::ios::binary).read(magic, sizeof(magic));
+        if (binary || std::memcmp(magic, logfmt::kMagic, sizeof(magic)) == 0) {
+            RotateFilesLocked();
+            size = static_cast<int64_t>(std::filesystem::file_size(filePath_, ec));
+            if (ec) size = 0;
+        }
+    }
+    auto mode = binary ? std::ios::app | std::ios::binary : std::ios::app;
+    if (binary && size > 0) mode = std::ios::trunc | std::ios::binary | std::ios::out;   // could not rotate it away
+    file_.open(filePath_, mode);
+    fileBytes_ = binary ? 0 : size;
+    if (!binary || !file_.is_open()) return;
+    binary_.Reset();
+    std::string header;
+    binary_.AppendHeader(header);
+    file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    fileBytes_ = static_cast<int64_t>(header.size());
+}
+
+void Logger::RotateFilesLocked() {
+    std::error_code ec;
+    auto numbered = [this](int i) { return filePath_ + "." + std::to_string(i); };
+    if (maxFiles_ <= 1) {
+        std::filesystem::remove(filePath_, ec);
+        return;
+    }
+    std::filesystem::remove(numbered(maxFiles_ - 1), ec);
+    for (int i = maxFiles_ - 2; i >= 1; --i) std::filesystem::rename(numbered(i), numbered(i + 1), ec);
+    std::filesystem::rename(filePath_, numbered(1), ec);
 }
@@ -1,12 +1,51 @@
 #pragma once
+// Logger.h — asynchronous logging.
+// Log() formats straight into a per-thread lock-free ring (SpscRing) and
+// returns; a background writer drains every ring roughly every 20 ms, keeps
+// the newest entries in a bounded ring for the UI and appends them to the log
+// file in one write per batch. Error/Fatal wait for their batch to reach the
+// file. When a thread's ring is full the entry takes a locked fallback queue
+// instead of being dropped.
+//
+// The LOG_* macros test the level with one relaxed atomic load before touching
+// their arguments, and levels below ACP_LOG_MIN_LEVEL are compiled out. Log()
+// copies its printf arguments into the ring as tagged values (LogFormat.h) and
+// the LOGF_* variants, which take a std::format string, do the same; both are
+// formatted on the writer thread.
+//
+// The file sink writes either text lines or the compact binary format from
+// LogFormat.h (decoded by the acp_logdump tool), and rotates the file by size.
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <cstring>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "core/LogFormat.h"
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_format)
+#include <format>
+#include <iterator>
+#include <tuple>
+#define ACP_LOG_HAS_FORMAT 1
+#endif
+
+// Lowest level compiled in (0=Debug ... 4=Fatal).
+#ifndef ACP_LOG_MIN_LEVEL
+#define ACP_LOG_MIN_LEVEL 0
+#endif
+
 enum class LogLevel : int {
     Debug = 0,
     Info  = 1,
@@ -15,6 +54,11 @@ enum class LogLevel : int {
     Fatal = 4
 };
 
+enum class LogFileFormat : int {
+    Text   = 0,
+    Binary = 1
+};
+
 struct LogEntry {
     int64_t     timestampMs;   // milliseconds since epoch
     LogLevel    level;
@@ -22,14 +66,80 @@ struct LogEntry {
     std::string source;        // class::function
     std::string message;
     std::string stackTrace;    // only for Error/Fatal
+    uint64_t    seq{ 0 };      // 1, 2, 3, ... in the order entries reach the UI ring
 };
 
+#if ACP_LOG_HAS_FORMAT
+namespace logdetail {
+
+// Argument types LOGF_* can carry by value to the writer thread; anything
+// else is formatted on the calling thread.
+template <typename T>
+inline constexpr bool kIsText = std::is_same_v<T, const char*> || std::is_same_v<T, char*> ||
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+template <typename T>
+inline constexpr bool kIsValue = std::is_arithmetic_v<T> || std::is_same_v<T, const void*>;
+template <typename T>
+inline constexpr bool kDeferrable = kIsText<T> || kIsValue<T>;
+
+template <typename T>
+using Decoded = std::conditional_t<kIsText<T>, std::string_view, T>;
+
+inline std::string_view TextOf(const char* s) { return s ? std::string_view(s) : std::string_view("(null)"); }
+inline std::string_view TextOf(std::string_view s) { return s; }
+
+// Arguments use the tagged encoding from LogFormat.h, so the binary file sink
+// can store them as they are.
+template <typename T>
+size_t MaxEncodedSize(const T& v) {
+    if constexpr (kIsText<T>) return logfmt::MaxStrBytes(TextOf(v).size());
+    else return logfmt::kMaxScalarBytes;
+}
+
+template <typename T>
+char* Encode(char* out, const T& v) {
+    if constexpr (kIsText<T>) return logfmt::PutStr(out, TextOf(v));
+    else if constexpr (std::is_same_v<T, bool>) return logfmt::PutUInt(out, v, logfmt::ArgTag::Bool);
+    else if constexpr (std::is_same_v<T, char>) return logfmt::PutUInt(out, static_cast<unsigned char>(v), logfmt::ArgTag::Char);
+    else if constexpr (std::is_floating_point_v<T>) return logfmt::PutFloat(out, static_cast<double>(v));
+    else if constexpr (std::is_pointer_v<T>) return logfmt::PutUInt(out, reinterpret_cast<uintptr_t>(v), logfmt::ArgTag::Ptr);
+    else if constexpr (std::is_signed_v<T>) return logfmt::PutInt(out, v);
+    else return logfmt::PutUInt(out, v);
+}
+
+// The stream was written by Encode<T>, so the tag always matches T.
+template <typename T>
+Decoded<T> Decode(const char*& in, const char* end) {
+    logfmt::ArgValue v;
+    logfmt::NextArg(in, end, v);
+    if constexpr (kIsText<T>) return v.s;
+    else if constexpr (std::is_floating_point_v<T>) return static_cast<T>(v.f);
+    else if constexpr (std::is_pointer_v<T>) return reinterpret_cast<T>(static_cast<uintptr_t>(v.u));
+    else if constexpr (std::is_signed_v<T> && !std::is_same_v<T, char>) return static_cast<T>(v.i);
+    else return static_cast<T>(v.u);
+}
+
+using FormatFn = void (*)(std::string_view args, std::string_view fmt, std::string& out);
+
+template <typename... Args>
+void FormatDeferred(std::string_view args, std::string_view fmt, std::string& out) {
+    const char* in = args.data();
+    const char* end = in + args.size();
+    // Braced initialisation decodes left to right.
+    std::tuple<Decoded<Args>...> values{ Decode<Args>(in, end)... };
+    std::apply([&](auto&... v) { std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(v...)); }, values);
+}
+
+} // namespace logdetail
+#endif
+
 class Logger {
 public:
     static Logger& Instance();
 
     void SetLevel(LogLevel level);
     LogLevel GetLevel() const;
+    bool IsEnabled(LogLevel level) const { return level >= level_.load(std::memory_order_relaxed); }
 
     void SetMaxEntries(int max);
     int  GetMaxEntries() const;
@@ -37,39 +147,179 @@ public:
     void SetFileOutput(bool enabled, const std::string& path = "autoclicker.log");
     bool IsFileOutputEnabled() const;
     std::string GetFilePath() const;
+    void SetFileFormat(LogFileFormat format);
+    LogFileFormat GetFileFormat() const;
+    // Once the file would grow past maxBytes it is renamed to path.1 (older
+    // ones shift up to path.<maxFiles-1>) and a new one started. maxBytes <= 0
+    // disables rotation.
+    void SetFileRotation(int64_t maxBytes, int maxFiles);
 
     void Log(LogLevel level, const char* source, const char* fmt, ...);
     void LogWithStack(LogLevel level, const char* source, const char* message, const char* stack);
 
+#if ACP_LOG_HAS_FORMAT
+    template <typename... Args>
+    void Format(LogLevel level, const char* source, std::format_string<Args...> fmt, Args&&... args) {
+        if (!IsEnabled(level)) return;
+        if constexpr ((logdetail::kDeferrable<std::decay_t<Args>> && ...)) {
+            const size_t bytes = (size_t{ 0 } + ... + logdetail::MaxEncodedSize<std::decay_t<Args>>(args));
+            if (char* out = BeginDeferred(source, bytes, &logdetail::FormatDeferred<std::decay_t<Args>...>, fmt.get())) {
+                ((out = logdetail::Encode<std::decay_t<Args>>(out, args)), ...);
+                CommitDeferred(level, out);
+                return;
+            }
+        }
+        const std::string message = std::vformat(fmt.get(), std::make_format_args(args...));
+        Log(level, source, "%.*s", static_cast<int>(message.size()), message.data());
+    }
+#endif
+
+    // Blocks until everything logged before the call is in the UI ring and,
+    // with file output on, written to the file.
+    void Flush();
+
     void Clear();
     std::vector<LogEntry> GetEntries() const;
     std::vector<LogEntry> GetEntries(LogLevel minLevel) const;
+    // Entries with seq > afterSeq still in the ring, oldest first. Pollers keep
+    // the last seq they saw and only copy what is new.
+    std::vector<LogEntry> GetEntriesSince(uint64_t afterSeq, LogLevel minLevel = LogLevel::Debug) const;
+    // seq of the oldest entry still in the ring (LastSequence() + 1 when it is
+    // empty); anything older was dropped by the ring bound or Clear().
+    uint64_t OldestSequence() const;
+    uint64_t LastSequence() const;
     size_t EntryCount() const;
 
     static const char* LevelName(LogLevel level);
     static std::string FormatTimestamp(int64_t ms);
 
 private:
+    struct ThreadQueue;
+    // Drained entry; qpc restores the order of calls across threads. Entries
+    // logged with a format string keep it and their tagged arguments for the
+    // binary sink.
+    struct Pending {
+        int64_t  qpc;
+        LogEntry entry;
+        logfmt::FormatStyle style{ logfmt::FormatStyle::Text };
+        std::string fmt;
+        std::string args;
+    };
+
     Logger();
     ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    void WriteToFile(const LogEntry& entry);
-    void OpenLogFileLocked();   // (re)open file_ based on filePath_; must be called under mutex_
+    ThreadQueue& LocalQueue();
+    void PushFallback(Pending&& pending);
+    // Publishes the record in q's scratch; a full ring sends it to the fallback queue.
+    void PushRecord(ThreadQueue& q, size_t slots);
+    static Pending DecodeRecord(const void* record);
+#if ACP_LOG_HAS_FORMAT
+    // Starts a deferred record in this thread's scratch and returns where the
+    // encoded arguments go, or nullptr if they might not fit in one record.
+    char* BeginDeferred(const char* source, size_t maxArgBytes, logdetail::FormatFn fn, std::string_view fmt);
+    void CommitDeferred(LogLevel level, const char* argsEnd);
+#endif
+    void WriterMain();
+    void Drain(std::vector<Pending>& batch);
+    void Publish(std::vector<Pending>& batch);
+    void AppendEntry(LogEntry&& entry);   // must be called under mutex_
+
+    void WriteToFile(const std::vector<Pending>& batch);
+    void AppendBinary(std::string& out, const Pending& p);
+    // The helpers below must be called under fileMutex_.
+    void OpenLogFileLocked();   // (re)open file_ based on filePath_
+    void RotateFilesLocked();   // shift path -> path.1 -> ... and drop the oldest
 
+    std::atomic<LogLevel> level_{ LogLevel::Info };
+
+    // UI ring: entries_ grows to maxEntries_, then wraps at ringHead_ (oldest).
     mutable std::mutex mutex_;
-    std::deque<LogEntry> entries_;
-    LogLevel level_{ LogLevel::Info };
+    std::vector<LogEntry> entries_;
+    size_t ringHead_{ 0 };
     int maxEntries_{ 10000 };
+    uint64_t lastSeq_{ 0 };         // seq of the newest entry; never reset
+
+    mutable std::mutex fileMutex_;
     bool fileOutput_{ false };
     std::string filePath_{ "autoclicker.log" };
     std::ofstream file_;            // kept open while fileOutput_ is true
+    LogFileFormat fileFormat_{ LogFileFormat::Text };
+    int64_t maxFileBytes_{ 16 * 1024 * 1024 };
+    int maxFiles_{ 5 };
+    int64_t fileBytes_{ 0 };        // size of the open file
+    logfmt::BinaryWriter binary_;   // interning state of the open binary file
+
+    // Producer queues, one per logging thread, plus the overflow path.
+    std::mutex queuesMutex_;
+    std::vector<std::shared_ptr<ThreadQueue>> queues_;
+    std::vector<Pending> fallback_;
+
+    // Writer thread and flush handshake (flushRequested_/flushDone_ are tickets).
+    std::mutex writerMutex_;
+    std::condition_variable writerCv_;
+    std::condition_variable flushedCv_;
+    uint64_t flushRequested_{ 0 };
+    uint64_t flushDone_{ 0 };
+    bool stopWriter_{ false };
+    std::thread writer_;
 };
 
-// Convenience macros
-#define LOG_DEBUG(src, ...) Logger::Instance().Log(LogLevel::Debug, src, __VA_ARGS__)
-#define LOG_INFO(src, ...)  Logger::Instance().Log(LogLevel::Info,  src, __VA_ARGS__)
-#define LOG_WARN(src, ...)  Logger::Instance().Log(LogLevel::Warn,  src, __VA_ARGS__)
-#define LOG_ERROR(src, ...) Logger::Instance().Log(LogLevel::Error, src, __VA_ARGS__)
-#define LOG_FATAL(src, ...) Logger::Instance().Log(LogLevel::Fatal, src, __VA_ARGS__)
+// Convenience macros. Arguments are only evaluated when the level is enabled.
+#define ACP_LOG_CALL(lvl, fn, src, ...) \
+    do { \
+        Logger& acpLogger_ = Logger::Instance(); \
+        if (acpLogger_.IsEnabled(lvl)) acpLogger_.fn(lvl, src, __VA_ARGS__); \
+    } while (0)
+// Compiled out: the call is type-checked (and keeps its variables "used") but never emitted.
+#define ACP_LOG_STRIPPED(lvl, fn, src, ...) \
+    do { if constexpr (false) Logger::Instance().fn(lvl, src, __VA_ARGS__); } while (0)
+
+#if ACP_LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(src, ...) ACP_LOG_CALL(LogLevel::Debug, Log, src, __VA_ARGS__)
+#else
+#define LOG_DEBUG(src, ...) ACP_LOG_STRIPPED(LogLevel::Debug, Log, src, __VA_ARGS__)
+#endif
+#if ACP_LOG_MIN_LEVEL <= 1
+#define LOG_INFO(src, ...)  ACP_LOG_CALL(LogLevel::Info,  Log, src, __VA_ARGS__)
+#else
+#define LOG_INFO(src, ...)  ACP_LOG_STRIPPED(LogLevel::Info, Log, src, __VA_ARGS__)
+#endif
+#if ACP_LOG_MIN_LEVEL <= 2
+#define LOG_WARN(src, ...)  ACP_LOG_CALL(LogLevel::Warn,  Log, src, __VA_ARGS__)
+#else
+#define LOG_WARN(src, ...)  ACP_LOG_STRIPPED(LogLevel::Warn, Log, src, __VA_ARGS__)
+#endif
+#if ACP_LOG_MIN_LEVEL <= 3
+#define LOG_ERROR(src, ...) ACP_LOG_CALL(LogLevel::Error, Log, src, __VA_ARGS__)
+#else
+#define LOG_ERROR(src, ...) ACP_LOG_STRIPPED(LogLevel::Error, Log, src, __VA_ARGS__)
+#endif
+#define LOG_FATAL(src, ...) ACP_LOG_CALL(LogLevel::Fatal, Log, src, __VA_ARGS__)
+
+#if ACP_LOG_HAS_FORMAT
+// std::format-style: LOGF_INFO("Replayer::Start", "{} events at {:.1f}x", n, speed)
+#if ACP_LOG_MIN_LEVEL <= 0
+#define LOGF_DEBUG(src, ...) ACP_LOG_CALL(LogLevel::Debug, Format, src, __VA_ARGS__)
+#else
+#define LOGF_DEBUG(src, ...) ACP_LOG_STRIPPED(LogLevel::Debug, Format, src, __VA_ARGS__)
+#endif
+#if ACP_LOG_MIN_LEVEL <= 1
+#define LOGF_INFO(src, ...)  ACP_LOG_CALL(LogLevel::Info,  Format, src, __VA_ARGS__)
+#else
+#define LOGF_INFO(src, ...)  ACP_LOG_STRIPPED(LogLevel::Info, Format, src, __VA_ARGS__)
+#endif
+#if ACP_LOG_MIN_LEVEL <= 2
+#define LOGF_WARN(src, ...)  ACP_LOG_CALL(LogLevel::Warn,  Format, src, __VA_ARGS__)
+#else
+#define LOGF_WARN(src, ...)  ACP_LOG_STRIPPED(LogLevel::Warn, Format, src, __VA_ARGS__)
+#endif
+#if ACP_LOG_MIN_LEVEL <= 3
+#define LOGF_ERROR(src, ...) ACP_LOG_CALL(LogLevel::Error, Format, src, __VA_ARGS__)
+#else
+#define LOGF_ERROR(src, ...) ACP_LOG_STRIPPED(LogLevel::Error, Format, src, __VA_ARGS__)
+#endif
+#define LOGF_FATAL(src, ...) ACP_LOG_CALL(LogLevel::Fatal, Format, src, __VA_ARGS__)
+#endif
@@ -21,9 +21,10 @@ extern "C" {
 #include "core/HighPrecisionWait.h"
 #include "core/InputUtils.h"
 #include "core/Logger.h"
-#include "core/Recorder.h"
 #include "core/Replayer.h"
 #include "core/StringUtils.h"
+#include "core/TrcCodec.h"
+#include "core/TrcIO.h"
 #include "core/WinAutomation.h"
 
 static void SendMouseWheelBestEffort(int delta, bool horizontal) {
@@ -94,7 +95,8 @@ static std::string ReadFileUtf8(const std::wstring& filename) {
 
 const std::vector<LuaEngine::LuaApiDoc>& LuaEngine::ApiDocs() {
     static const std::vector<LuaApiDoc> docs = {
-        { "playback", "playback(path_trc)", "回放", "回放一个 .trc 文件" },
+        { "playback", "playback(path_trc, start_ms?)", "回放", "回放一个 .trc 文件，可从 start_ms 毫秒处开始" },
+        { "play_events", "play_events(packed) -> boolean", "回放", "回放紧凑导出的打包事件数据，播放完毕后返回" },
         { "human_move", "human_move(x, y[, duration_ms])", "拟人", "拟人方式移动鼠标" },
         { "human_click", "human_click(btn[, x, y])", "拟人", "拟人方式点击鼠标" },
         { "human_scroll", "human_scroll(delta[, x, y])", "拟人", "拟人方式滚动" },
@@ -249,7 +251,9 @@ const std::vector<LuaEngine::LuaApiDoc>& LuaEngine::ApiDocs() {
     return docs;
 }
 
-LuaEngine::LuaEngine() = default;
+LuaEngine::LuaEngine() {
+    idle_.Set();
+}
 
 LuaEngine::~LuaEngine() {
     StopAsync();
@@ -313,7 +317,8 @@ bool LuaEngine::StartAsync(const std::string& code) {
     if (running_.load(std::memory_order_acquire)) return false;
     if (worker_.joinable()) worker_.join();
 
-    cancel_.store(false, std::memory_order_release);
+    cancel_.Reset();
+    idle_.Reset();
     running_.store(true, std::memory_order_release);
     currentLine_.store(0, std::memory_order_release);
     {
@@ -332,6 +337,7 @@ bool LuaEngine::StartAsync(const std::string& code) {
             lastError_ = "failed to create lua state";
             LOG_ERROR("LuaEngine::StartAsync", "Failed to create Lua state for async execution");
             running_.store(false, std::memory_order_release);
+            idle_.Set();
             return;
         }
 
@@ -351,6 +357,7 @@ bool LuaEngine::StartAsync(const std::string& code) {
             lua_pop(L, 1);
             lua_close(L);
             running_.store(false, std::memory_order_release);
+            idle_.Set();
             return;
         }
 
@@ -368,15 +375,17 @@ bool LuaEngine::StartAsync(const std::string& code) {
 
         lua_close(L);
         running_.store(false, std::memory_order_release);
+        idle_.Set();
     });
     return true;
 }
 
 void LuaEngine::StopAsync() {
     LOG_INFO("LuaEngine::StopAsync", "Stopping async script execution");
-    cancel_.store(true, std::memory_order_release);
+    cancel_.Set();
     if (worker_.joinable()) worker_.join();
     running_.store(false, std::memory_order_release);
+    idle_.Set();
 }
 
 bool LuaEngine::IsRunning() const {
@@ -401,6 +410,7 @@ LuaEngine* LuaEngine::Self(lua_State* L) {
 
 void LuaEngine::RegisterApi(lua_State* L) {
     lua_register(L, "playback", &LuaEngine::L_Playback);
+    lua_register(L, "play_events", &LuaEngine::L_PlayEvents);
     lua_register(L, "human_move", &LuaEngine::L_HumanMove);
     lua_register(L, "human_click", &LuaEngine::L_HumanClick);
     lua_register(L, "human_scroll", &LuaEngine::L_HumanScroll);
@@ -540,25 +550,13 @@ void LuaEngine::DebugHook(lua_State* L, lua_Debug* ar) {
     auto* self = Self(L);
     if (!self) return;
     self->currentLine_.store(ar->currentline, std::memory_order_release);
-    if (self->cancel_.load(std::memory_order_acquire)) {
+    if (self->cancel_.IsSet()) {
         luaL_error(L, "cancelled");
     }
 }
 
 void LuaEngine::WaitMicrosCancelable(int64_t us) {
-    if (us <= 0) return;
-    const int64_t start = timing::MicrosNow();
-    while (true) {
-        if (cancel_.load(std::memory_order_acquire)) return;
-        const int64_t elapsed = timing::MicrosNow() - start;
-        const int64_t remaining = us - elapsed;
-        if (remaining <= 0) break;
-        if (remaining > 2000) {
-            Sleep(1);
-        } else {
-            std::this_thread::yield();
-        }
-    }
+    timing::Waiter::Instance().WaitFor(us, cancel_);
 }
 
 int LuaEngine::L_Playback(lua_State* L) {
@@ -566,19 +564,52 @@ int LuaEngine::L_Playback(lua_State* L) {
     if (!self || !self->replayer_) return 0;
     const char* s = luaL_checkstring(L, 1);
     std::wstring filename = Utf8ToWide(s ? s : "");
+    const lua_Integer startMs = luaL_optinteger(L, 2, 0);
 
-    Recorder tmp;
-    if (!tmp.LoadFromFile(filename)) {
+    auto view = trc::OpenTrcView(filename);
+    if (!view) {
         lua_pushboolean(L, 0);
         return 1;
     }
 
-    std::vector<trc::RawEvent> events = tmp.EventsCopy();
-    const bool started = self->replayer_->Start(std::move(events), false, self->replayer_->Speed());
+    const bool started = startMs > 0
+        ? self->replayer_->StartAt(std::move(view), static_cast<int64_t>(startMs) * 1000, false, self->replayer_->Speed())
+        : self->replayer_->Start(std::move(view), false, self->replayer_->Speed());
     lua_pushboolean(L, started ? 1 : 0);
     return 1;
 }
 
+// Events from the compact export run through the replayer like a .trc
+// replay (deadline schedule, batching, set_speed), so a whole chunk costs one
+// Lua call. Blocks until they have played; a script stop also stops them.
+int LuaEngine::L_PlayEvents(lua_State* L) {
+    auto* self = Self(L);
+    if (!self || !self->replayer_) return 0;
+    size_t len = 0;
+    const char* s = luaL_checklstring(L, 1, &len);
+
+    std::vector<trc::RawEvent> events;
+    if (!trc::UnpackEventsText(std::string_view(s, len), events)) return luaL_error(L, "play_events: invalid event data");
+    if (events.empty()) {
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+    if (!self->replayer_->Start(std::move(events), false, self->replayer_->Speed())) {
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+    // Wait on the script's cancel event too, so Ctrl+F12 stops the playback
+    // immediately instead of after the whole chunk.
+    const HANDLE handles[2] = { self->replayer_->IdleEvent().NativeHandle(), self->cancel_.NativeHandle() };
+    WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+    if (self->cancel_.IsSet()) {
+        self->replayer_->Stop();
+        return luaL_error(L, "cancelled");
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
 int LuaEngine::L_HumanMove(lua_State* L) {
     const int x = static_cast<int>(luaL_checkinteger(L, 1));
     const int y = static_cast<int>(luaL_checkinteger(L, 2));
@@ -622,7 +653,7 @@ int LuaEngine::L_WaitMs(lua_State* L) {
     if (!self) return 0;
     const int64_t ms = static_cast<int64_t>(luaL_checkinteger(L, 1));
     self->WaitMicrosCancelable(std::max<int64_t>(0, ms) * 1000);
-    if (self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+    if (self->cancel_.IsSet()) luaL_error(L, "cancelled");
     return 0;
 }
 
@@ -631,7 +662,7 @@ int LuaEngine::L_WaitUs(lua_State* L) {
     if (!self) return 0;
     const int64_t us = static_cast<int64_t>(luaL_checkinteger(L, 1));
     self->WaitMicrosCancelable(std::max<int64_t>(0, us));
-    if (self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+    if (self->cancel_.IsSet()) luaL_error(L, "cancelled");
     return 0;
 }
 
@@ -780,7 +811,7 @@ int LuaEngine::L_WindowWait(lua_State* L) {
         }
         if (self) {
             self->WaitMicrosCancelable(std::max<int64_t>(0, intervalMs) * 1000);
-            if (self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+            if (self->cancel_.IsSet()) luaL_error(L, "cancelled");
         } else {
             Sleep(static_cast<DWORD>(std::clamp<int64_t>(intervalMs, 0, 1000)));
         }
@@ -1013,23 +1044,19 @@ int LuaEngine::L_ProcessWait(lua_State* L) {
     HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, pid);
     if (!h) { lua_pushboolean(L, 0); return 1; }
 
-    // Poll in small slices so the user can stop the script with Ctrl+F12
-    // while waiting on a long-running process.
-    const uint32_t sliceMs = 50;
-    uint32_t waited = 0;
-    bool exited = false;
-    while (waited < timeoutMs) {
-        if (self && self->cancel_.load(std::memory_order_acquire)) break;
-        const uint32_t left = timeoutMs - waited;
-        const uint32_t step = left < sliceMs ? left : sliceMs;
-        const DWORD r = WaitForSingleObject(h, step);
-        if (r == WAIT_OBJECT_0) { exited = true; break; }
-        if (r != WAIT_TIMEOUT) break;
-        waited += step;
+    // Wait on the script's cancel event too, so Ctrl+F12 stops the script
+    // immediately while it waits on a long-running process.
+    DWORD r = WAIT_FAILED;
+    if (self) {
+        const HANDLE handles[2] = { h, self->cancel_.NativeHandle() };
+        r = WaitForMultipleObjects(2, handles, FALSE, timeoutMs);
+    } else {
+        r = WaitForSingleObject(h, timeoutMs);
     }
+    const bool exited = (r == WAIT_OBJECT_0);
     CloseHandle(h);
 
-    if (self && self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+    if (self && self->cancel_.IsSet()) luaL_error(L, "cancelled");
     lua_pushboolean(L, exited ? 1 : 0);
     return 1;
 }
@@ -1142,7 +1169,7 @@ int LuaEngine::L_ColorWait(lua_State* L) {
         }
         if (self) {
             self->WaitMicrosCancelable(std::max<int64_t>(0, intervalMs) * 1000);
-            if (self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+            if (self->cancel_.IsSet()) luaL_error(L, "cancelled");
         } else {
             Sleep(static_cast<DWORD>(std::clamp<int64_t>(intervalMs, 0, 1000)));
         }
@@ -1414,7 +1441,7 @@ int LuaEngine::L_VkPress(lua_State* L) {
     auto* self = Self(L);
     if (self) {
         self->WaitMicrosCancelable(std::max<int64_t>(0, holdMs) * 1000);
-        if (self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+        if (self->cancel_.IsSet()) luaL_error(L, "cancelled");
     } else {
         timing::HighPrecisionWaitMicros(std::max<int64_t>(0, holdMs) * 1000);
     }
@@ -1433,7 +1460,7 @@ int LuaEngine::L_Text(lua_State* L) {
     w.resize(static_cast<size_t>(len));
     MultiByteToWideChar(CP_UTF8, 0, s, -1, w.data(), len);
     SendTextUtf16(w.c_str(), static_cast<int>(w.size() - 1));
-    if (self && self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+    if (self && self->cancel_.IsSet()) luaL_error(L, "cancelled");
     return 0;
 }
 
@@ -1838,6 +1865,6 @@ int LuaEngine::L_Sleep(lua_State* L) {
     if (!self) return 0;
     int64_t ms = luaL_checkinteger(L, 1);
     self->WaitMicrosCancelable(std::max<int64_t>(0, ms) * 1000);
-    if (self->cancel_.load(std::memory_order_acquire)) luaL_error(L, "cancelled");
+    if (self->cancel_.IsSet()) luaL_error(L, "cancelled");
     return 0;
 }
@@ -6,6 +6,8 @@
 #include <thread>
 #include <vector>
 
+#include "core/SyncEvent.h"
+
 struct lua_State;
 
 class Replayer;
@@ -34,12 +36,16 @@ public:
     bool StartAsync(const std::string& code);
     void StopAsync();
     bool IsRunning() const;
+    // Set whenever no StartAsync() script is running; wait on it (alone or
+    // together with other handles) to learn when a run has finished.
+    const threading::Event& IdleEvent() const { return idle_; }
     int CurrentLine() const;
     std::string LastError() const;
     static const std::vector<LuaApiDoc>& ApiDocs();
 
 private:
     static int L_Playback(lua_State* L);
+    static int L_PlayEvents(lua_State* L);
     static int L_HumanMove(lua_State* L);
     static int L_HumanClick(lua_State* L);
     static int L_HumanScroll(lua_State* L);
@@ -180,7 +186,8 @@ private:
     Replayer* replayer_{ nullptr };
 
     std::atomic<bool> running_{ false };
-    std::atomic<bool> cancel_{ false };
+    threading::Event cancel_;   // set by StopAsync; wakes any wait in the script
+    threading::Event idle_;     // set whenever running_ is false
     std::atomic<int> currentLine_{ 0 };
     mutable std::mutex errorMutex_;
     std::string lastError_;
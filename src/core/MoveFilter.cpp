@@ -0,0 +1,152 @@
+#include "core/MoveFilter.h"
+
+static bool IsMove(const trc::RawEvent& e) {
+    return e.type == static_cast<uint8_t>(trc::EventType::MouseMove);
+}
+
+// Mouse buttons and wheel carry the cursor position; keys carry vk/scan codes.
+static bool CarriesCursor(const trc::RawEvent& e) {
+    const auto type = static_cast<trc::EventType>(e.type);
+    return type == trc::EventType::MouseDown || type == trc::EventType::MouseUp || type == trc::EventType::Wheel;
+}
+
+void MoveFilter::Configure(const MoveFilterConfig& config) {
+    config_ = config;
+    Reset();
+}
+
+void MoveFilter::Reset() {
+    hasAnchor_ = false;
+    anchorX_ = 0;
+    anchorY_ = 0;
+    pendingMicros_ = 0;
+    hasHeld_ = false;
+    held_ = {};
+    windowSize_ = 0;
+    inputMoves_ = 0;
+    outputMoves_ = 0;
+}
+
+size_t MoveFilter::Push(const trc::RawEvent& e, trc::RawEvent* out) {
+    if (config_.mode == MoveFilterMode::Off) {
+        if (IsMove(e)) {
+            ++inputMoves_;
+            ++outputMoves_;
+        }
+        out[0] = e;
+        return 1;
+    }
+
+    if (!IsMove(e)) {
+        size_t n = EmitHeld(out);
+        trc::RawEvent ev = e;
+        ev.timeDelta += pendingMicros_;
+        pendingMicros_ = 0;
+        out[n++] = ev;
+        if (CarriesCursor(e)) {
+            hasAnchor_ = true;
+            anchorX_ = e.x;
+            anchorY_ = e.y;
+        }
+        windowSize_ = 0;
+        return n;
+    }
+
+    ++inputMoves_;
+    size_t n = 0;
+    if (config_.mode == MoveFilterMode::RdpLite && hasHeld_ && (windowSize_ == kRdpWindow || !RdpFits(e))) {
+        // The chord to e would cut a corner: keep the last point that still
+        // fit, even if the hold time has run out and e is kept as well.
+        n = EmitHeld(out);
+    }
+
+    pendingMicros_ += e.timeDelta;
+    if (!hasAnchor_ || KeepMove(e)) {
+        hasHeld_ = false;
+        windowSize_ = 0;
+        trc::RawEvent ev = e;
+        ev.timeDelta = pendingMicros_;
+        pendingMicros_ = 0;
+        out[n++] = ev;
+        Emitted(ev);
+        return n;
+    }
+
+    held_ = e;
+    hasHeld_ = true;
+    if (config_.mode == MoveFilterMode::RdpLite) {
+        windowX_[windowSize_] = e.x;
+        windowY_[windowSize_] = e.y;
+        ++windowSize_;
+    }
+    return n;
+}
+
+size_t MoveFilter::Flush(trc::RawEvent* out) {
+    return EmitHeld(out);
+}
+
+bool MoveFilter::KeepMove(const trc::RawEvent& m) const {
+    switch (config_.mode) {
+    case MoveFilterMode::MinInterval:
+        return pendingMicros_ >= config_.minIntervalMicros;
+    case MoveFilterMode::MinDistance: {
+        const int64_t dx = static_cast<int64_t>(m.x) - anchorX_;
+        const int64_t dy = static_cast<int64_t>(m.y) - anchorY_;
+        const int64_t d = config_.minDistancePx;
+        return dx * dx + dy * dy >= d * d || pendingMicros_ >= config_.maxHoldMicros;
+    }
+    case MoveFilterMode::RdpLite:
+        return pendingMicros_ >= config_.maxHoldMicros;
+    default:
+        return true;
+    }
+}
+
+// True if every dropped point since the anchor lies within the tolerance of
+// the segment anchor -> m (segment, not line, so reversals are kept).
+bool MoveFilter::RdpFits(const trc::RawEvent& m) const {
+    const double ax = anchorX_;
+    const double ay = anchorY_;
+    const double dx = m.x - ax;
+    const double dy = m.y - ay;
+    const double len2 = dx * dx + dy * dy;
+    const double tol2 = config_.rdpTolerancePx * config_.rdpTolerancePx;
+    for (size_t i = 0; i < windowSize_; ++i) {
+        const double px = windowX_[i] - ax;
+        const double py = windowY_[i] - ay;
+        double dist2 = 0.0;
+        const double t = len2 > 0.0 ? (px * dx + py * dy) / len2 : 0.0;
+        if (t <= 0.0) {
+            dist2 = px * px + py * py;
+        } else if (t >= 1.0) {
+            const double qx = px - dx;
+            const double qy = py - dy;
+            dist2 = qx * qx + qy * qy;
+        } else {
+            const double cross = dx * py - dy * px;
+            dist2 = cross * cross / len2;
+        }
+        if (dist2 > tol2) return false;
+    }
+    return true;
+}
+
+size_t MoveFilter::EmitHeld(trc::RawEvent* out) {
+    if (!hasHeld_) return 0;
+    trc::RawEvent ev = held_;
+    ev.timeDelta = pendingMicros_;
+    pendingMicros_ = 0;
+    hasHeld_ = false;
+    windowSize_ = 0;
+    out[0] = ev;
+    Emitted(ev);
+    return 1;
+}
+
+void MoveFilter::Emitted(const trc::RawEvent& e) {
+    hasAnchor_ = true;
+    anchorX_ = e.x;
+    anchorY_ = e.y;
+    ++outputMoves_;
+}
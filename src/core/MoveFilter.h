@@ -0,0 +1,79 @@
+#pragma once
+// MoveFilter.h — online MouseMove coalescing applied at record time.
+// Only MouseMove events are ever dropped; clicks, keys and wheel events pass
+// through unchanged and in order. The time of dropped moves is carried into
+// the next emitted event, so total duration and the timing of every non-move
+// event are preserved exactly. The last move before a non-move event is
+// always emitted first so the cursor is where the click/key happened.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "core/TrcFormat.h"
+
+enum class MoveFilterMode : int {
+    Off         = 0,
+    MinInterval = 1,   // at most one move per minIntervalMicros
+    MinDistance = 2,   // drop moves closer than minDistancePx to the last kept one
+    RdpLite     = 3    // streaming Douglas-Peucker: drop points within rdpTolerancePx of the chord
+};
+
+struct MoveFilterConfig {
+    MoveFilterMode mode{ MoveFilterMode::Off };
+    int64_t minIntervalMicros{ 4000 };
+    int minDistancePx{ 2 };
+    double rdpTolerancePx{ 1.0 };
+    // MinDistance/RdpLite: never hold a move back longer than this, so slow
+    // drags and pauses keep a reasonable time resolution.
+    int64_t maxHoldMicros{ 50000 };
+};
+
+struct MoveFilterStats {
+    uint64_t inputMoves{ 0 };
+    uint64_t outputMoves{ 0 };
+    // Input moves per stored move (1.0 when nothing was dropped).
+    double Ratio() const { return outputMoves ? static_cast<double>(inputMoves) / static_cast<double>(outputMoves) : 1.0; }
+};
+
+class MoveFilter {
+public:
+    static constexpr size_t kMaxOutput = 2;
+
+    void Configure(const MoveFilterConfig& config);
+    const MoveFilterConfig& Config() const { return config_; }
+    void Reset();
+
+    // Feeds one event; writes 0..kMaxOutput events to out and returns the count.
+    size_t Push(const trc::RawEvent& e, trc::RawEvent* out);
+    // Emits the held-back move, if any (call when recording stops).
+    size_t Flush(trc::RawEvent* out);
+
+    uint64_t InputMoves() const { return inputMoves_; }
+    uint64_t OutputMoves() const { return outputMoves_; }
+
+private:
+    static constexpr size_t kRdpWindow = 64;
+
+    bool KeepMove(const trc::RawEvent& m) const;
+    bool RdpFits(const trc::RawEvent& m) const;
+    size_t EmitHeld(trc::RawEvent* out);
+    void Emitted(const trc::RawEvent& e);
+
+    MoveFilterConfig config_{};
+
+    bool hasAnchor_{ false };
+    int32_t anchorX_{ 0 };   // last emitted cursor position
+    int32_t anchorY_{ 0 };
+    int64_t pendingMicros_{ 0 };   // time since the last emitted event
+
+    bool hasHeld_{ false };
+    trc::RawEvent held_{};
+
+    // RdpLite: moves dropped since the anchor, checked against each new chord.
+    int32_t windowX_[kRdpWindow]{};
+    int32_t windowY_[kRdpWindow]{};
+    size_t windowSize_{ 0 };
+
+    uint64_t inputMoves_{ 0 };
+    uint64_t outputMoves_{ 0 };
+};
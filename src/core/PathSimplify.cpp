@@ -0,0 +1,309 @@
+#include "core/PathSimplify.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ACP_PATH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX/SSE4.1 instructions in functions marked for
+// them; MSVC allows the intrinsics anywhere.
+#if defined(ACP_PATH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ACP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ACP_TARGET(isa)
+#endif
+
+namespace {
+
+constexpr size_t kNone = SIZE_MAX;
+constexpr size_t kMinPointsPerThread = 32 * 1024;
+
+ChordScan ScanScalar(const int32_t* xs, const int32_t* ys, size_t begin, size_t end, double dx, double dy, double c) {
+    ChordScan best{ 0.0, kNone };
+    for (size_t i = begin; i < end; ++i) {
+        const double cross = std::abs(dy * xs[i] - dx * ys[i] + c);
+        if (cross > best.cross) {
+            best.cross = cross;
+            best.index = i;
+        }
+    }
+    return best;
+}
+
+#if defined(ACP_PATH_X86)
+
+// The vector loops only track the maximum of each block of kBlock points
+// (max has no dependency on the index, unlike a compare-and-blend per lane).
+// A block whose maximum strictly beats the best so far is rescanned for the
+// first point equal to that maximum, which is the point the scalar loop
+// would settle on; other blocks cannot change its answer. The rescan is
+// vectorized too, so a path moving steadily away from the chord (every
+// block a new best) costs at most two passes.
+constexpr size_t kBlock = 64;
+
+// Points after the blocks; they only replace the best on a strictly larger
+// value, like in the scalar loop.
+ChordScan ScanTail(ChordScan best, const int32_t* xs, const int32_t* ys, size_t begin, size_t end, double dx, double dy, double c) {
+    const ChordScan tail = ScanScalar(xs, ys, begin, end, dx, dy, c);
+    return tail.cross > best.cross ? tail : best;
+}
+
+// |dy*x - dx*y + c| for points j..j+3, with the same operations in the same
+// order as the scalar loop (no FMA).
+ACP_TARGET("avx")
+inline __m256d CrossAvx(const int32_t* xs, const int32_t* ys, size_t j, __m256d dx, __m256d dy, __m256d c, __m256d signBit) {
+    const __m256d x = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + j)));
+    const __m256d y = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + j)));
+    return _mm256_andnot_pd(signBit, _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(dy, x), _mm256_mul_pd(dx, y)), c));
+}
+
+ACP_TARGET("avx")
+ChordScan ScanAvx(const int32_t* xs, const int32_t* ys, size_t begin, size_t end, double dx, double dy, double c) {
+    const __m256d vdx = _mm256_set1_pd(dx);
+    const __m256d vdy = _mm256_set1_pd(dy);
+    const __m256d vc = _mm256_set1_pd(c);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    ChordScan best{ 0.0, kNone };
+
+    size_t i = begin;
+    for (; i + kBlock <= end; i += kBlock) {
+        // Two accumulators (points j..j+3 and j+4..j+7) hide the max latency.
+        __m256d maxA = _mm256_setzero_pd();
+        __m256d maxB = _mm256_setzero_pd();
+        for (size_t j = i; j < i + kBlock; j += 8) {
+            maxA = _mm256_max_pd(maxA, CrossAvx(xs, ys, j, vdx, vdy, vc, signBit));
+            maxB = _mm256_max_pd(maxB, CrossAvx(xs, ys, j + 4, vdx, vdy, vc, signBit));
+        }
+        const __m256d m4 = _mm256_max_pd(maxA, maxB);
+        const __m128d m2 = _mm_max_pd(_mm256_castpd256_pd128(m4), _mm256_extractf128_pd(m4, 1));
+        const double blockMax = _mm_cvtsd_f64(_mm_max_sd(m2, _mm_unpackhi_pd(m2, m2)));
+        if (blockMax <= best.cross) continue;
+        const __m256d target = _mm256_set1_pd(blockMax);
+        for (size_t j = i;; j += 4) {
+            const int mask = _mm256_movemask_pd(_mm256_cmp_pd(CrossAvx(xs, ys, j, vdx, vdy, vc, signBit), target, _CMP_EQ_OQ));
+            if (mask != 0) {
+                best = ChordScan{ blockMax, j + static_cast<size_t>(std::countr_zero(static_cast<unsigned>(mask))) };
+                break;
+            }
+        }
+    }
+    _mm256_zeroupper();
+    return ScanTail(best, xs, ys, i, end, dx, dy, c);
+}
+
+// Same for the two points in the low half of x2/y2.
+ACP_TARGET("sse4.1")
+inline __m128d CrossSse41(__m128i x2, __m128i y2, __m128d dx, __m128d dy, __m128d c, __m128d signBit) {
+    const __m128d x = _mm_cvtepi32_pd(x2);
+    const __m128d y = _mm_cvtepi32_pd(y2);
+    return _mm_andnot_pd(signBit, _mm_add_pd(_mm_sub_pd(_mm_mul_pd(dy, x), _mm_mul_pd(dx, y)), c));
+}
+
+ACP_TARGET("sse4.1")
+ChordScan ScanSse41(const int32_t* xs, const int32_t* ys, size_t begin, size_t end, double dx, double dy, double c) {
+    const __m128d vdx = _mm_set1_pd(dx);
+    const __m128d vdy = _mm_set1_pd(dy);
+    const __m128d vc = _mm_set1_pd(c);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    ChordScan best{ 0.0, kNone };
+
+    size_t i = begin;
+    for (; i + kBlock <= end; i += kBlock) {
+        __m128d maxA = _mm_setzero_pd();
+        __m128d maxB = _mm_setzero_pd();
+        for (size_t j = i; j < i + kBlock; j += 4) {
+            const __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + j));
+            const __m128i y4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + j));
+            maxA = _mm_max_pd(maxA, CrossSse41(x4, y4, vdx, vdy, vc, signBit));
+            maxB = _mm_max_pd(maxB, CrossSse41(_mm_unpackhi_epi64(x4, x4), _mm_unpackhi_epi64(y4, y4), vdx, vdy, vc, signBit));
+        }
+        const __m128d m2 = _mm_max_pd(maxA, maxB);
+        const double blockMax = _mm_cvtsd_f64(_mm_max_sd(m2, _mm_unpackhi_pd(m2, m2)));
+        if (blockMax <= best.cross) continue;
+        const __m128d target = _mm_set1_pd(blockMax);
+        for (size_t j = i;; j += 2) {
+            const __m128i x2 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(xs + j));
+            const __m128i y2 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ys + j));
+            const int mask = _mm_movemask_pd(_mm_cmpeq_pd(CrossSse41(x2, y2, vdx, vdy, vc, signBit), target));
+            if (mask != 0) {
+                best = ChordScan{ blockMax, j + static_cast<size_t>(std::countr_zero(static_cast<unsigned>(mask))) };
+                break;
+            }
+        }
+    }
+    return ScanTail(best, xs, ys, i, end, dx, dy, c);
+}
+
+SimdLevel DetectSimdLevel() {
+#if defined(_MSC_VER)
+    int regs[4]{};
+    __cpuid(regs, 1);
+    const bool sse41 = (regs[2] & (1 << 19)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    // AVX also needs the OS to save the upper halves of the registers.
+    if (avx && osxsave && (_xgetbv(0) & 0x6) == 0x6) return SimdLevel::Avx;
+    return sse41 ? SimdLevel::Sse41 : SimdLevel::Scalar;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx")) return SimdLevel::Avx;
+    return __builtin_cpu_supports("sse4.1") ? SimdLevel::Sse41 : SimdLevel::Scalar;
+#endif
+}
+
+#else
+
+SimdLevel DetectSimdLevel() {
+    return SimdLevel::Scalar;
+}
+
+#endif
+
+// Farthest interior point of (start, end) from the chord start→end and
+// whether it lies beyond the tolerance. Distances stay squared or unscaled:
+// for a fixed chord |cross| / norm orders points like the distance itself,
+// so the norm (one sqrt) is only needed for the tolerance test.
+bool FarthestPoint(std::span<const int32_t> xs, std::span<const int32_t> ys, size_t start, size_t end,
+    double tolerance, SimdLevel level, size_t& index) {
+    const double x1 = xs[start];
+    const double y1 = ys[start];
+    const double x2 = xs[end];
+    const double y2 = ys[end];
+    const double dx = x2 - x1;
+    const double dy = y2 - y1;
+    const double norm2 = dx * dx + dy * dy;
+
+    if (norm2 == 0.0) {
+        // Closed loop: distance from the shared endpoint. Rare, so scalar.
+        double best = 0.0;
+        index = kNone;
+        for (size_t i = start + 1; i < end; ++i) {
+            const double ex = xs[i] - x1;
+            const double ey = ys[i] - y1;
+            const double d2 = ex * ex + ey * ey;
+            if (d2 > best) {
+                best = d2;
+                index = i;
+            }
+        }
+        return index != kNone && best > tolerance * tolerance;
+    }
+
+    const ChordScan scan = ScanChord(xs.data(), ys.data(), start + 1, end, dx, dy, x2 * y1 - y2 * x1, level);
+    index = scan.index;
+    return index != kNone && scan.cross * scan.cross > tolerance * tolerance * norm2;
+}
+
+} // namespace
+
+SimdLevel BestSimdLevel() {
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+ChordScan ScanChord(const int32_t* xs, const int32_t* ys, size_t begin, size_t end,
+    double dx, double dy, double c, SimdLevel level) {
+#if defined(ACP_PATH_X86)
+    if (level >= SimdLevel::Avx) return ScanAvx(xs, ys, begin, end, dx, dy, c);
+    if (level >= SimdLevel::Sse41) return ScanSse41(xs, ys, begin, end, dx, dy, c);
+#endif
+    return ScanScalar(xs, ys, begin, end, dx, dy, c);
+}
+
+size_t SimplifyRdp(std::span<const int32_t> xs, std::span<const int32_t> ys, double tolerance,
+    std::vector<uint8_t>& keep, RdpScratch& scratch) {
+    keep.resize(xs.size());
+    return SimplifyRdp(xs, ys, tolerance, std::span<uint8_t>(keep), scratch);
+}
+
+size_t SimplifyRdp(std::span<const int32_t> xs, std::span<const int32_t> ys, double tolerance,
+    std::span<uint8_t> keep, RdpScratch& scratch) {
+    const size_t n = xs.size();
+    if (n <= 2) {
+        std::fill(keep.begin(), keep.end(), uint8_t{ 1 });
+        return n;
+    }
+    std::fill(keep.begin(), keep.end(), uint8_t{ 0 });
+    keep[0] = 1;
+    keep[n - 1] = 1;
+    size_t kept = 2;
+
+    const SimdLevel level = BestSimdLevel();
+    auto& ranges = scratch.ranges;
+    ranges.clear();
+    ranges.emplace_back(0, n - 1);
+    while (!ranges.empty()) {
+        const auto [start, end] = ranges.back();
+        ranges.pop_back();
+        if (end <= start + 1) continue;
+        size_t index = 0;
+        if (!FarthestPoint(xs, ys, start, end, tolerance, level, index)) continue;
+        keep[index] = 1;
+        ++kept;
+        // The halves are independent, so the order they are processed in does
+        // not change the result.
+        ranges.emplace_back(index, end);
+        ranges.emplace_back(start, index);
+    }
+    return kept;
+}
+
+size_t SimplifyRdpSegments(std::span<const int32_t> xs, std::span<const int32_t> ys, std::span<const size_t> segmentStarts,
+    double tolerance, std::vector<uint8_t>& keep, unsigned threads) {
+    const size_t n = xs.size();
+    keep.resize(n);
+    if (n == 0) return 0;
+
+    // Segment k covers [bounds[k], bounds[k + 1]).
+    std::vector<size_t> bounds;
+    bounds.reserve(segmentStarts.size() + 2);
+    bounds.push_back(0);
+    for (const size_t s : segmentStarts) {
+        if (s > bounds.back() && s < n) bounds.push_back(s);
+    }
+    bounds.push_back(n);
+    const size_t segments = bounds.size() - 1;
+
+    // Longest segments first so a long drag does not start last and leave
+    // the other workers idle; each segment writes only its own slice of
+    // keep and its own count, so the result does not depend on scheduling.
+    std::vector<size_t> order(segments);
+    for (size_t k = 0; k < segments; ++k) order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return bounds[a + 1] - bounds[a] > bounds[b + 1] - bounds[b];
+    });
+    std::vector<size_t> kept(segments, 0);
+    std::atomic<size_t> next{ 0 };
+    const auto work = [&] {
+        RdpScratch scratch;
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < segments; i = next.fetch_add(1, std::memory_order_relaxed)) {
+            const size_t k = order[i];
+            const size_t begin = bounds[k];
+            const size_t count = bounds[k + 1] - begin;
+            kept[k] = SimplifyRdp(xs.subspan(begin, count), ys.subspan(begin, count), tolerance,
+                std::span<uint8_t>(keep).subspan(begin, count), scratch);
+        }
+    };
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // Threads only pay off once there is real work to split.
+    const size_t workers = n < kMinPointsPerThread ? 1 : std::min<size_t>({ threads, segments, n / kMinPointsPerThread });
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t w = 1; w < workers; ++w) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    size_t total = 0;
+    for (const size_t k : kept) total += k;
+    return total;
+}
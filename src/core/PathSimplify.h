@@ -0,0 +1,76 @@
+#pragma once
+// PathSimplify.h — Ramer–Douglas–Peucker simplification of cursor paths.
+// Iterative (an explicit stack of index ranges instead of one call frame per
+// kept point) and allocation-free once the caller's buffers have grown: kept
+// points are flagged in a byte array rather than collected in a set.
+//
+// Paths are structure-of-arrays so the distance scan, which is nearly all of
+// the work, can load x and y with SIMD. The scan picks AVX or SSE4.1 at run
+// time and gives bit-identical results to the scalar loop: the lanes do the
+// same double operations in the same order, and the index of the maximum is
+// resolved by the scalar loop itself (see ScanAvx).
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+struct CursorPath {
+    std::vector<int32_t> x;
+    std::vector<int32_t> y;
+    std::vector<int64_t> tMicros;
+
+    size_t Size() const { return x.size(); }
+    void Reserve(size_t n) {
+        x.reserve(n);
+        y.reserve(n);
+        tMicros.reserve(n);
+    }
+    void Push(int32_t px, int32_t py, int64_t t) {
+        x.push_back(px);
+        y.push_back(py);
+        tMicros.push_back(t);
+    }
+};
+
+// Buffers reused between calls; one per thread.
+struct RdpScratch {
+    std::vector<std::pair<size_t, size_t>> ranges;
+};
+
+// Sets keep[i] = 1 for every point RDP keeps at the given tolerance (in
+// pixels) and 0 for the rest; the first and last points are always kept.
+// xs and ys must be the same length. Returns the number of kept points.
+size_t SimplifyRdp(std::span<const int32_t> xs, std::span<const int32_t> ys, double tolerance,
+    std::vector<uint8_t>& keep, RdpScratch& scratch);
+// Same, writing into a caller-sized keep (keep.size() == xs.size()).
+size_t SimplifyRdp(std::span<const int32_t> xs, std::span<const int32_t> ys, double tolerance,
+    std::span<uint8_t> keep, RdpScratch& scratch);
+
+// Simplifies each segment [segmentStarts[k], segmentStarts[k + 1]) of the
+// path on its own (the last one runs to the end; starts must be ascending,
+// and 0 is implied), so both ends of every segment are kept. Segments are
+// spread over up to `threads` threads (0 = one per core); keep is the same
+// whatever the thread count. Returns the total number of kept points.
+size_t SimplifyRdpSegments(std::span<const int32_t> xs, std::span<const int32_t> ys, std::span<const size_t> segmentStarts,
+    double tolerance, std::vector<uint8_t>& keep, unsigned threads = 0);
+
+// ─── Distance scan (exposed for tests and benchmarks) ───────────────────────
+
+enum class SimdLevel : int {
+    Scalar = 0,
+    Sse41  = 1,
+    Avx    = 2
+};
+// Widest level this CPU (and OS) supports; detected once.
+SimdLevel BestSimdLevel();
+
+struct ChordScan {
+    double cross;   // largest |dy*x - dx*y + c|
+    size_t index;   // first point reaching it; SIZE_MAX if every value is 0
+};
+// Scans points [begin, end) against the chord with direction (dx, dy) and
+// offset c (the value of the expression at any point on the chord is 0).
+ChordScan ScanChord(const int32_t* xs, const int32_t* ys, size_t begin, size_t end,
+    double dx, double dy, double c, SimdLevel level);
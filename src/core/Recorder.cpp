@@ -2,14 +2,14 @@
 
 #include <algorithm>
 #include <cstring>
+#include <filesystem>
 #include <windows.h>
 
 #include "core/Logger.h"
+#include "core/StringUtils.h"
 #include "core/TrcIO.h"
 
-Recorder::Recorder() {
-    ring_.resize(1u << 18);
-}
+Recorder::Recorder() = default;
 
 Recorder::~Recorder() {
     Stop();
@@ -22,10 +22,65 @@ void Recorder::Start() {
     LOG_INFO("Recorder::Start", "Recording started");
 }
 
+bool Recorder::StartStreaming(const std::wstring& filename, size_t tailEvents, bool temporary) {
+    Clear();
+    auto writer = std::make_unique<trc::TrcWriter>();
+    if (!writer->Open(filename)) {
+        LOG_ERROR("Recorder::StartStreaming", "Failed to open stream file");
+        return false;
+    }
+    writer_ = std::move(writer);
+    streamPath_ = filename;
+    streamTemporary_ = temporary;
+    {
+        std::scoped_lock lock(eventsMutex_);
+        tailLimit_ = std::max<size_t>(tailEvents, 1);
+    }
+    recording_.store(true, std::memory_order_release);
+    StartDrainThread();
+    LOG_INFO("Recorder::StartStreaming", "Recording started, streaming to file (tail=%zu)", tailEvents);
+    return true;
+}
+
 void Recorder::Stop() {
-    recording_.store(false, std::memory_order_release);
+    // seq_cst pairs with PushRawEvent(): either it sees recording_ cleared, or
+    // this sees its producers_ increment and waits for the push to finish.
+    recording_.store(false, std::memory_order_seq_cst);
+    while (producers_.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+    // The filter may still hold the last move back; it belongs in the recording.
+    trc::RawEvent tail[MoveFilter::kMaxOutput];
+    const size_t held = moveFilter_.Flush(tail);
+    for (size_t i = 0; i < held; ++i) Enqueue(tail[i]);
+    movesOut_.store(moveFilter_.OutputMoves(), std::memory_order_relaxed);
     StopDrainThread();
-    LOG_INFO("Recorder::Stop", "Recording stopped, total events=%zu", events_.size());
+
+    if (writer_) {
+        const bool finished = writer_->Finish();
+        writer_.reset();
+        auto view = std::make_shared<trc::TrcView>();
+        if (!finished || !view->Open(streamPath_)) view.reset();
+        else if (streamTemporary_) view->RemoveFileOnClose();
+        if (view) {
+            std::scoped_lock lock(eventsMutex_);
+            events_.Clear();
+            tailLimit_ = 0;
+            loaded_ = std::move(view);
+            ++generation_;
+        } else {
+            // Keep the partial file for recovery; the tail becomes an ordinary
+            // in-memory recording so it can still be saved.
+            {
+                std::scoped_lock lock(eventsMutex_);
+                tailLimit_ = 0;
+                ++generation_;
+            }
+            LOG_ERROR("Recorder::Stop", "Failed to finalize stream file %s, only the in-memory tail is kept",
+                strutil::WideToUtf8(streamPath_).c_str());
+        }
+    }
+    const MoveFilterStats stats = MoveStats();
+    LOG_INFO("Recorder::Stop", "Recording stopped, total events=%zu, moves %llu -> %llu (%.1f:1)", EventCount(),
+        (unsigned long long)stats.inputMoves, (unsigned long long)stats.outputMoves, stats.Ratio());
 }
 
 bool Recorder::IsRecording() const {
@@ -35,74 +90,176 @@ bool Recorder::IsRecording() const {
 void Recorder::Clear() {
     {
         std::scoped_lock lock(eventsMutex_);
-        events_.clear();
+        events_.Clear();
+        loaded_.reset();
+        tailLimit_ = 0;
+        liveCount_ = 0;
+        liveDurationMicros_ = 0;
+        ++generation_;
+        moveFilter_.Configure(moveFilterConfig_);
     }
-    ringWrite_.store(0, std::memory_order_release);
-    ringRead_.store(0, std::memory_order_release);
+    ring_.Reset();
     dropped_.store(0, std::memory_order_release);
+    movesIn_.store(0, std::memory_order_relaxed);
+    movesOut_.store(0, std::memory_order_relaxed);
+}
+
+std::vector<trc::RawEvent> Recorder::EventsCopy(size_t* firstIndexOut) const {
+    // Grab the storage under the lock, copy outside of it so the drain
+    // thread is never held up by a large copy.
+    std::shared_ptr<const trc::TrcView> view;
+    EventStore::Snapshot snap;
+    {
+        std::scoped_lock lock(eventsMutex_);
+        if (loaded_) view = loaded_;
+        else snap = events_.TakeSnapshot();
+    }
+    if (view) {
+        if (firstIndexOut) *firstIndexOut = 0;
+        std::vector<trc::RawEvent> events;
+        if (!view->CopyEvents(0, view->EventCount(), events)) LOG_ERROR("Recorder::EventsCopy", "Failed to decode trc file");
+        return events;
+    }
+    if (firstIndexOut) *firstIndexOut = snap.FirstIndex();
+    return snap.ToVector();
 }
 
-std::vector<trc::RawEvent> Recorder::EventsCopy() const {
+Recorder::EventRange Recorder::AvailableRange() const {
     std::scoped_lock lock(eventsMutex_);
-    return events_;
+    if (loaded_) return EventRange{ 0, loaded_->EventCount(), generation_ };
+    return EventRange{ events_.FirstIndex(), events_.Size(), generation_ };
+}
+
+size_t Recorder::CopyRange(size_t first, size_t count, std::vector<trc::RawEvent>& out) const {
+    out.clear();
+    std::shared_ptr<const trc::TrcView> view;
+    {
+        std::scoped_lock lock(eventsMutex_);
+        if (!loaded_) {
+            // A few rows at most; copying them under the lock is cheaper than
+            // taking a snapshot of every chunk.
+            const size_t base = events_.FirstIndex();
+            first = std::max(first, base);
+            events_.CopyRange(first - base, count, out);
+            return first;
+        }
+        view = loaded_;
+    }
+    first = std::min(first, view->EventCount());
+    view->CopyEvents(first, count, out);
+    return first;
 }
 
 size_t Recorder::EventCount() const {
     std::scoped_lock lock(eventsMutex_);
-    return events_.size();
+    return loaded_ ? loaded_->EventCount() : liveCount_;
 }
 
 int64_t Recorder::TotalDurationMicros() const {
     std::scoped_lock lock(eventsMutex_);
-    int64_t total = 0;
-    for (const auto& e : events_) total += e.timeDelta;
-    return total;
+    return loaded_ ? loaded_->Header().totalDurationMicros : liveDurationMicros_;
+}
+
+std::shared_ptr<const trc::TrcView> Recorder::MappedView() const {
+    std::scoped_lock lock(eventsMutex_);
+    return loaded_;
 }
 
 bool Recorder::SaveToFile(const std::wstring& filename) const {
-    std::vector<trc::RawEvent> copy;
+    if (auto view = MappedView()) {
+        // The mapped events are immutable, so writing them back onto the file
+        // they came from is a no-op (and Windows would refuse to truncate a
+        // file that is still mapped).
+        std::error_code ec;
+        if (std::filesystem::equivalent(std::filesystem::path(view->Path()), std::filesystem::path(filename), ec)) {
+            LOG_INFO("Recorder::SaveToFile", "Target is the mapped source file, nothing to write");
+            return true;
+        }
+        // The mapped file is already a complete .trc; copying it avoids
+        // decoding and re-encoding what may be a very long recording.
+        const bool ok = std::filesystem::copy_file(std::filesystem::path(view->Path()), std::filesystem::path(filename),
+            std::filesystem::copy_options::overwrite_existing, ec);
+        if (ok) LOG_INFO("Recorder::SaveToFile", "Saved %zu events", view->EventCount());
+        else LOG_ERROR("Recorder::SaveToFile", "Failed to save file");
+        return ok;
+    }
+
+    EventStore::Snapshot snap;
     {
         std::scoped_lock lock(eventsMutex_);
-        copy = events_;
+        if (tailLimit_ != 0) {
+            LOG_ERROR("Recorder::SaveToFile", "Cannot save while streaming; stop the recording first");
+            return false;
+        }
+        snap = events_.TakeSnapshot();
     }
-    bool ok = trc::WriteTrcFile(filename, copy, nullptr);
-    if (ok) LOG_INFO("Recorder::SaveToFile", "Saved %zu events", copy.size());
+    // Write the chunks straight from the snapshot; no contiguous copy needed.
+    trc::TrcWriter writer;
+    bool ok = writer.Open(filename);
+    snap.ForEachSpan([&](std::span<const trc::RawEvent> span) { ok = ok && writer.Append(span); });
+    ok = writer.Finish() && ok;
+    if (ok) LOG_INFO("Recorder::SaveToFile", "Saved %zu events", snap.Size());
     else LOG_ERROR("Recorder::SaveToFile", "Failed to save file");
     return ok;
 }
 
 bool Recorder::LoadFromFile(const std::wstring& filename) {
-    trc::TrcReadResult rr{};
-    if (!trc::ReadTrcFile(filename, &rr)) {
+    auto view = trc::OpenTrcView(filename);
+    if (!view) {
         LOG_ERROR("Recorder::LoadFromFile", "Failed to read trc file");
         return false;
     }
 
+    const size_t count = view->EventCount();
     {
         std::scoped_lock lock(eventsMutex_);
-        events_ = std::move(rr.events);
+        events_.Clear();
+        tailLimit_ = 0;
+        liveCount_ = 0;
+        liveDurationMicros_ = 0;
+        ++generation_;
+        loaded_ = std::move(view);
     }
-    ringWrite_.store(0, std::memory_order_release);
-    ringRead_.store(0, std::memory_order_release);
-    LOG_INFO("Recorder::LoadFromFile", "Loaded %zu events", events_.size());
+    ring_.Reset();
+    LOG_INFO("Recorder::LoadFromFile", "Loaded %zu events", count);
     return true;
 }
 
 void Recorder::PushRawEvent(const trc::RawEvent& e) {
-    if (!IsRecording()) return;
+    producers_.fetch_add(1, std::memory_order_seq_cst);
+    if (recording_.load(std::memory_order_seq_cst)) {
+        trc::RawEvent out[MoveFilter::kMaxOutput];
+        const size_t n = moveFilter_.Push(e, out);
+        for (size_t i = 0; i < n; ++i) Enqueue(out[i]);
+        movesIn_.store(moveFilter_.InputMoves(), std::memory_order_relaxed);
+        movesOut_.store(moveFilter_.OutputMoves(), std::memory_order_relaxed);
+    }
+    producers_.fetch_sub(1, std::memory_order_release);
+}
 
-    const uint32_t size = static_cast<uint32_t>(ring_.size());
-    const uint32_t write = ringWrite_.load(std::memory_order_relaxed);
-    const uint32_t read = ringRead_.load(std::memory_order_acquire);
-    if ((write - read) >= size) {
+void Recorder::Enqueue(const trc::RawEvent& e) {
+    if (!ring_.TryPush(e)) {
         // Ring buffer is full — drain thread couldn't keep up. Count the drop
         // so we can surface it to the user instead of silently losing events.
         dropped_.fetch_add(1, std::memory_order_relaxed);
-        return;
     }
+}
+
+void Recorder::SetMoveFilter(const MoveFilterConfig& config) {
+    std::scoped_lock lock(eventsMutex_);
+    moveFilterConfig_ = config;
+}
+
+MoveFilterConfig Recorder::MoveFilterSettings() const {
+    std::scoped_lock lock(eventsMutex_);
+    return moveFilterConfig_;
+}
 
-    ring_[write % size] = e;
-    ringWrite_.store(write + 1, std::memory_order_release);
+MoveFilterStats Recorder::MoveStats() const {
+    MoveFilterStats stats;
+    stats.inputMoves = movesIn_.load(std::memory_order_relaxed);
+    stats.outputMoves = movesOut_.load(std::memory_order_relaxed);
+    return stats;
 }
 
 uint64_t Recorder::DroppedCount() const {
@@ -112,32 +269,48 @@ uint64_t Recorder::DroppedCount() const {
 void Recorder::StartDrainThread() {
     if (drainRunning_.exchange(true)) return;
     drainThread_ = std::thread([this] {
-        std::vector<trc::RawEvent> local;
-        local.reserve(4096);
-
-        while (drainRunning_.load(std::memory_order_acquire)) {
-            const uint32_t size = static_cast<uint32_t>(ring_.size());
-            uint32_t read = ringRead_.load(std::memory_order_relaxed);
-            const uint32_t write = ringWrite_.load(std::memory_order_acquire);
-
-            local.clear();
-            while (read != write && local.size() < 4096) {
-                local.push_back(ring_[read % size]);
-                ++read;
+        bool writeFailed = false;
+
+        while (true) {
+            // Sample the flag before draining so events pushed before Stop()
+            // are always picked up by one last pass.
+            const bool running = drainRunning_.load(std::memory_order_acquire);
+            // Consume straight out of the ring; the slots are released by Pop()
+            // once the batch has been stored.
+            const auto batch = ring_.FrontSpan(EventStore::kChunkEvents);
+            if (batch.empty()) {
+                if (!running) break;
+                ring_.WaitReadable(drainRunning_);
+                continue;
+            }
+
+            // File I/O happens outside the lock so UI readers never wait on the disk.
+            if (writer_ && !writeFailed && !writer_->Append(batch)) {
+                writeFailed = true;
+                LOG_ERROR("Recorder::DrainThread", "Writing to stream file failed, further events are dropped");
+            }
+            if (writeFailed) {
+                dropped_.fetch_add(batch.size(), std::memory_order_relaxed);
+                ring_.Pop(batch.size());
+                continue;
             }
 
-            if (!local.empty()) {
-                ringRead_.store(read, std::memory_order_release);
+            int64_t duration = 0;
+            for (const auto& e : batch) duration += e.timeDelta;
+            {
                 std::scoped_lock lock(eventsMutex_);
-                events_.insert(events_.end(), local.begin(), local.end());
-            } else {
-                Sleep(1);
+                events_.Append(batch);
+                liveCount_ += batch.size();
+                liveDurationMicros_ += duration;
+                if (tailLimit_ != 0) events_.TrimFront(tailLimit_);
             }
+            ring_.Pop(batch.size());
         }
     });
 }
 
 void Recorder::StopDrainThread() {
     if (!drainRunning_.exchange(false)) return;
+    ring_.WakeConsumer();
     if (drainThread_.joinable()) drainThread_.join();
 }
@@ -3,12 +3,17 @@
 #include <atomic>
 #include <cstdint>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "core/EventStore.h"
+#include "core/MoveFilter.h"
+#include "core/SpscRing.h"
 #include "core/TrcFormat.h"
+#include "core/TrcIO.h"
 
 class Recorder {
 public:
@@ -19,22 +24,60 @@ public:
     Recorder& operator=(const Recorder&) = delete;
 
     void Start();
+    // Streams the recording into filename while it is captured instead of
+    // growing an in-memory list. Only the newest tailEvents (rounded up to
+    // whole storage chunks) stay in memory for the UI until Stop(), which finalizes the file and maps it as if
+    // it had been passed to LoadFromFile(). A temporary file is deleted once
+    // the recording is discarded (next Start()/Clear()/LoadFromFile()) and no
+    // replay still reads it.
+    bool StartStreaming(const std::wstring& filename, size_t tailEvents = kDefaultTailEvents, bool temporary = false);
     void Stop();
     bool IsRecording() const;
 
     void Clear();
+    static constexpr size_t kDefaultTailEvents = 10000;
+
     // Returns a locked snapshot of the event list.
     // Use this instead of a raw reference to avoid data races with the drain thread.
-    std::vector<trc::RawEvent> EventsCopy() const;
+    // While streaming only the in-memory tail is returned; firstIndexOut
+    // receives the position of its first event within the whole recording.
+    std::vector<trc::RawEvent> EventsCopy(size_t* firstIndexOut = nullptr) const;
+
+    // Recording indices [firstIndex, firstIndex + count) that CopyRange() can
+    // serve. generation changes whenever the events behind an index may
+    // change (Start/Clear/LoadFromFile/Stop), so readers can cache per index.
+    struct EventRange {
+        size_t firstIndex{ 0 };
+        size_t count{ 0 };
+        uint64_t generation{ 0 };
+    };
+    EventRange AvailableRange() const;
+    // Replaces out with events [first, first + count), clamped to the
+    // available range, and returns the recording index of out[0]. Only the
+    // requested events are copied, so this is cheap enough to call per frame.
+    size_t CopyRange(size_t first, size_t count, std::vector<trc::RawEvent>& out) const;
+
     // Returns the number of recorded events (lock-safe).
     size_t EventCount() const;
     int64_t TotalDurationMicros() const;
 
     bool SaveToFile(const std::wstring& filename) const;
+    // Maps the file instead of reading it into memory; the events are served
+    // from the mapping until the next Start()/Clear()/LoadFromFile().
     bool LoadFromFile(const std::wstring& filename);
+    // The mapping behind the last successful LoadFromFile(), or nullptr if the
+    // current events were recorded live. Hand it to Replayer::Start() to replay
+    // without copying the event array.
+    std::shared_ptr<const trc::TrcView> MappedView() const;
 
     void PushRawEvent(const trc::RawEvent& e);
 
+    // Record-time MouseMove coalescing; takes effect at the next Start().
+    void SetMoveFilter(const MoveFilterConfig& config);
+    MoveFilterConfig MoveFilterSettings() const;
+    // Moves seen by the hook vs. moves stored, for the current recording.
+    MoveFilterStats MoveStats() const;
+
     // Number of events that were dropped because the lock-free ring was full
     // (drain thread couldn't keep up). Resets to 0 on Clear().
     uint64_t DroppedCount() const;
@@ -42,16 +85,36 @@ public:
 private:
     void StartDrainThread();
     void StopDrainThread();
+    void Enqueue(const trc::RawEvent& e);
 
     std::atomic<bool> recording_{ false };
+    // PushRawEvent() calls past their recording_ check. Stop() waits for this
+    // to reach 0 before flushing, so the hook thread stays the only producer
+    // for ring_ and the only user of moveFilter_.
+    std::atomic<int> producers_{ 0 };
 
-    std::vector<trc::RawEvent> events_;
+    EventStore events_;
+    std::shared_ptr<const trc::TrcView> loaded_;
+    size_t tailLimit_{ 0 };            // 0 = keep every event in events_
+    size_t liveCount_{ 0 };
+    int64_t liveDurationMicros_{ 0 };
+    uint64_t generation_{ 0 };
     mutable std::mutex eventsMutex_;
 
-    std::vector<trc::RawEvent> ring_;
-    std::atomic<uint32_t> ringWrite_{ 0 };
-    std::atomic<uint32_t> ringRead_{ 0 };
-    std::atomic<uint64_t> dropped_{ 0 };
+    // Streaming target; only touched by the drain thread while it runs.
+    std::unique_ptr<trc::TrcWriter> writer_;
+    std::wstring streamPath_;
+    bool streamTemporary_{ false };
+
+    MoveFilterConfig moveFilterConfig_{};   // guarded by eventsMutex_
+    MoveFilter moveFilter_;                 // hook thread only while recording
+    std::atomic<uint64_t> movesIn_{ 0 };
+    std::atomic<uint64_t> movesOut_{ 0 };
+
+    // Hook thread -> drain thread. Its indices live on their own cache lines;
+    // keep dropped_ (also written by the hook thread) off the consumer's line.
+    SpscRing<trc::RawEvent, (1u << 18)> ring_;
+    alignas(64) std::atomic<uint64_t> dropped_{ 0 };
 
     std::atomic<bool> drainRunning_{ false };
     std::thread drainThread_;
@@ -3,9 +3,10 @@
 #include <algorithm>
 #include <windows.h>
 
-#include "core/HighPrecisionWait.h"
+#include "core/HighResClock.h"
 #include "core/InputUtils.h"
 #include "core/Logger.h"
+#include "core/Waiter.h"
 
 // RAII guard for BlockInput — ensures input is always unblocked on scope exit.
 struct BlockInputGuard {
@@ -18,43 +19,84 @@ private:
     bool blocked_;
 };
 
-static DWORD MouseDownFlag(int button) {
-    switch (button) {
-    case 1: return MOUSEEVENTF_LEFTDOWN;
-    case 2: return MOUSEEVENTF_RIGHTDOWN;
-    case 3: return MOUSEEVENTF_MIDDLEDOWN;
-    case 4: return MOUSEEVENTF_XDOWN;
-    case 5: return MOUSEEVENTF_XDOWN;
-    default: return 0;
-    }
+// Further behind schedule than this, replay slips the schedule instead of
+// bursting through the backlog (system suspend, debugger, BlockInput prompt).
+static constexpr int64_t kMaxCatchUpMicros = 250'000;
+// Upper bound on events submitted in one SendInput call.
+static constexpr size_t kMaxBatchEvents = 64;
+
+void ReplayTimingStats::Add(int64_t latenessMicros) {
+    latenessMicros = std::max<int64_t>(latenessMicros, 0);
+    size_t bucket = 0;
+    while (bucket < kBuckets - 1 && latenessMicros > kBucketUpperMicros[bucket]) ++bucket;
+    ++buckets[bucket];
+    ++events;
+    totalLatenessMicros += latenessMicros;
+    maxLatenessMicros = std::max(maxLatenessMicros, latenessMicros);
 }
 
-static DWORD MouseUpFlag(int button) {
-    switch (button) {
-    case 1: return MOUSEEVENTF_LEFTUP;
-    case 2: return MOUSEEVENTF_RIGHTUP;
-    case 3: return MOUSEEVENTF_MIDDLEUP;
-    case 4: return MOUSEEVENTF_XUP;
-    case 5: return MOUSEEVENTF_XUP;
-    default: return 0;
+int64_t ReplayTimingStats::PercentileMicros(double p) const {
+    if (events == 0) return 0;
+    const uint64_t rank = std::min<uint64_t>(events, static_cast<uint64_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(events)) + 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets - 1; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(kBucketUpperMicros[i], maxLatenessMicros);
     }
+    return maxLatenessMicros;
 }
 
-static DWORD MouseXButtonData(int button) {
-    if (button == 4) return XBUTTON1;
-    if (button == 5) return XBUTTON2;
-    return 0;
+Replayer::Replayer() {
+    idle_.Set();
 }
 
-Replayer::Replayer() = default;
-
 Replayer::~Replayer() {
     Stop();
 }
 
+std::span<const trc::RawEvent> Replayer::Source::From(size_t index, std::shared_ptr<const void>& hold) const {
+    if (view) return view->EventsFrom(index, hold);
+    return std::span<const trc::RawEvent>(*events).subspan(std::min(index, events->size()));
+}
+
 bool Replayer::Start(std::vector<trc::RawEvent> events, bool blockInput, double speedFactor) {
     if (running_.load(std::memory_order_acquire)) return false;
     if (events.empty()) return false;
+    const int64_t firstWait = events.front().timeDelta;
+    Source source;
+    source.events = std::make_shared<const std::vector<trc::RawEvent>>(std::move(events));
+    return StartSource(std::move(source), {}, firstWait, blockInput, speedFactor);
+}
+
+bool Replayer::Start(std::shared_ptr<const trc::TrcView> view, bool blockInput, double speedFactor) {
+    if (!view || view->EventCount() == 0) return false;
+    std::shared_ptr<const void> hold;
+    const auto first = view->EventsFrom(0, hold);
+    if (first.empty()) return false;
+    Source source;
+    source.view = std::move(view);
+    return StartSource(std::move(source), {}, first.front().timeDelta, blockInput, speedFactor);
+}
+
+bool Replayer::StartAt(std::shared_ptr<const trc::TrcView> view, int64_t timeMicros, bool blockInput, double speedFactor) {
+    if (!view) return false;
+    if (running_.load(std::memory_order_acquire)) return false;
+    timeMicros = std::max<int64_t>(timeMicros, 0);
+    const trc::SeekPosition from = view->Seek(timeMicros);
+    if (from.eventIndex >= view->EventCount()) {
+        LOG_WARN("Replayer::StartAt", "Start time %lld us is past the end of the recording", static_cast<long long>(timeMicros));
+        return false;
+    }
+    // Only the part of the first event's delay that lies after timeMicros remains.
+    Source source;
+    source.view = std::move(view);
+    return StartSource(std::move(source), from, from.eventTimeMicros - timeMicros, blockInput, speedFactor);
+}
+
+bool Replayer::StartSource(Source source, trc::SeekPosition from, int64_t firstWaitMicros, bool blockInput, double speedFactor) {
+    if (running_.load(std::memory_order_acquire)) return false;
+    const size_t total = source.Size();
+    if (from.eventIndex >= total) return false;
 
     if (worker_.joinable()) worker_.join();
     blockInputState_.store(0, std::memory_order_release);
@@ -64,15 +106,16 @@ bool Replayer::Start(std::vector<trc::RawEvent> events, bool blockInput, double
 
     stop_.store(false, std::memory_order_release);
     paused_.store(false, std::memory_order_release);
+    idle_.Reset();
     running_.store(true, std::memory_order_release);
-    current_.store(0, std::memory_order_release);
-    total_.store(static_cast<uint32_t>(events.size()), std::memory_order_release);
+    current_.store(static_cast<uint32_t>(from.eventIndex), std::memory_order_release);
+    total_.store(static_cast<uint32_t>(total), std::memory_order_release);
 
-    LOG_INFO("Replayer::Start", "Replay starting: %zu events, speed=%.1f, blockInput=%d",
-        events.size(), speedFactor, blockInput ? 1 : 0);
+    LOG_INFO("Replayer::Start", "Replay starting: %zu events from #%zu, speed=%.1f, blockInput=%d",
+        total, from.eventIndex, speedFactor, blockInput ? 1 : 0);
 
-    worker_ = std::thread([this, ev = std::move(events), blockInput]() mutable {
-        ThreadMain(std::move(ev), blockInput);
+    worker_ = std::thread([this, source = std::move(source), from, firstWaitMicros, blockInput]() mutable {
+        ThreadMain(std::move(source), from.eventIndex, firstWaitMicros, blockInput);
     });
     return true;
 }
@@ -80,21 +123,29 @@ bool Replayer::Start(std::vector<trc::RawEvent> events, bool blockInput, double
 void Replayer::Stop() {
     LOG_INFO("Replayer::Stop", "Replay stop requested");
     stop_.store(true, std::memory_order_release);
+    wake_.Set();
     if (worker_.joinable()) worker_.join();
     running_.store(false, std::memory_order_release);
+    idle_.Set();
 }
 
 bool Replayer::IsRunning() const {
     return running_.load(std::memory_order_acquire);
 }
 
+bool Replayer::WaitIdleUntil(int64_t deadlineMicros) const {
+    return !IsRunning() || idle_.WaitUntil(deadlineMicros);
+}
+
 void Replayer::Pause() {
     paused_.store(true, std::memory_order_release);
+    wake_.Set();
     LOG_INFO("Replayer::Pause", "Replay paused");
 }
 
 void Replayer::Resume() {
     paused_.store(false, std::memory_order_release);
+    wake_.Set();
     LOG_INFO("Replayer::Resume", "Replay resumed");
 }
 
@@ -106,12 +157,18 @@ void Replayer::SetDryRun(bool dryRun) {
     dryRun_.store(dryRun, std::memory_order_release);
 }
 
+void Replayer::SetInputSink(std::shared_ptr<InputSink> sink) {
+    if (running_.load(std::memory_order_acquire)) return;
+    sink_ = std::move(sink);
+}
+
 int Replayer::BlockInputState() const {
     return blockInputState_.load(std::memory_order_acquire);
 }
 
 void Replayer::SetSpeed(double speedFactor) {
     speedFactor_.store(std::clamp(speedFactor, 0.1, 10.0), std::memory_order_release);
+    wake_.Set();
 }
 
 double Replayer::Speed() const {
@@ -125,7 +182,12 @@ float Replayer::Progress01() const {
     return std::clamp(static_cast<float>(cur) / static_cast<float>(total), 0.0f, 1.0f);
 }
 
-void Replayer::ThreadMain(std::vector<trc::RawEvent> events, bool blockInput) {
+ReplayTimingStats Replayer::TimingStats() const {
+    std::scoped_lock lock(statsMutex_);
+    return stats_;
+}
+
+void Replayer::ThreadMain(Source source, size_t startIndex, int64_t firstWaitMicros, bool blockInput) {
     BlockInputGuard inputGuard(blockInput);
     const bool blocked = inputGuard.IsBlocked();
     if (blockInput) {
@@ -135,83 +197,212 @@ void Replayer::ThreadMain(std::vector<trc::RawEvent> events, bool blockInput) {
     }
 
     const bool dryRun = dryRun_.load(std::memory_order_acquire);
-    for (uint32_t i = 0; i < events.size(); ++i) {
+    std::shared_ptr<InputSink> sink = sink_ ? sink_ : std::make_shared<SendInputSink>();
+    hasLastFocus_ = false;
+    ReplayTimingStats stats;
+    {
+        std::scoped_lock lock(statsMutex_);
+        stats_ = stats;
+    }
+
+    // Events run against an absolute schedule: event i is due at
+    // anchorWall + (recorded_i - anchorRecorded) / speed. Waiting for a deadline
+    // instead of for each delta keeps wait overshoot and injection cost from
+    // accumulating; when behind, the next waits are simply skipped. Speed
+    // changes and pauses re-anchor the schedule at the last event.
+    double speed = speedFactor_.load(std::memory_order_acquire);
+    int64_t anchorWall = timing::MicrosNow();
+    int64_t anchorRecorded = 0;
+    int64_t recorded = 0;         // recorded time of the previous event
+    int64_t prevDue = anchorWall; // wall time the previous event was due
+    uint64_t published = 0;       // stats.events at the last publish
+    // Events are read a block at a time: chunk holds [chunkFirst, chunkEnd).
+    const size_t total = source.Size();
+    std::shared_ptr<const void> hold;
+    std::span<const trc::RawEvent> chunk;
+    size_t chunkFirst = 0;
+    size_t chunkEnd = 0;
+    for (size_t i = startIndex; i < total; ++i) {
         if (stop_.load(std::memory_order_acquire)) break;
+        if (i >= chunkEnd) {
+            chunk = source.From(i, hold);
+            if (chunk.empty()) {
+                LOG_ERROR("Replayer::ThreadMain", "Failed to read events from #%zu, stopping replay", i);
+                break;
+            }
+            chunkFirst = i;
+            chunkEnd = i + chunk.size();
+        }
 
-        // Wait while paused
-        while (paused_.load(std::memory_order_acquire)) {
+        const int64_t delta = (i == startIndex) ? firstWaitMicros : chunk[i - chunkFirst].timeDelta;
+        int64_t eventRecorded = recorded + std::max<int64_t>(delta, 0);
+        int64_t due = 0;
+        while (true) {
+            // Reset before looking at the state: a Stop/Pause/Resume/SetSpeed
+            // landing after the checks below sets the event again.
+            wake_.Reset();
             if (stop_.load(std::memory_order_acquire)) break;
-            Sleep(50);
+            if (paused_.load(std::memory_order_acquire)) {
+                // Parked on the event, not polling: a pause costs no CPU.
+                wake_.Wait();
+                if (paused_.load(std::memory_order_acquire)) continue;
+                // Resume as if the previous event had just played.
+                anchorWall = prevDue = timing::MicrosNow();
+                anchorRecorded = recorded;
+                continue;
+            }
+            const double newSpeed = speedFactor_.load(std::memory_order_acquire);
+            if (newSpeed != speed) {
+                anchorWall = prevDue;
+                anchorRecorded = recorded;
+                speed = newSpeed;
+            }
+            due = anchorWall + static_cast<int64_t>(static_cast<double>(eventRecorded - anchorRecorded) / speed);
+            const int64_t now = timing::MicrosNow();
+            if (due <= now) break;
+            if (timing::Waiter::Instance().WaitUntil(due, wake_)) break;
         }
         if (stop_.load(std::memory_order_acquire)) break;
 
-        const double speed = speedFactor_.load(std::memory_order_acquire);
-        const int64_t waitMicros = static_cast<int64_t>(static_cast<double>(events[i].timeDelta) / speed);
-        timing::HighPrecisionWaitMicros(waitMicros);
+        const int64_t now = timing::MicrosNow();
+        const int64_t lateness = now - due;
+        stats.Add(lateness);
+        if (lateness > kMaxCatchUpMicros) {
+            anchorWall += lateness;
+            due += lateness;
+            ++stats.resyncs;
+        }
 
-        if (!dryRun) InjectEvent(events[i]);
-        current_.store(i + 1, std::memory_order_release);
+        // Everything else already due goes out in the same batch.
+        size_t end = i + 1;
+        while (end < chunkEnd && end - i < kMaxBatchEvents) {
+            const int64_t nextRecorded = eventRecorded + std::max<int64_t>(chunk[end - chunkFirst].timeDelta, 0);
+            const int64_t nextDue = anchorWall + static_cast<int64_t>(static_cast<double>(nextRecorded - anchorRecorded) / speed);
+            if (nextDue > now) break;
+            stats.Add(now - nextDue);
+            eventRecorded = nextRecorded;
+            due = nextDue;
+            ++end;
+        }
+
+        if (!dryRun) InjectBatch(chunk.subspan(i - chunkFirst, end - i), *sink);
+        stats.finalDriftMicros = timing::MicrosNow() - due;
+        prevDue = due;
+        recorded = eventRecorded;
+        i = end - 1;
+        current_.store(static_cast<uint32_t>(i + 1), std::memory_order_release);
+        if (stats.events - published >= 256) {
+            std::scoped_lock lock(statsMutex_);
+            stats_ = stats;
+            published = stats.events;
+        }
+    }
+    {
+        std::scoped_lock lock(statsMutex_);
+        stats_ = stats;
     }
 
     // inputGuard destructor automatically calls BlockInput(FALSE) if blocked.
     if (blocked) blockInputState_.store(0, std::memory_order_release);
+    LOG_INFO("Replayer::ThreadMain", "Replay finished, played %u/%zu events, lateness p50<=%lld p99<=%lld max=%lld us, resyncs=%u",
+        current_.load(), total, static_cast<long long>(stats.PercentileMicros(0.50)),
+        static_cast<long long>(stats.PercentileMicros(0.99)), static_cast<long long>(stats.maxLatenessMicros), stats.resyncs);
+    // Drop the event storage (vector or file mapping) before reporting idle.
+    hold.reset();
+    source = {};
     running_.store(false, std::memory_order_release);
-    LOG_INFO("Replayer::ThreadMain", "Replay finished, played %u/%zu events",
-        current_.load(), events.size());
+    idle_.Set();
 }
 
-void Replayer::InjectEvent(const trc::RawEvent& e) {
-    const auto type = static_cast<trc::EventType>(e.type);
-
-    if (type == trc::EventType::MouseMove) {
-        input::MoveCursorBestEffort(e.x, e.y);
-        return;
-    }
-
-    if (type == trc::EventType::MouseDown || type == trc::EventType::MouseUp) {
-        input::MoveCursorBestEffort(e.x, e.y);
-        const int button = e.data;
-        INPUT in{};
-        in.type = INPUT_MOUSE;
-        in.mi.dwFlags = (type == trc::EventType::MouseDown) ? MouseDownFlag(button) : MouseUpFlag(button);
-        if (in.mi.dwFlags == 0) return;
-        if (button == 4 || button == 5) in.mi.mouseData = MouseXButtonData(button);
-        SendInput(1, &in, sizeof(in));
-        return;
-    }
-
-    if (type == trc::EventType::Wheel) {
-        input::MoveCursorBestEffort(e.x, e.y);
-        input::FocusWindowAt(e.x, e.y);
-        // Bit 30 = horizontal wheel flag (set by Hooks::OnMouse for WM_MOUSEHWHEEL).
-        // Pre-v1 .trc files stored a 16-bit signed delta in the low 16 bits with
-        // unrelated noise in the high 16 bits; treat that pattern as legacy
-        // (vertical) wheel for backwards compat.
-        bool horizontal = (e.data & (1 << 30)) != 0;
-        if ((static_cast<uint32_t>(e.data) & 0xFFFF0000u) == 0xFFFF0000u) horizontal = false;
-        const int16_t delta16 = static_cast<int16_t>(e.data & 0xFFFF);
-        const int delta = static_cast<int>(delta16);
-        INPUT in{};
-        in.type = INPUT_MOUSE;
-        in.mi.dwFlags = horizontal ? MOUSEEVENTF_HWHEEL : MOUSEEVENTF_WHEEL;
-        in.mi.mouseData = static_cast<DWORD>(delta);
-        SendInput(1, &in, sizeof(in));
-        return;
+// Translates a batch into INPUTs and submits them with one Send(). Wheel and
+// key events need the window under the cursor focused; that happens once per
+// focus point and is skipped while the point has not changed. Inputs queued
+// before a focus change (e.g. a click) are sent first, and a wheel/key event
+// aimed at a different point ends the batch, so every event reaches the
+// window it was recorded over.
+void Replayer::InjectBatch(std::span<const trc::RawEvent> batch, InputSink& sink) {
+    const input::VirtualScreen screen = input::QueryVirtualScreen();
+    batchInputs_.clear();
+
+    bool needFocus = false;
+    bool clicked = false;
+    POINT focus{};
+    bool cursorKnown = false;
+    POINT cursor{};
+    auto send = [&]() {
+        if (needFocus && !(hasLastFocus_ && lastFocus_.x == focus.x && lastFocus_.y == focus.y)) {
+            sink.FocusAt(focus.x, focus.y);
+            hasLastFocus_ = true;
+            lastFocus_ = focus;
+        }
+        // A click can hand focus to another window; focus again on the next wheel/key.
+        if (clicked) hasLastFocus_ = false;
+        sink.Send(batchInputs_);
+        batchInputs_.clear();
+        needFocus = false;
+        clicked = false;
+    };
+    auto requestFocus = [&](POINT pt) {
+        if (needFocus && (pt.x != focus.x || pt.y != focus.y)) send();
+        if (needFocus) return;
+        // Earlier inputs were recorded before this focus change; they go out first.
+        const bool refocus = clicked || !(hasLastFocus_ && lastFocus_.x == pt.x && lastFocus_.y == pt.y);
+        if (refocus && !batchInputs_.empty()) send();
+        needFocus = true;
+        focus = pt;
+    };
+    auto moveTo = [&](const trc::RawEvent& e) {
+        batchInputs_.push_back(input::MakeAbsoluteMove(screen, e.x, e.y));
+        cursor = POINT{ e.x, e.y };
+        cursorKnown = true;
+    };
+
+    for (const auto& e : batch) {
+        const auto type = static_cast<trc::EventType>(e.type);
+
+        if (type == trc::EventType::MouseMove) {
+            moveTo(e);
+        } else if (type == trc::EventType::MouseDown || type == trc::EventType::MouseUp) {
+            moveTo(e);
+            const int button = e.data;
+            INPUT in{};
+            in.type = INPUT_MOUSE;
+            in.mi.dwFlags = (type == trc::EventType::MouseDown) ? input::MouseDownFlag(button) : input::MouseUpFlag(button);
+            if (in.mi.dwFlags == 0) continue;
+            if (button == 4 || button == 5) in.mi.mouseData = input::MouseXButtonData(button);
+            batchInputs_.push_back(in);
+            if (type == trc::EventType::MouseDown) clicked = true;
+        } else if (type == trc::EventType::Wheel) {
+            requestFocus(POINT{ e.x, e.y });   // may end the batch; the move opens the next one
+            moveTo(e);
+            // Bit 30 = horizontal wheel flag (set by Hooks::OnMouse for WM_MOUSEHWHEEL).
+            // Pre-v1 .trc files stored a 16-bit signed delta in the low 16 bits with
+            // unrelated noise in the high 16 bits; treat that pattern as legacy
+            // (vertical) wheel for backwards compat.
+            bool horizontal = (e.data & (1 << 30)) != 0;
+            if ((static_cast<uint32_t>(e.data) & 0xFFFF0000u) == 0xFFFF0000u) horizontal = false;
+            const int16_t delta16 = static_cast<int16_t>(e.data & 0xFFFF);
+            const int delta = static_cast<int>(delta16);
+            INPUT in{};
+            in.type = INPUT_MOUSE;
+            in.mi.dwFlags = horizontal ? MOUSEEVENTF_HWHEEL : MOUSEEVENTF_WHEEL;
+            in.mi.mouseData = static_cast<DWORD>(delta);
+            batchInputs_.push_back(in);
+        } else if (type == trc::EventType::KeyDown || type == trc::EventType::KeyUp) {
+            if (!cursorKnown) cursorKnown = GetCursorPos(&cursor) != FALSE;
+            if (cursorKnown) requestFocus(cursor);
+            INPUT in{};
+            in.type = INPUT_KEYBOARD;
+            const WORD vk = static_cast<WORD>(e.x);
+            const WORD sc = static_cast<WORD>(e.y);
+            in.ki.wVk = (sc != 0) ? 0 : vk;
+            in.ki.wScan = sc;
+            in.ki.dwFlags = (sc != 0) ? KEYEVENTF_SCANCODE : 0;
+            if ((e.data & LLKHF_EXTENDED) != 0) in.ki.dwFlags |= KEYEVENTF_EXTENDEDKEY;
+            if (type == trc::EventType::KeyUp) in.ki.dwFlags |= KEYEVENTF_KEYUP;
+            batchInputs_.push_back(in);
+        }
     }
 
-    if (type == trc::EventType::KeyDown || type == trc::EventType::KeyUp) {
-        POINT pt{};
-        if (GetCursorPos(&pt)) input::FocusWindowAt(pt.x, pt.y);
-        INPUT in{};
-        in.type = INPUT_KEYBOARD;
-        const WORD vk = static_cast<WORD>(e.x);
-        const WORD sc = static_cast<WORD>(e.y);
-        in.ki.wVk = (sc != 0) ? 0 : vk;
-        in.ki.wScan = sc;
-        in.ki.dwFlags = (sc != 0) ? KEYEVENTF_SCANCODE : 0;
-        if ((e.data & LLKHF_EXTENDED) != 0) in.ki.dwFlags |= KEYEVENTF_EXTENDEDKEY;
-        if (type == trc::EventType::KeyUp) in.ki.dwFlags |= KEYEVENTF_KEYUP;
-        SendInput(1, &in, sizeof(in));
-        return;
-    }
+    send();
 }
@@ -2,10 +2,39 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <thread>
 #include <vector>
 
+#include "core/InputSink.h"
+#include "core/SyncEvent.h"
 #include "core/TrcFormat.h"
+#include "core/TrcIO.h"
+
+// How late events were injected relative to their scheduled time
+// (start + recorded time / speed). Buckets are upper bounds in microseconds;
+// the last bucket collects everything later than kBucketUpperMicros[kBuckets - 2].
+struct ReplayTimingStats {
+    static constexpr size_t kBuckets = 10;
+    static constexpr int64_t kBucketUpperMicros[kBuckets - 1] = { 10, 50, 100, 250, 500, 1000, 2000, 5000, 10000 };
+
+    uint64_t events{ 0 };
+    uint64_t buckets[kBuckets]{};
+    int64_t maxLatenessMicros{ 0 };
+    int64_t totalLatenessMicros{ 0 };
+    // Times the schedule was re-anchored because replay fell too far behind
+    // (e.g. the machine was suspended) instead of bursting to catch up.
+    uint32_t resyncs{ 0 };
+    // Actual minus scheduled wall time when the last event was injected.
+    int64_t finalDriftMicros{ 0 };
+
+    void Add(int64_t latenessMicros);
+    // Upper bound of the bucket containing the p-quantile (max for the last bucket).
+    int64_t PercentileMicros(double p) const;
+    double MeanMicros() const { return events ? static_cast<double>(totalLatenessMicros) / static_cast<double>(events) : 0.0; }
+};
 
 class Replayer {
 public:
@@ -16,13 +45,29 @@ public:
     Replayer& operator=(const Replayer&) = delete;
 
     bool Start(std::vector<trc::RawEvent> events, bool blockInput, double speedFactor);
+    // Replays straight out of a mapped .trc file; the view is kept alive until
+    // the worker thread finishes.
+    bool Start(std::shared_ptr<const trc::TrcView> view, bool blockInput, double speedFactor);
+    // Resumes playback timeMicros into the recording (recorded time, before
+    // speed scaling). Uses the file's seek index, so the jump costs a binary
+    // search plus at most one index stride of events.
+    bool StartAt(std::shared_ptr<const trc::TrcView> view, int64_t timeMicros, bool blockInput, double speedFactor);
     void Stop();
     bool IsRunning() const;
+    // Blocks until the replay has finished (or was stopped) or until
+    // timing::MicrosNow() reaches deadlineMicros; returns true once idle.
+    bool WaitIdleUntil(int64_t deadlineMicros) const;
+    // Set whenever no replay is running; for waiting on it together with
+    // other handles (WaitForMultipleObjects).
+    const threading::Event& IdleEvent() const { return idle_; }
     void Pause();
     void Resume();
     bool IsPaused() const;
 
     void SetDryRun(bool dryRun);
+    // Injection backend for the next Start(); nullptr restores SendInput.
+    // Ignored while a replay is running.
+    void SetInputSink(std::shared_ptr<InputSink> sink);
     int BlockInputState() const;
 
     void SetSpeed(double speedFactor);
@@ -30,13 +75,32 @@ public:
 
     float Progress01() const;
 
+    // Lateness of the current (or last) replay; updated while it runs.
+    ReplayTimingStats TimingStats() const;
+
 private:
-    void ThreadMain(std::vector<trc::RawEvent> events, bool blockInput);
-    void InjectEvent(const trc::RawEvent& e);
+    // What the worker replays: an owned event list, or a view read block by
+    // block so a packed recording is never decoded as a whole.
+    struct Source {
+        std::shared_ptr<const std::vector<trc::RawEvent>> events;
+        std::shared_ptr<const trc::TrcView> view;
+
+        size_t Size() const { return view ? view->EventCount() : events->size(); }
+        std::span<const trc::RawEvent> From(size_t index, std::shared_ptr<const void>& hold) const;
+    };
+
+    bool StartSource(Source source, trc::SeekPosition from, int64_t firstWaitMicros, bool blockInput, double speedFactor);
+    void ThreadMain(Source source, size_t startIndex, int64_t firstWaitMicros, bool blockInput);
+    void InjectBatch(std::span<const trc::RawEvent> batch, InputSink& sink);
 
     std::atomic<bool> running_{ false };
     std::atomic<bool> stop_{ false };
     std::atomic<bool> paused_{ false };
+    // Set after stop_, paused_ or the speed change so a sleeping worker
+    // re-evaluates at once instead of on its next timeout.
+    threading::Event wake_;
+    // Set whenever running_ drops to false; see WaitIdleUntil().
+    threading::Event idle_;
 
     std::atomic<double> speedFactor_{ 1.0 };
     std::atomic<bool> dryRun_{ false };
@@ -45,5 +109,14 @@ private:
     std::atomic<uint32_t> current_{ 0 };
     std::atomic<uint32_t> total_{ 0 };
 
+    std::shared_ptr<InputSink> sink_;
+    // Worker thread only.
+    std::vector<INPUT> batchInputs_;
+    bool hasLastFocus_{ false };
+    POINT lastFocus_{};
+
+    mutable std::mutex statsMutex_;
+    ReplayTimingStats stats_;
+
     std::thread worker_;
 };
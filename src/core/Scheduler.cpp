@@ -1,10 +1,12 @@
 #include "core/Scheduler.h"
+#include "core/HighResClock.h"
 #include "core/Logger.h"
 
 #include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <sstream>
+#include <unordered_set>
 #include <windows.h>
 
 Scheduler::Scheduler() = default;
@@ -14,13 +16,36 @@ void Scheduler::Start(ActionCallback callback) {
     if (running_.load()) return;
     callback_ = std::move(callback);
     running_.store(true);
+    int workers = 1;
+    {
+        std::scoped_lock lock(poolMutex_);
+        workers = maxConcurrency_;
+    }
+    executors_.reserve(workers);
+    for (int i = 0; i < workers; ++i) executors_.emplace_back([this] { ExecutorMain(); });
     worker_ = std::thread([this] { ThreadMain(); });
-    LOG_INFO("Scheduler::Start", "Scheduler started");
+    LOG_INFO("Scheduler::Start", "Scheduler started (%d executors)", workers);
 }
 
 void Scheduler::Stop() {
-    running_.store(false);
+    {
+        std::scoped_lock lock(mutex_);
+        running_.store(false);
+        NotifyWorker();
+    }
+    {
+        // Executors test running_ under poolMutex_; taking it here means none
+        // can miss the notification.
+        std::scoped_lock lock(poolMutex_);
+    }
+    poolCv_.notify_all();
     if (worker_.joinable()) worker_.join();
+    // Runs in progress finish; runs still waiting are dropped.
+    for (auto& t : executors_) {
+        if (t.joinable()) t.join();
+    }
+    executors_.clear();
+    DropWaitingRuns();
     LOG_INFO("Scheduler::Stop", "Scheduler stopped");
 }
 
@@ -36,82 +61,110 @@ int Scheduler::AddTask(const ScheduledTask& task) {
     t.createdTime = NowEpochSeconds();
     t.status = t.enabled ? TaskStatus::Waiting : TaskStatus::Disabled;
     ComputeNextRun(t);
+    slotById_[t.id] = tasks_.size();
     tasks_.push_back(t);
+    published_.emplace_back();
+    ++tableVersion_;
+    Schedule(tasks_.back());
     LOG_INFO("Scheduler::AddTask", "Added task id=%d name='%s'", t.id, t.name.c_str());
     return t.id;
 }
 
 void Scheduler::RemoveTask(int id) {
     std::scoped_lock lock(mutex_);
-    tasks_.erase(std::remove_if(tasks_.begin(), tasks_.end(),
-        [id](const ScheduledTask& t) { return t.id == id; }), tasks_.end());
+    const auto it = slotById_.find(id);
+    if (it == slotById_.end()) return;
+    const size_t slot = it->second;
+    tasks_.erase(tasks_.begin() + slot);
+    published_.erase(published_.begin() + slot);
+    ++tableVersion_;
+    // Queued entries for the task go stale: FindTask() no longer sees it.
+    slotById_.erase(it);
+    for (size_t i = slot; i < tasks_.size(); ++i) slotById_[tasks_[i].id] = i;
     LOG_INFO("Scheduler::RemoveTask", "Removed task id=%d", id);
 }
 
 void Scheduler::UpdateTask(const ScheduledTask& task) {
     std::scoped_lock lock(mutex_);
-    for (auto& t : tasks_) {
-        if (t.id == task.id) {
-            t.name = task.name;
-            t.description = task.description;
-            t.enabled = task.enabled;
-            t.priority = task.priority;
-            t.type = task.type;
-            t.triggerTime = task.triggerTime;
-            t.dateStr = task.dateStr;
-            t.timeStr = task.timeStr;
-            t.interval = task.interval;
-            t.unit = task.unit;
-            t.maxRuns = task.maxRuns;
-            t.startDelaySec = task.startDelaySec;
-            t.windowStartHour = task.windowStartHour;
-            t.windowEndHour = task.windowEndHour;
-            t.retryCount = task.retryCount;
-            t.retryDelaySec = task.retryDelaySec;
-            t.actionMode = task.actionMode;
-            t.actionPath = task.actionPath;
-            t.actionSpeed = task.actionSpeed;
-            t.actionBlockInput = task.actionBlockInput;
-            ComputeNextRun(t);
-            break;
-        }
+    if (ScheduledTask* t = FindTask(task.id)) {
+        t->name = task.name;
+        t->description = task.description;
+        t->enabled = task.enabled;
+        t->priority = task.priority;
+        t->type = task.type;
+        t->triggerTime = task.triggerTime;
+        t->dateStr = task.dateStr;
+        t->timeStr = task.timeStr;
+        t->interval = task.interval;
+        t->unit = task.unit;
+        t->maxRuns = task.maxRuns;
+        t->startDelaySec = task.startDelaySec;
+        t->windowStartHour = task.windowStartHour;
+        t->windowEndHour = task.windowEndHour;
+        t->retryCount = task.retryCount;
+        t->retryDelaySec = task.retryDelaySec;
+        t->actionMode = task.actionMode;
+        t->actionPath = task.actionPath;
+        t->actionSpeed = task.actionSpeed;
+        t->actionBlockInput = task.actionBlockInput;
+        t->maxConcurrent = task.maxConcurrent;
+        t->exclusiveInput = task.exclusiveInput;
+        ComputeNextRun(*t);
+        Touch(*t);
+        Schedule(*t);
     }
 }
 
 void Scheduler::SetTaskEnabled(int id, bool enabled) {
     std::scoped_lock lock(mutex_);
-    for (auto& t : tasks_) {
-        if (t.id == id) {
-            t.enabled = enabled;
-            t.status = enabled ? TaskStatus::Waiting : TaskStatus::Disabled;
-            if (enabled && t.finished) {
-                // Re-enable resets finished state for periodic
-                if (t.type == TaskType::Periodic) { t.finished = false; ComputeNextRun(t); }
-            }
-            break;
+    if (ScheduledTask* t = FindTask(id)) {
+        t->enabled = enabled;
+        t->status = enabled ? TaskStatus::Waiting : TaskStatus::Disabled;
+        if (enabled && t->finished) {
+            // Re-enable resets finished state for periodic
+            if (t->type == TaskType::Periodic) { t->finished = false; ComputeNextRun(*t); }
         }
+        Touch(*t);
+        Schedule(*t);
     }
 }
 
 void Scheduler::ResetTask(int id) {
     std::scoped_lock lock(mutex_);
-    for (auto& t : tasks_) {
-        if (t.id == id) {
-            t.runCount = 0;
-            t.failCount = 0;
-            t.lastRunTime = 0;
-            t.finished = false;
-            t.status = t.enabled ? TaskStatus::Waiting : TaskStatus::Disabled;
-            t.history.clear();
-            ComputeNextRun(t);
-            break;
-        }
+    if (ScheduledTask* t = FindTask(id)) {
+        t->runCount = 0;
+        t->failCount = 0;
+        t->lastRunTime = 0;
+        t->finished = false;
+        t->status = t->enabled ? TaskStatus::Waiting : TaskStatus::Disabled;
+        t->history.clear();
+        ComputeNextRun(*t);
+        Touch(*t);
+        Schedule(*t);
     }
 }
 
 void Scheduler::RunTaskNow(int id) {
     std::scoped_lock lock(mutex_);
     pendingRunNow_.push_back(id);
+    NotifyWorker();
+}
+
+void Scheduler::SetMaxConcurrency(int workers) {
+    std::scoped_lock lock(poolMutex_);
+    maxConcurrency_ = std::clamp(workers, 1, 64);
+}
+
+int Scheduler::MaxConcurrency() const {
+    std::scoped_lock lock(poolMutex_);
+    return maxConcurrency_;
+}
+
+SchedulerMetrics Scheduler::Metrics() const {
+    std::scoped_lock lock(poolMutex_);
+    SchedulerMetrics m = metrics_;
+    m.queued = static_cast<int>(jobs_.size());
+    return m;
 }
 
 std::vector<ScheduledTask> Scheduler::GetTasks() const {
@@ -119,9 +172,28 @@ std::vector<ScheduledTask> Scheduler::GetTasks() const {
     return tasks_;
 }
 
+std::shared_ptr<const TaskSnapshot> Scheduler::Snapshot() const {
+    std::scoped_lock lock(mutex_);
+    if (snapshot_ && snapshot_->version == tableVersion_) return snapshot_;
+    auto snap = std::make_shared<TaskSnapshot>();
+    snap->version = tableVersion_;
+    for (size_t i = 0; i < tasks_.size(); ++i) {
+        if (!published_[i]) published_[i] = std::make_shared<const ScheduledTask>(tasks_[i]);
+        if (tasks_[i].enabled && !tasks_[i].finished) ++snap->activeCount;
+    }
+    snap->tasks = published_;
+    snapshot_ = std::move(snap);
+    return snapshot_;
+}
+
 void Scheduler::ClearTasks() {
     std::scoped_lock lock(mutex_);
     tasks_.clear();
+    slotById_.clear();
+    published_.clear();
+    ++tableVersion_;
+    queue_.clear();
+    NotifyWorker();
 }
 
 int Scheduler::TaskCount() const {
@@ -162,120 +234,312 @@ bool Scheduler::IsInTimeWindow(const ScheduledTask& task) const {
         return h >= task.windowStartHour || h < task.windowEndHour;
 }
 
+ScheduledTask* Scheduler::FindTask(int id) {
+    const auto it = slotById_.find(id);
+    return it == slotById_.end() ? nullptr : &tasks_[it->second];
+}
+
+void Scheduler::Touch(const ScheduledTask& task) {
+    published_[static_cast<size_t>(&task - tasks_.data())].reset();
+    ++tableVersion_;
+}
+
+// Queues the task at its nextRunTime, invalidating whatever was queued for it.
+void Scheduler::Schedule(ScheduledTask& task) {
+    ++task.scheduleVersion;
+    if (task.enabled && !task.finished && task.nextRunTime > 0) PushEntry(task, task.nextRunTime);
+    // Stale entries pile up when tasks are edited often; compact once they dominate.
+    if (queue_.size() > 2 * tasks_.size() + 64) RebuildQueue();
+    NotifyWorker();
+}
+
+void Scheduler::PushEntry(const ScheduledTask& task, int64_t due) {
+    queue_.push_back(QueueEntry{ due, task.priority, queueSeq_++, task.id, task.scheduleVersion });
+    std::push_heap(queue_.begin(), queue_.end(), LaterEntry{});
+}
+
+void Scheduler::RebuildIndex() {
+    slotById_.clear();
+    slotById_.reserve(tasks_.size());
+    for (size_t i = 0; i < tasks_.size(); ++i) slotById_[tasks_[i].id] = i;
+}
+
+void Scheduler::RebuildQueue() {
+    queue_.clear();
+    for (const auto& t : tasks_) {
+        if (t.enabled && !t.finished && t.nextRunTime > 0)
+            queue_.push_back(QueueEntry{ t.nextRunTime, t.priority, queueSeq_++, t.id, t.scheduleVersion });
+    }
+    std::make_heap(queue_.begin(), queue_.end(), LaterEntry{});
+}
+
+void Scheduler::NotifyWorker() {
+    wakeRequested_ = true;
+    cv_.notify_one();
+}
+
+// Pops everything due by `now` (plus pending run-now requests) into toRun and
+// advances those tasks' schedules.
+void Scheduler::CollectDue(int64_t now, std::vector<ScheduledTask>& toRun) {
+    std::unordered_set<int> queued;
+
+    // Handle "run now" requests
+    for (int rid : pendingRunNow_) {
+        const ScheduledTask* t = FindTask(rid);
+        if (!t || !queued.insert(rid).second) continue;
+        if (HasWaitingRun(rid)) {
+            std::scoped_lock lock(poolMutex_);
+            ++metrics_.coalesced;
+            continue;
+        }
+        toRun.push_back(*t);
+    }
+    pendingRunNow_.clear();
+
+    // Check scheduled triggers
+    std::vector<ScheduledTask*> due;
+    while (!queue_.empty() && queue_.front().due <= now) {
+        std::pop_heap(queue_.begin(), queue_.end(), LaterEntry{});
+        const QueueEntry e = queue_.back();
+        queue_.pop_back();
+        ScheduledTask* t = FindTask(e.id);
+        if (!t || t->scheduleVersion != e.version || !t->enabled || t->finished) continue;
+        if (!IsInTimeWindow(*t)) {
+            // Outside its hours: look again when the window opens. Hours are
+            // local time, and local hours need not start on a UTC hour.
+            PushEntry(*t, NextWindowStart(t->windowStartHour, now));
+            continue;
+        }
+        due.push_back(t);
+    }
+    // Everything due in this pass runs by priority (higher first), then by due time.
+    std::stable_sort(due.begin(), due.end(), [](const ScheduledTask* a, const ScheduledTask* b) {
+        return a->priority > b->priority;
+    });
+
+    for (ScheduledTask* tp : due) {
+        auto& t = *tp;
+        // Check if already in toRun (from RunNow)
+        if (!queued.insert(t.id).second) {
+            Schedule(t);
+            continue;
+        }
+        // A run of this task is still waiting for a free executor (or for its
+        // own previous run): fold this trigger into it rather than piling up.
+        if (HasWaitingRun(t.id)) {
+            {
+                std::scoped_lock lock(poolMutex_);
+                ++metrics_.coalesced;
+            }
+            LOG_WARN("Scheduler::CollectDue", "Task id=%d is still waiting from its last trigger; skipping this one", t.id);
+            t.lastRunTime = now;
+            Touch(t);
+            if (t.type == TaskType::OneShot) {
+                t.finished = true;
+            } else {
+                ComputeNextRun(t);
+                Schedule(t);
+            }
+            continue;
+        }
+
+        toRun.push_back(t);
+        t.runCount++;
+        t.lastRunTime = now;
+        t.status = TaskStatus::Running;
+        Touch(t);
+
+        if (t.type == TaskType::OneShot) {
+            t.finished = true;
+            t.status = TaskStatus::Done;
+        } else {
+            if (t.maxRuns > 0 && t.runCount >= t.maxRuns) {
+                t.finished = true;
+                t.status = TaskStatus::Done;
+            } else {
+                ComputeNextRun(t);
+                Schedule(t);
+            }
+        }
+    }
+}
+
+void Scheduler::RecordRun(int id, const TaskRunRecord& rec) {
+    // Note: if the task was removed while the callback was running,
+    // the history update is silently skipped — this is intentional.
+    ScheduledTask* t = FindTask(id);
+    if (!t) return;
+    auto& mt = *t;
+    Touch(mt);
+    mt.history.push_back(rec);
+    if ((int)mt.history.size() > 20) mt.history.erase(mt.history.begin());
+    if (!rec.success) {
+        mt.failCount++;
+        // Retry handling: if retryCount > 0 and we still have
+        // remaining attempts in this cycle, schedule a retry.
+        // Initialize retryRemaining at the start of a fresh cycle
+        // (i.e. when a non-retry attempt fails).
+        if (!mt.inRetry) mt.retryRemaining = mt.retryCount;
+        if (mt.retryRemaining > 0) {
+            mt.retryRemaining--;
+            mt.inRetry = true;
+            mt.finished = false;
+            mt.nextRunTime = NowEpochSeconds() + std::max(1, mt.retryDelaySec);
+            mt.status = TaskStatus::Waiting;
+            Schedule(mt);
+            LOG_INFO("Scheduler::Retry",
+                "Task id=%d will retry in %ds (remaining=%d)",
+                mt.id, mt.retryDelaySec, mt.retryRemaining);
+        } else {
+            mt.inRetry = false;
+            mt.status = TaskStatus::Failed;
+        }
+    } else {
+        // Success — clear retry state
+        mt.inRetry = false;
+        mt.retryRemaining = 0;
+        if (!mt.finished) mt.status = TaskStatus::Waiting;
+    }
+}
+
+bool Scheduler::HasWaitingRun(int id) const {
+    std::scoped_lock lock(poolMutex_);
+    return waitingIds_.count(id) != 0;
+}
+
+void Scheduler::Dispatch(std::vector<ScheduledTask>& toRun) {
+    {
+        std::scoped_lock lock(poolMutex_);
+        const int64_t nowMicros = timing::MicrosNow();
+        for (auto& t : toRun) {
+            waitingIds_.insert(t.id);
+            jobs_.push_back(Job{ std::move(t), nowMicros });
+            ++metrics_.dispatched;
+        }
+    }
+    poolCv_.notify_all();
+}
+
+// First waiting run whose limits allow it to start now. Blocked runs keep their
+// place, so a run held back by its own limit or the input group does not stall
+// unrelated tasks queued behind it.
+bool Scheduler::TakeRunnable(Job& job) {
+    for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
+        const ScheduledTask& t = it->task;
+        if (t.exclusiveInput && inputBusy_) continue;
+        const auto active = activeRuns_.find(t.id);
+        if (t.maxConcurrent > 0 && active != activeRuns_.end() && active->second >= t.maxConcurrent) continue;
+
+        job = std::move(*it);
+        jobs_.erase(it);
+        waitingIds_.erase(job.task.id);
+        ++activeRuns_[job.task.id];
+        if (job.task.exclusiveInput) inputBusy_ = true;
+
+        const int64_t waited = timing::MicrosNow() - job.dispatchMicros;
+        ++metrics_.started;
+        metrics_.totalQueueMicros += waited;
+        metrics_.maxQueueMicros = std::max(metrics_.maxQueueMicros, waited);
+        metrics_.peakRunning = std::max(metrics_.peakRunning, ++metrics_.running);
+        return true;
+    }
+    return false;
+}
+
+void Scheduler::DropWaitingRuns() {
+    std::vector<int> dropped;
+    {
+        std::scoped_lock lock(poolMutex_);
+        for (const auto& job : jobs_) dropped.push_back(job.task.id);
+        jobs_.clear();
+        waitingIds_.clear();
+    }
+    if (dropped.empty()) return;
+    std::scoped_lock lock(mutex_);
+    for (int id : dropped) {
+        ScheduledTask* t = FindTask(id);
+        if (t && t->status == TaskStatus::Running) {
+            t->status = t->enabled ? TaskStatus::Waiting : TaskStatus::Disabled;
+            Touch(*t);
+        }
+    }
+    LOG_WARN("Scheduler::Stop", "Dropped %zu waiting run(s)", dropped.size());
+}
+
+// The timer thread only decides what is due and hands it to the executors, so
+// trigger times do not depend on how long callbacks take.
 void Scheduler::ThreadMain() {
+    std::unique_lock lock(mutex_);
     while (running_.load()) {
-        Sleep(500);
         const int64_t now = NowEpochSeconds();
-
         std::vector<ScheduledTask> toRun;
-        {
-            std::scoped_lock lock(mutex_);
+        CollectDue(now, toRun);
 
-            // Handle "run now" requests
-            for (int rid : pendingRunNow_) {
-                for (auto& t : tasks_) {
-                    if (t.id == rid) { toRun.push_back(t); break; }
-                }
-            }
-            pendingRunNow_.clear();
-
-            // Check scheduled triggers
-            // Sort by priority (higher first)
-            std::vector<int> indices;
-            for (int i = 0; i < (int)tasks_.size(); ++i) indices.push_back(i);
-            std::sort(indices.begin(), indices.end(), [&](int a, int b) {
-                return tasks_[a].priority > tasks_[b].priority;
-            });
-
-            for (int idx : indices) {
-                auto& t = tasks_[idx];
-                if (!t.enabled || t.finished) continue;
-                if (now < t.nextRunTime || t.nextRunTime <= 0) continue;
-                if (!IsInTimeWindow(t)) continue;
-
-                // Check if already in toRun (from RunNow)
-                bool dup = false;
-                for (const auto& r : toRun) if (r.id == t.id) { dup = true; break; }
-                if (dup) continue;
-
-                toRun.push_back(t);
-                t.runCount++;
-                t.lastRunTime = now;
-                t.status = TaskStatus::Running;
-
-                if (t.type == TaskType::OneShot) {
-                    t.finished = true;
-                    t.status = TaskStatus::Done;
-                } else {
-                    if (t.maxRuns > 0 && t.runCount >= t.maxRuns) {
-                        t.finished = true;
-                        t.status = TaskStatus::Done;
-                    } else {
-                        ComputeNextRun(t);
-                    }
-                }
-            }
+        if (!toRun.empty()) {
+            Dispatch(toRun);
+            continue;
+        }
+        // Sleep until the earliest deadline, or until a mutation
+        // (add/update/run-now/stop) says the queue changed.
+        wakeRequested_ = false;
+        auto woken = [this] { return wakeRequested_ || !running_.load(); };
+        if (queue_.empty()) {
+            cv_.wait(lock, woken);
+        } else {
+            const auto deadline = std::chrono::system_clock::time_point(std::chrono::seconds(queue_.front().due));
+            cv_.wait_until(lock, deadline, woken);
         }
+    }
+}
 
-        for (const auto& t : toRun) {
-            LOG_INFO("Scheduler::ThreadMain", "Executing task id=%d name='%s' run#%d",
-                t.id, t.name.c_str(), t.runCount);
-            TaskRunRecord rec;
-            rec.startTime = now;
-            rec.success = true;
-            if (callback_) {
-                try {
-                    callback_(t);
-                } catch (const std::exception& ex) {
-                    rec.success = false;
-                    rec.errorMsg = ex.what();
-                    LOG_ERROR("Scheduler::ThreadMain", "Task id=%d exception: %s", t.id, ex.what());
-                } catch (...) {
-                    rec.success = false;
-                    rec.errorMsg = "unknown exception";
-                    LOG_ERROR("Scheduler::ThreadMain", "Task id=%d unknown exception", t.id);
-                }
+void Scheduler::ExecutorMain() {
+    for (;;) {
+        Job job;
+        bool took = false;
+        {
+            std::unique_lock lock(poolMutex_);
+            poolCv_.wait(lock, [&] { return !running_.load() || (took = TakeRunnable(job)); });
+            if (!took) return;
+        }
+
+        const ScheduledTask& t = job.task;
+        LOG_INFO("Scheduler::ExecutorMain", "Executing task id=%d name='%s' run#%d",
+            t.id, t.name.c_str(), t.runCount);
+        const int64_t startMicros = timing::MicrosNow();
+        TaskRunRecord rec;
+        rec.startTime = NowEpochSeconds();
+        rec.success = true;
+        if (callback_) {
+            try {
+                callback_(t);
+            } catch (const std::exception& ex) {
+                rec.success = false;
+                rec.errorMsg = ex.what();
+                LOG_ERROR("Scheduler::ExecutorMain", "Task id=%d exception: %s", t.id, ex.what());
+            } catch (...) {
+                rec.success = false;
+                rec.errorMsg = "unknown exception";
+                LOG_ERROR("Scheduler::ExecutorMain", "Task id=%d unknown exception", t.id);
             }
-            rec.endTime = NowEpochSeconds();
+        }
+        rec.endTime = NowEpochSeconds();
+        const int64_t ranMicros = timing::MicrosNow() - startMicros;
 
-            // Update history
+        {
             std::scoped_lock lock(mutex_);
-            for (auto& mt : tasks_) {
-                if (mt.id == t.id) {
-                    mt.history.push_back(rec);
-                    if ((int)mt.history.size() > 20) mt.history.erase(mt.history.begin());
-                    if (!rec.success) {
-                        mt.failCount++;
-                        // Retry handling: if retryCount > 0 and we still have
-                        // remaining attempts in this cycle, schedule a retry.
-                        // Initialize retryRemaining at the start of a fresh cycle
-                        // (i.e. when a non-retry attempt fails).
-                        if (!mt.inRetry) mt.retryRemaining = mt.retryCount;
-                        if (mt.retryRemaining > 0) {
-                            mt.retryRemaining--;
-                            mt.inRetry = true;
-                            mt.finished = false;
-                            mt.nextRunTime = NowEpochSeconds() + std::max(1, mt.retryDelaySec);
-                            mt.status = TaskStatus::Waiting;
-                            LOG_INFO("Scheduler::Retry",
-                                "Task id=%d will retry in %ds (remaining=%d)",
-                                mt.id, mt.retryDelaySec, mt.retryRemaining);
-                        } else {
-                            mt.inRetry = false;
-                            mt.status = TaskStatus::Failed;
-                        }
-                    } else {
-                        // Success — clear retry state
-                        mt.inRetry = false;
-                        mt.retryRemaining = 0;
-                        if (!mt.finished) mt.status = TaskStatus::Waiting;
-                    }
-                    break;
-                }
-            }
-            // Note: if the task was removed while the callback was running,
-            // the history update is silently skipped — this is intentional.
+            RecordRun(t.id, rec);
         }
+        {
+            std::scoped_lock lock(poolMutex_);
+            if (--activeRuns_[t.id] <= 0) activeRuns_.erase(t.id);
+            if (t.exclusiveInput) inputBusy_ = false;
+            --metrics_.running;
+            ++metrics_.completed;
+            metrics_.totalRunMicros += ranMicros;
+            metrics_.maxRunMicros = std::max(metrics_.maxRunMicros, ranMicros);
+        }
+        // A finished run can unblock any waiting one (same task or input group).
+        poolCv_.notify_all();
     }
 }
 
@@ -293,6 +557,20 @@ int64_t Scheduler::ParseDateTime(const std::string& date, const std::string& tim
     return (int64_t)mktime(&t);
 }
 
+int64_t Scheduler::NextWindowStart(int startHour, int64_t now) {
+    time_t sec = (time_t)now;
+    struct tm t{}; localtime_s(&t, &sec);
+    for (int day = 0; day < 2; ++day) {
+        struct tm start = t;
+        start.tm_mday += day;
+        start.tm_hour = startHour; start.tm_min = 0; start.tm_sec = 0;
+        start.tm_isdst = -1;
+        const int64_t epoch = (int64_t)mktime(&start);
+        if (epoch > now) return epoch;
+    }
+    return now + 3600;   // mktime failed; try again in an hour
+}
+
 std::string Scheduler::FormatEpoch(int64_t epoch) {
     if (epoch <= 0) return "-";
     time_t sec = (time_t)epoch;
@@ -377,7 +655,8 @@ std::string Scheduler::Serialize() const {
            << t.retryCount << "|" << t.retryDelaySec << "|"
            << t.actionSpeed << "|" << (t.actionBlockInput ? 1 : 0) << "|"
            << t.failCount << "|" << t.createdTime << "|"
-           << EscapePipe(t.description) << "\n";
+           << EscapePipe(t.description) << "|"
+           << t.maxConcurrent << "|" << (t.exclusiveInput ? 1 : 0) << "\n";
     }
     return ss.str();
 }
@@ -431,6 +710,8 @@ void Scheduler::Deserialize(const std::string& data) {
             case 21: t.failCount = safeAtoi(field); break;
             case 22: t.createdTime = safeAtoll(field); break;
             case 23: t.description = UnescapePipe(field); break;
+            case 24: t.maxConcurrent = std::max(safeAtoi(field, 1), 0); break;
+            case 25: t.exclusiveInput = (field != "0"); break;
             }
             fi++;
         }
@@ -445,4 +726,9 @@ void Scheduler::Deserialize(const std::string& data) {
         }
     }
     nextId_ = maxId + 1;
+    published_.assign(tasks_.size(), nullptr);
+    ++tableVersion_;
+    RebuildIndex();
+    RebuildQueue();
+    NotifyWorker();
 }
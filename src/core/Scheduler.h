@@ -1,11 +1,16 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 enum class TaskType : int {
@@ -37,6 +42,25 @@ struct TaskRunRecord {
     std::string errorMsg;
 };
 
+// Executor pool counters. Queue latency runs from dispatch by the timer thread
+// to the start of the callback; run time is the callback itself.
+struct SchedulerMetrics {
+    uint64_t dispatched{ 0 };
+    uint64_t started{ 0 };
+    uint64_t completed{ 0 };
+    uint64_t coalesced{ 0 };    // due runs dropped: the task already had one waiting
+    int      running{ 0 };
+    int      queued{ 0 };
+    int      peakRunning{ 0 };
+    int64_t  totalQueueMicros{ 0 };
+    int64_t  maxQueueMicros{ 0 };
+    int64_t  totalRunMicros{ 0 };
+    int64_t  maxRunMicros{ 0 };
+
+    double MeanQueueMillis() const { return started ? totalQueueMicros / 1000.0 / started : 0.0; }
+    double MeanRunMillis() const { return completed ? totalRunMicros / 1000.0 / completed : 0.0; }
+};
+
 struct ScheduledTask {
     int         id{ 0 };
     std::string name;
@@ -70,6 +94,10 @@ struct ScheduledTask {
     float       actionSpeed{ 1.0f };// replay speed (trc only)
     bool        actionBlockInput{ false };
 
+    // Concurrency
+    int         maxConcurrent{ 1 };     // overlapping runs of this task (0 = unlimited)
+    bool        exclusiveInput{ true }; // drives the real mouse/keyboard: never overlaps another such task
+
     // Runtime state
     int         runCount{ 0 };
     int         failCount{ 0 };
@@ -85,6 +113,16 @@ struct ScheduledTask {
     // Internal retry state (not persisted; reset on Scheduler reload)
     int         retryRemaining{ 0 };  // remaining retries for the current cycle
     bool        inRetry{ false };     // currently scheduled as a retry attempt
+    uint32_t    scheduleVersion{ 0 }; // bumped on reschedule; older queue entries are stale
+};
+
+// Immutable view of the task table for readers such as the UI. Published
+// copy-on-write: a new snapshot is built only after the table changed, and only
+// the tasks that changed are copied into it; the rest share the previous copy.
+struct TaskSnapshot {
+    uint64_t version{ 0 };
+    std::vector<std::shared_ptr<const ScheduledTask>> tasks;   // table order
+    int activeCount{ 0 };
 };
 
 class Scheduler {
@@ -108,7 +146,14 @@ public:
     void ResetTask(int id);
     void RunTaskNow(int id);
 
+    // Executor pool size, i.e. the global concurrency limit; applies from the next Start().
+    void SetMaxConcurrency(int workers);
+    int  MaxConcurrency() const;
+    SchedulerMetrics Metrics() const;
+
     std::vector<ScheduledTask> GetTasks() const;
+    // Current snapshot; the same object is returned until a task changes.
+    std::shared_ptr<const TaskSnapshot> Snapshot() const;
     void ClearTasks();
     int  TaskCount() const;
     int  ActiveTaskCount() const;
@@ -119,21 +164,85 @@ public:
     static int64_t NowEpochSeconds();
     static int64_t ParseDateTime(const std::string& date, const std::string& time);
     static std::string FormatEpoch(int64_t epoch);
+    // First local time after now at which the clock reads startHour:00:00.
+    static int64_t NextWindowStart(int startHour, int64_t now);
     static std::string FormatDuration(int64_t seconds);
     static int64_t PeriodToSeconds(int interval, PeriodUnit unit);
     static const char* StatusName(TaskStatus s);
 
 private:
+    // Queue entry: the task is due at `due` (epoch seconds). Entries are never
+    // removed in place; a version mismatch marks them stale when popped.
+    struct QueueEntry {
+        int64_t  due{ 0 };
+        int      priority{ 0 };
+        uint64_t seq{ 0 };
+        int      id{ 0 };
+        uint32_t version{ 0 };
+    };
+    // Heap comparator: earliest due on top, then higher priority, then FIFO.
+    struct LaterEntry {
+        bool operator()(const QueueEntry& a, const QueueEntry& b) const {
+            if (a.due != b.due) return a.due > b.due;
+            if (a.priority != b.priority) return a.priority < b.priority;
+            return a.seq > b.seq;
+        }
+    };
+
+    // A run handed from the timer thread to the executor pool.
+    struct Job {
+        ScheduledTask task;
+        int64_t       dispatchMicros{ 0 };
+    };
+
     void ThreadMain();
+    void ExecutorMain();
     void ComputeNextRun(ScheduledTask& task);
     bool IsInTimeWindow(const ScheduledTask& task) const;
 
+    // All below require mutex_.
+    ScheduledTask* FindTask(int id);
+    void Touch(const ScheduledTask& task);   // task changed: republish it
+    void Schedule(ScheduledTask& task);
+    void PushEntry(const ScheduledTask& task, int64_t due);
+    void RebuildIndex();
+    void RebuildQueue();
+    void CollectDue(int64_t now, std::vector<ScheduledTask>& toRun);
+    void RecordRun(int id, const TaskRunRecord& rec);
+    void NotifyWorker();
+    bool HasWaitingRun(int id) const;   // takes poolMutex_
+    void Dispatch(std::vector<ScheduledTask>& toRun);   // takes poolMutex_
+    void DropWaitingRuns();
+
+    // Requires poolMutex_.
+    bool TakeRunnable(Job& job);
+
     mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool wakeRequested_{ false };
     std::vector<ScheduledTask> tasks_;
+    std::unordered_map<int, size_t> slotById_;   // id -> index into tasks_
+    // Published copy of each task, parallel to tasks_; null once the task changed.
+    mutable std::vector<std::shared_ptr<const ScheduledTask>> published_;
+    mutable std::shared_ptr<const TaskSnapshot> snapshot_;
+    uint64_t tableVersion_{ 1 };
+    std::vector<QueueEntry> queue_;              // min-heap via LaterEntry
+    uint64_t queueSeq_{ 0 };
     std::vector<int> pendingRunNow_;
     int nextId_{ 1 };
 
     std::atomic<bool> running_{ false };
     std::thread worker_;
     ActionCallback callback_;
+
+    // Executor pool. Lock order: mutex_ before poolMutex_.
+    mutable std::mutex poolMutex_;
+    std::condition_variable poolCv_;
+    std::deque<Job> jobs_;                      // dispatched, not started; FIFO
+    std::unordered_set<int> waitingIds_;        // ids with an entry in jobs_
+    std::unordered_map<int, int> activeRuns_;   // id -> runs in progress
+    bool inputBusy_{ false };                   // an exclusiveInput task is running
+    SchedulerMetrics metrics_;
+    int maxConcurrency_{ 4 };
+    std::vector<std::thread> executors_;
 };
@@ -0,0 +1,187 @@
+#pragma once
+// SpscRing.h — bounded single-producer/single-consumer ring buffer.
+// Indices are free-running and masked (N is a power of two). Each side keeps
+// its own index on a separate cache line together with a cached copy of the
+// other side's index, so the shared line is only touched when the cache says
+// the ring looks full (producer) or empty (consumer).
+//
+// The consumer can block in WaitReadable(): it spins for an adaptive budget,
+// then parks on an atomic wake sequence (WaitOnAddress/futex underneath).
+// Producers only pay for a notify while the consumer is actually parked.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+#include "core/HighResClock.h"
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing stores trivially copyable items");
+
+public:
+    static constexpr size_t kCapacity = N;
+
+    SpscRing() : buffer_(std::make_unique<T[]>(N)) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // ─── Producer ───────────────────────────────────────────────────────────
+
+    bool TryPush(const T& item) {
+        const size_t write = prod_.write.load(std::memory_order_relaxed);
+        if (write - prod_.cachedRead >= N) {
+            prod_.cachedRead = cons_.read.load(std::memory_order_acquire);
+            if (write - prod_.cachedRead >= N) return false;
+        }
+        buffer_[write & kMask] = item;
+        Publish(write + 1);
+        return true;
+    }
+
+    // Pushes as many items as fit (at most two memcpys) and returns that count.
+    size_t TryPushBulk(std::span<const T> items) {
+        const size_t write = prod_.write.load(std::memory_order_relaxed);
+        size_t free = N - (write - prod_.cachedRead);
+        if (free < items.size()) {
+            prod_.cachedRead = cons_.read.load(std::memory_order_acquire);
+            free = N - (write - prod_.cachedRead);
+        }
+        const size_t n = std::min(free, items.size());
+        if (n == 0) return 0;
+        const size_t at = write & kMask;
+        const size_t first = std::min(n, N - at);
+        std::memcpy(&buffer_[at], items.data(), first * sizeof(T));
+        std::memcpy(&buffer_[0], items.data() + first, (n - first) * sizeof(T));
+        Publish(write + n);
+        return n;
+    }
+
+    // Pushes all of items or nothing, for records that span several slots.
+    bool TryPushAll(std::span<const T> items) {
+        const size_t write = prod_.write.load(std::memory_order_relaxed);
+        if (N - (write - prod_.cachedRead) < items.size()) {
+            prod_.cachedRead = cons_.read.load(std::memory_order_acquire);
+            if (N - (write - prod_.cachedRead) < items.size()) return false;
+        }
+        return TryPushBulk(items) == items.size();
+    }
+
+    // ─── Consumer ───────────────────────────────────────────────────────────
+
+    // Longest contiguous run of readable items (up to maxItems). The items
+    // stay owned by the ring until Pop() releases them.
+    std::span<const T> FrontSpan(size_t maxItems = N) {
+        const size_t read = cons_.read.load(std::memory_order_relaxed);
+        // Only go to the producer's line when the cached index cannot satisfy
+        // the request; one load per batch is cheap, one per item is not.
+        if (cons_.cachedWrite - read < maxItems) {
+            cons_.cachedWrite = prod_.write.load(std::memory_order_acquire);
+            if (cons_.cachedWrite == read) return {};
+        }
+        const size_t at = read & kMask;
+        const size_t n = std::min({ cons_.cachedWrite - read, N - at, maxItems });
+        return std::span<const T>(&buffer_[at], n);
+    }
+
+    void Pop(size_t n) {
+        cons_.read.store(cons_.read.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Copies up to out.size() items into out and releases them.
+    size_t PopBulk(std::span<T> out) {
+        size_t copied = 0;
+        while (copied < out.size()) {
+            const auto run = FrontSpan(out.size() - copied);
+            if (run.empty()) break;
+            std::memcpy(out.data() + copied, run.data(), run.size() * sizeof(T));
+            copied += run.size();
+            Pop(run.size());
+        }
+        return copied;
+    }
+
+    // Returns once the ring is non-empty or keepWaiting turns false. Pair a
+    // store to keepWaiting with WakeConsumer().
+    void WaitReadable(const std::atomic<bool>& keepWaiting) {
+        static constexpr uint32_t kMinSpin = 16;
+        static constexpr uint32_t kMaxSpin = 4096;
+
+        const size_t read = cons_.read.load(std::memory_order_relaxed);
+        // Spin first: during bursts the next item usually arrives within a few
+        // microseconds, and a park/unpark round trip costs more than that.
+        for (uint32_t i = 0; i < cons_.spinLimit; ++i) {
+            if (prod_.write.load(std::memory_order_acquire) != read || !keepWaiting.load(std::memory_order_acquire)) {
+                cons_.spinLimit = std::min(cons_.spinLimit * 2, kMaxSpin);
+                return;
+            }
+            timing::CpuRelax();
+        }
+        cons_.spinLimit = std::max(cons_.spinLimit / 2, kMinSpin);
+
+        wake_.parked.store(true, std::memory_order_relaxed);
+        const uint32_t seq = wake_.seq.load(std::memory_order_acquire);
+        // Pairs with the fence in Publish(): either we see the new write index
+        // here, or the producer sees parked and bumps seq.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (prod_.write.load(std::memory_order_acquire) == read && keepWaiting.load(std::memory_order_acquire)) {
+            wake_.seq.wait(seq, std::memory_order_acquire);
+        }
+        wake_.parked.store(false, std::memory_order_relaxed);
+    }
+
+    void WakeConsumer() {
+        wake_.seq.fetch_add(1, std::memory_order_release);
+        wake_.seq.notify_one();
+    }
+
+    // ─── Either side ────────────────────────────────────────────────────────
+
+    size_t SizeApprox() const {
+        return prod_.write.load(std::memory_order_acquire) - cons_.read.load(std::memory_order_acquire);
+    }
+
+    // Empties the ring. Only valid while neither side is running.
+    void Reset() {
+        prod_.write.store(0, std::memory_order_relaxed);
+        prod_.cachedRead = 0;
+        cons_.read.store(0, std::memory_order_relaxed);
+        cons_.cachedWrite = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t kMask = N - 1;
+
+    void Publish(size_t write) {
+        prod_.write.store(write, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (wake_.parked.load(std::memory_order_relaxed)) WakeConsumer();
+    }
+
+    struct alignas(64) ProducerSide {
+        std::atomic<size_t> write{ 0 };
+        size_t cachedRead{ 0 };
+    };
+    struct alignas(64) ConsumerSide {
+        std::atomic<size_t> read{ 0 };
+        size_t cachedWrite{ 0 };
+        uint32_t spinLimit{ 64 };
+    };
+    struct alignas(64) WakeState {
+        std::atomic<bool> parked{ false };
+        std::atomic<uint32_t> seq{ 0 };
+    };
+
+    ProducerSide prod_;
+    ConsumerSide cons_;
+    WakeState wake_;
+    std::unique_ptr<T[]> buffer_;
+};
@@ -0,0 +1,78 @@
+#include "core/SyncEvent.h"
+
+#include <chrono>
+
+#include "core/HighResClock.h"
+
+namespace threading {
+
+#ifdef _WIN32
+
+Event::Event() : handle_(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+
+Event::~Event() {
+    if (handle_) CloseHandle(handle_);
+}
+
+void Event::Set() {
+    std::scoped_lock lock(mutex_);
+    set_.store(true, std::memory_order_release);
+    SetEvent(handle_);
+}
+
+void Event::Reset() {
+    if (!IsSet()) return;
+    std::scoped_lock lock(mutex_);
+    ResetEvent(handle_);
+    set_.store(false, std::memory_order_release);
+}
+
+void Event::Wait() const {
+    if (IsSet()) return;
+    WaitForSingleObject(handle_, INFINITE);
+}
+
+bool Event::WaitUntil(int64_t deadlineMicros) const {
+    if (IsSet()) return true;
+    const int64_t remaining = deadlineMicros - timing::MicrosNow();
+    if (remaining > 0) {
+        // Round up so a timed-out wait never returns before the deadline.
+        WaitForSingleObject(handle_, static_cast<DWORD>((remaining + 999) / 1000));
+    }
+    return IsSet();
+}
+
+#else
+
+Event::Event() = default;
+Event::~Event() = default;
+
+void Event::Set() {
+    std::scoped_lock lock(mutex_);
+    set_.store(true, std::memory_order_release);
+    cv_.notify_all();
+}
+
+void Event::Reset() {
+    if (!IsSet()) return;
+    std::scoped_lock lock(mutex_);
+    set_.store(false, std::memory_order_release);
+}
+
+void Event::Wait() const {
+    if (IsSet()) return;
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [this] { return IsSet(); });
+}
+
+bool Event::WaitUntil(int64_t deadlineMicros) const {
+    if (IsSet()) return true;
+    const int64_t remaining = deadlineMicros - timing::MicrosNow();
+    if (remaining <= 0) return false;
+    std::unique_lock lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::microseconds(remaining), [this] { return IsSet(); });
+}
+
+#endif
+
+} // namespace threading
@@ -0,0 +1,56 @@
+#pragma once
+// SyncEvent.h — manual-reset event used to cancel or interrupt waits.
+// Set() releases every current and future waiter until Reset(). IsSet() is a
+// plain atomic load, so hot loops can poll it for free, while sleepers block
+// on the event itself (a kernel event on Windows, a condition variable
+// elsewhere) and wake as soon as it is set instead of on their next poll.
+//
+// Typical use by a worker that sleeps until some state changes:
+//   event.Reset(); if (!StateChanged()) event.WaitUntil(deadline);
+// Writers change the state first, then call Set().
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <condition_variable>
+#endif
+
+namespace threading {
+
+class Event {
+public:
+    Event();
+    ~Event();
+
+    Event(const Event&) = delete;
+    Event& operator=(const Event&) = delete;
+
+    void Set();
+    void Reset();
+    bool IsSet() const { return set_.load(std::memory_order_acquire); }
+
+    void Wait() const;
+    // Waits until the event is set or timing::MicrosNow() reaches
+    // deadlineMicros; returns IsSet().
+    bool WaitUntil(int64_t deadlineMicros) const;
+
+#ifdef _WIN32
+    // For WaitForMultipleObjects together with other handles (timers, processes).
+    HANDLE NativeHandle() const { return handle_; }
+#endif
+
+private:
+    std::atomic<bool> set_{ false };
+    // Keeps set_ and the native state in step when Set and Reset race.
+    mutable std::mutex mutex_;
+#ifdef _WIN32
+    HANDLE handle_{ nullptr };
+#else
+    mutable std::condition_variable cv_;
+#endif
+};
+
+} // namespace threading
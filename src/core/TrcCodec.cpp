@@ -0,0 +1,376 @@
+#include "core/TrcCodec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace trc {
+
+// Tag byte: low 7 bits = event type, high bit = a data varint follows.
+// Types >= kTagEscapeType (never produced by the hooks, but legal in old
+// files) are written as kTagEscape + raw type byte + data varint.
+static constexpr uint8_t kTagHasData = 0x80;
+static constexpr uint8_t kTagEscapeType = 0x7F;
+static constexpr uint8_t kTagEscape = 0xFF;
+
+// Worst case per event: escape tag + type + 3 x 5-byte varints + 10-byte varint.
+static constexpr size_t kMaxEventBytes = 2 + 5 + 5 + 5 + 10;
+
+static uint64_t ZigZag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t UnZigZag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t* v) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        const uint8_t b = *p++;
+        result |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+void EncodeEvents(std::span<const RawEvent> events, std::vector<uint8_t>& out) {
+    out.reserve(out.size() + events.size() * 6);
+    int32_t prevX = 0;
+    int32_t prevY = 0;
+    for (const auto& e : events) {
+        const bool hasData = e.data != 0;
+        if (e.type < kTagEscapeType) {
+            out.push_back(static_cast<uint8_t>(e.type | (hasData ? kTagHasData : 0)));
+        } else {
+            out.push_back(kTagEscape);
+            out.push_back(e.type);
+        }
+        PutVarint(out, ZigZag(static_cast<int64_t>(e.x) - prevX));
+        PutVarint(out, ZigZag(static_cast<int64_t>(e.y) - prevY));
+        if (hasData || e.type >= kTagEscapeType) PutVarint(out, ZigZag(e.data));
+        PutVarint(out, ZigZag(e.timeDelta));
+        prevX = e.x;
+        prevY = e.y;
+    }
+}
+
+bool DecodeEvents(const uint8_t* data, size_t size, size_t count, RawEvent* out) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    int64_t prevX = 0;
+    int64_t prevY = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (p >= end) return false;
+        RawEvent e{};
+        const uint8_t tag = *p++;
+        bool hasData = (tag & kTagHasData) != 0;
+        if (tag == kTagEscape) {
+            if (p >= end) return false;
+            e.type = *p++;
+            hasData = true;
+        } else {
+            e.type = static_cast<uint8_t>(tag & ~kTagHasData);
+        }
+
+        uint64_t v = 0;
+        if (!GetVarint(p, end, &v)) return false;
+        prevX += UnZigZag(v);
+        if (!GetVarint(p, end, &v)) return false;
+        prevY += UnZigZag(v);
+        e.x = static_cast<int32_t>(prevX);
+        e.y = static_cast<int32_t>(prevY);
+        if (hasData) {
+            if (!GetVarint(p, end, &v)) return false;
+            e.data = static_cast<int32_t>(UnZigZag(v));
+        }
+        if (!GetVarint(p, end, &v)) return false;
+        e.timeDelta = UnZigZag(v);
+        out[i] = e;
+    }
+    return p == end;
+}
+
+// ─── LZ ─────────────────────────────────────────────────────────────────────
+
+static constexpr size_t kLzMinMatch = 4;
+static constexpr size_t kLzMaxOffset = 65535;
+static constexpr int kLzHashBits = 14;
+
+static uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t LzHash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - kLzHashBits);
+}
+
+static void PutLength(std::vector<uint8_t>& out, size_t len) {
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(len));
+}
+
+static void EmitSequence(std::vector<uint8_t>& out, const uint8_t* lit, size_t litLen, size_t offset, size_t matchLen) {
+    const size_t m = matchLen ? matchLen - kLzMinMatch : 0;
+    out.push_back(static_cast<uint8_t>(((litLen < 15 ? litLen : 15) << 4) | (m < 15 ? m : 15)));
+    if (litLen >= 15) PutLength(out, litLen - 15);
+    out.insert(out.end(), lit, lit + litLen);
+    if (matchLen == 0) return;
+    out.push_back(static_cast<uint8_t>(offset & 0xFF));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (m >= 15) PutLength(out, m - 15);
+}
+
+void LzCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    std::vector<uint32_t> table(size_t{ 1 } << kLzHashBits, 0);   // position + 1, 0 = empty
+    size_t anchor = 0;
+    size_t i = 0;
+    while (size >= kLzMinMatch && i <= size - kLzMinMatch) {
+        const uint32_t cur = Read32(data + i);
+        const uint32_t h = LzHash(cur);
+        const size_t cand = table[h];
+        table[h] = static_cast<uint32_t>(i + 1);
+        if (cand != 0 && i - (cand - 1) <= kLzMaxOffset && Read32(data + cand - 1) == cur) {
+            const size_t from = cand - 1;
+            size_t len = kLzMinMatch;
+            while (i + len < size && data[from + len] == data[i + len]) ++len;
+            EmitSequence(out, data + anchor, i - anchor, i - from, len);
+            i += len;
+            anchor = i;
+        } else {
+            ++i;
+        }
+    }
+    // Final sequence carries the trailing literals and no match.
+    EmitSequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+static bool GetLength(const uint8_t*& p, const uint8_t* end, size_t* len) {
+    while (true) {
+        if (p >= end) return false;
+        const uint8_t b = *p++;
+        *len += b;
+        if (b != 255) return true;
+    }
+}
+
+bool LzDecompress(const uint8_t* data, size_t size, uint8_t* out, size_t outSize) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    size_t o = 0;
+    while (p < end) {
+        const uint8_t token = *p++;
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !GetLength(p, end, &litLen)) return false;
+        if (litLen > static_cast<size_t>(end - p) || litLen > outSize - o) return false;
+        std::memcpy(out + o, p, litLen);
+        p += litLen;
+        o += litLen;
+        if (p == end) break;   // last sequence has no match
+
+        if (end - p < 2) return false;
+        const size_t offset = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        size_t matchLen = token & 0x0F;
+        if (matchLen == 15 && !GetLength(p, end, &matchLen)) return false;
+        matchLen += kLzMinMatch;
+        if (offset == 0 || offset > o || matchLen > outSize - o) return false;
+        // Byte-wise copy: matches may overlap their own output.
+        const uint8_t* src = out + o - offset;
+        for (size_t k = 0; k < matchLen; ++k) out[o + k] = src[k];
+        o += matchLen;
+    }
+    return o == outSize;
+}
+
+// ─── Blocks ─────────────────────────────────────────────────────────────────
+
+void EncodeBlock(std::span<const RawEvent> events, std::vector<uint8_t>& raw, std::vector<uint8_t>& out) {
+    raw.clear();
+    EncodeEvents(events, raw);
+
+    const size_t headerPos = out.size();
+    out.resize(headerPos + sizeof(BlockHeader));
+    LzCompress(raw.data(), raw.size(), out);
+
+    BlockHeader bh{};
+    bh.eventCount = static_cast<uint32_t>(events.size());
+    bh.rawBytes = static_cast<uint32_t>(raw.size());
+    bh.codec = static_cast<uint8_t>(BlockCodec::Lz);
+    size_t stored = out.size() - headerPos - sizeof(BlockHeader);
+    if (stored >= raw.size()) {
+        // Incompressible: keep the varint payload as-is.
+        out.resize(headerPos + sizeof(BlockHeader));
+        out.insert(out.end(), raw.begin(), raw.end());
+        stored = raw.size();
+        bh.codec = static_cast<uint8_t>(BlockCodec::Stored);
+    }
+    bh.storedBytes = static_cast<uint32_t>(stored);
+    std::memcpy(out.data() + headerPos, &bh, sizeof(bh));
+}
+
+bool DecodeBlock(const uint8_t* data, size_t size, std::vector<uint8_t>& scratch,
+    std::vector<RawEvent>& out, size_t* consumed) {
+    BlockHeader bh{};
+    if (size < sizeof(bh)) return false;
+    std::memcpy(&bh, data, sizeof(bh));
+    if (bh.eventCount == 0 || bh.eventCount > kBlockEvents) return false;
+    if (bh.rawBytes > bh.eventCount * kMaxEventBytes) return false;
+    if (bh.storedBytes > size - sizeof(bh)) return false;
+
+    const uint8_t* stored = data + sizeof(bh);
+    const uint8_t* payload = nullptr;
+    switch (static_cast<BlockCodec>(bh.codec)) {
+    case BlockCodec::Stored:
+        if (bh.storedBytes != bh.rawBytes) return false;
+        payload = stored;
+        break;
+    case BlockCodec::Lz:
+        scratch.resize(bh.rawBytes);
+        if (!LzDecompress(stored, bh.storedBytes, scratch.data(), scratch.size())) return false;
+        payload = scratch.data();
+        break;
+    default:
+        return false;
+    }
+
+    const size_t base = out.size();
+    out.resize(base + bh.eventCount);
+    if (!DecodeEvents(payload, bh.rawBytes, bh.eventCount, out.data() + base)) {
+        out.resize(base);
+        return false;
+    }
+    if (consumed) *consumed = sizeof(bh) + bh.storedBytes;
+    return true;
+}
+
+// ─── Packed text ────────────────────────────────────────────────────────────
+
+static constexpr char kBase64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void PackEventsText(std::span<const RawEvent> events, std::string& out) {
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i < events.size(); i += kBlockEvents) {
+        EncodeBlock(events.subspan(i, std::min<size_t>(kBlockEvents, events.size() - i)), raw, bytes);
+    }
+
+    out.reserve(out.size() + (bytes.size() + 2) / 3 * 4 * (kPackedLineChars + 1) / kPackedLineChars + 1);
+    size_t column = 0;
+    auto put = [&](char c) {
+        out.push_back(c);
+        if (++column == kPackedLineChars) {
+            out.push_back('\n');
+            column = 0;
+        }
+    };
+    size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        const uint32_t v = (uint32_t(bytes[i]) << 16) | (uint32_t(bytes[i + 1]) << 8) | bytes[i + 2];
+        put(kBase64Chars[v >> 18]);
+        put(kBase64Chars[(v >> 12) & 63]);
+        put(kBase64Chars[(v >> 6) & 63]);
+        put(kBase64Chars[v & 63]);
+    }
+    if (i < bytes.size()) {
+        const bool two = i + 1 < bytes.size();
+        const uint32_t v = (uint32_t(bytes[i]) << 16) | (two ? uint32_t(bytes[i + 1]) << 8 : 0);
+        put(kBase64Chars[v >> 18]);
+        put(kBase64Chars[(v >> 12) & 63]);
+        put(two ? kBase64Chars[(v >> 6) & 63] : '=');
+        put('=');
+    }
+    if (column != 0) out.push_back('\n');
+}
+
+bool UnpackEventsText(std::string_view text, std::vector<RawEvent>& out) {
+    static constexpr auto kValues = [] {
+        std::array<int8_t, 256> values{};
+        values.fill(-1);
+        for (int v = 0; v < 64; ++v) values[static_cast<uint8_t>(kBase64Chars[v])] = static_cast<int8_t>(v);
+        return values;
+    }();
+    out.clear();
+
+    std::vector<uint8_t> bytes(text.size() / 4 * 3 + 3);
+    uint8_t* o = bytes.data();
+    const char* p = text.data();
+    const char* const end = p + text.size();
+    uint32_t acc = 0;
+    int quad = 0;          // characters of the current group seen so far
+    size_t padding = 0;
+    while (p < end) {
+        // Nearly all groups are four data characters within a line.
+        if (quad == 0 && padding == 0 && end - p >= 4) {
+            const int a = kValues[static_cast<uint8_t>(p[0])];
+            const int b = kValues[static_cast<uint8_t>(p[1])];
+            const int c = kValues[static_cast<uint8_t>(p[2])];
+            const int d = kValues[static_cast<uint8_t>(p[3])];
+            if ((a | b | c | d) >= 0) {
+                const uint32_t v = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+                o[0] = static_cast<uint8_t>(v >> 16);
+                o[1] = static_cast<uint8_t>(v >> 8);
+                o[2] = static_cast<uint8_t>(v);
+                o += 3;
+                p += 4;
+                continue;
+            }
+        }
+        const char ch = *p++;
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') continue;
+        if (ch == '=') {
+            ++padding;
+            continue;
+        }
+        const int v = kValues[static_cast<uint8_t>(ch)];
+        if (v < 0 || padding != 0) return false;   // bad character, or data after padding
+        acc = (acc << 6) | static_cast<uint32_t>(v);
+        if (++quad == 4) {
+            o[0] = static_cast<uint8_t>(acc >> 16);
+            o[1] = static_cast<uint8_t>(acc >> 8);
+            o[2] = static_cast<uint8_t>(acc);
+            o += 3;
+            quad = 0;
+            acc = 0;
+        }
+    }
+    // A final partial group of 2 or 3 characters holds 1 or 2 bytes.
+    if (padding > 2 || quad == 1) return false;
+    if (quad == 2) *o++ = static_cast<uint8_t>(acc >> 4);
+    if (quad == 3) {
+        *o++ = static_cast<uint8_t>(acc >> 10);
+        *o++ = static_cast<uint8_t>(acc >> 2);
+    }
+    bytes.resize(static_cast<size_t>(o - bytes.data()));
+
+    std::vector<uint8_t> scratch;
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+        size_t consumed = 0;
+        if (!DecodeBlock(bytes.data() + pos, bytes.size() - pos, scratch, out, &consumed)) {
+            out.clear();
+            return false;
+        }
+        pos += consumed;
+    }
+    return true;
+}
+
+} // namespace trc
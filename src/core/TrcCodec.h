@@ -0,0 +1,45 @@
+#pragma once
+// TrcCodec.h — event block encoding used by the v2 .trc format.
+// Kept free of I/O so the same routines serve file reading/writing and any
+// other place that wants a compact event stream.
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/TrcFormat.h"
+
+namespace trc {
+
+// Appends the tag/varint encoding of events to out (delta state starts at zero).
+void EncodeEvents(std::span<const RawEvent> events, std::vector<uint8_t>& out);
+// Decodes exactly count events from data[0, size). Returns false if the input
+// is malformed or does not end exactly after the last event.
+bool DecodeEvents(const uint8_t* data, size_t size, size_t count, RawEvent* out);
+
+// LZ77 compression in LZ4-style sequences (token, literals, 16-bit offset).
+void LzCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+bool LzDecompress(const uint8_t* data, size_t size, uint8_t* out, size_t outSize);
+
+// Appends BlockHeader + payload for events (at most kBlockEvents) to out.
+// raw is scratch space for the uncompressed payload.
+void EncodeBlock(std::span<const RawEvent> events, std::vector<uint8_t>& raw, std::vector<uint8_t>& out);
+// Decodes the block at data[0, size) and appends its events to out.
+// consumed receives the on-disk size of the block (header included).
+bool DecodeBlock(const uint8_t* data, size_t size, std::vector<uint8_t>& scratch,
+    std::vector<RawEvent>& out, size_t* consumed);
+
+// Text form of an event sequence for embedding in scripts: the v2 blocks
+// above, base64-encoded in lines of kPackedLineChars characters. The text
+// contains no quotes, backslashes or ']', so it fits a Lua long string.
+static constexpr size_t kPackedLineChars = 76;
+// Appends the packed text of events to out.
+void PackEventsText(std::span<const RawEvent> events, std::string& out);
+// Replaces out with the events in text (whitespace is ignored). Returns false
+// if the text is not valid packed data.
+bool UnpackEventsText(std::string_view text, std::vector<RawEvent>& out);
+
+} // namespace trc
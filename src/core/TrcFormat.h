@@ -5,7 +5,9 @@
 namespace trc {
 
 static constexpr char kSignature[4] = { 'T', 'I', 'N', 'Y' };
-static constexpr int32_t kVersion = 1;
+static constexpr int32_t kVersionRaw = 1;      // header + packed RawEvent array
+static constexpr int32_t kVersionPacked = 2;   // header + compressed event blocks
+static constexpr int32_t kVersion = kVersionPacked;   // what the writer emits by default
 
 struct FileHeader {
     char signature[4];
@@ -33,4 +35,47 @@ enum class EventType : uint8_t {
     Wheel = 6
 };
 
+// v2 body: a sequence of blocks, each holding up to kBlockEvents events.
+// Inside a block every event is stored as a tag byte followed by zig-zag
+// varints (x/y as deltas from the previous event, data, timeDelta); delta
+// state resets at each block so blocks decode independently. The varint
+// payload is then optionally LZ-compressed.
+static constexpr uint32_t kBlockEvents = 4096;
+
+enum class BlockCodec : uint8_t {
+    Stored = 0,
+    Lz = 1
+};
+
+#pragma pack(push, 1)
+struct BlockHeader {
+    uint32_t eventCount;
+    uint32_t rawBytes;      // size of the varint payload once decompressed
+    uint32_t storedBytes;   // bytes that follow this header on disk
+    uint8_t codec;          // BlockCodec
+};
+#pragma pack(pop)
+
+// Optional footer written after the body (both versions): SeekEntry[count]
+// followed by a SeekTrailer at the very end of the file. One entry per
+// kIndexStride events maps elapsed time to the event index and, for v2, the
+// file offset of the block that starts there. Older readers stop after
+// totalEvents and never see it.
+static constexpr char kIndexMagic[4] = { 'T', 'I', 'D', 'X' };
+static constexpr uint32_t kIndexStride = kBlockEvents;
+
+#pragma pack(push, 1)
+struct SeekEntry {
+    int64_t timeMicros;   // sum of timeDelta of all events before eventIndex
+    int64_t eventIndex;
+    int64_t fileOffset;   // where event eventIndex (v1) or its block (v2) starts
+};
+
+struct SeekTrailer {
+    char magic[4];
+    uint32_t entryCount;
+    uint32_t stride;
+};
+#pragma pack(pop)
+
 } // namespace trc
@@ -1,48 +1,81 @@
 #include "core/TrcIO.h"
 
+#include <algorithm>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <limits>
+
+#include "core/TrcCodec.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace trc {
 
-bool WriteTrcFile(const std::wstring& filename, const std::vector<RawEvent>& events, int64_t* totalDurationMicrosOut) {
-    int64_t total = 0;
-    for (const auto& e : events) total += e.timeDelta;
-    if (totalDurationMicrosOut) *totalDurationMicrosOut = total;
+static bool IsValidHeader(const FileHeader& hdr) {
+    if (std::memcmp(hdr.signature, kSignature, sizeof(hdr.signature)) != 0) return false;
+    if (hdr.version != kVersionRaw && hdr.version != kVersionPacked) return false;
+    if (hdr.totalEvents < 0) return false;
+    return true;
+}
 
-    FileHeader hdr{};
-    std::memcpy(hdr.signature, kSignature, sizeof(hdr.signature));
-    hdr.version = kVersion;
-    hdr.totalEvents = static_cast<int32_t>(events.size());
-    hdr.totalDurationMicros = total;
+// Largest event count ReadTrcFile() will load into memory (~1GB of events).
+static constexpr size_t kMaxReadEvents = 50'000'000;
 
-    std::ofstream out(filename, std::ios::binary);
-    if (!out) return false;
-    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
-    if (!events.empty()) {
-        out.write(reinterpret_cast<const char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(RawEvent)));
+// Decodes the v2 block sequence in data[0, size) into out (exactly totalEvents events).
+static bool DecodeBlocks(const uint8_t* data, size_t size, size_t totalEvents, std::vector<RawEvent>& out) {
+    out.clear();
+    // totalEvents comes from an unchecked header; every block holds at most
+    // kBlockEvents events behind a BlockHeader, which bounds it by the size.
+    if (totalEvents > kMaxReadEvents || totalEvents / kBlockEvents > size / sizeof(BlockHeader)) return false;
+    out.reserve(totalEvents);
+    std::vector<uint8_t> scratch;
+    size_t pos = 0;
+    while (out.size() < totalEvents) {
+        size_t consumed = 0;
+        if (!DecodeBlock(data + pos, size - pos, scratch, out, &consumed)) return false;
+        pos += consumed;
     }
-    return out.good();
+    return out.size() == totalEvents;
+}
+
+bool WriteTrcFile(const std::wstring& filename, std::span<const RawEvent> events, int64_t* totalDurationMicrosOut,
+    int32_t version) {
+    TrcWriter writer;
+    if (!writer.Open(filename, version)) return false;
+    if (!writer.Append(events)) return false;
+    if (totalDurationMicrosOut) *totalDurationMicrosOut = writer.TotalDurationMicros();
+    return writer.Finish();
 }
 
 bool ReadTrcFile(const std::wstring& filename, TrcReadResult* out) {
     if (!out) return false;
-    std::ifstream in(filename, std::ios::binary);
+    std::ifstream in(std::filesystem::path(filename), std::ios::binary);
     if (!in) return false;
 
     FileHeader hdr{};
     in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
     if (!in) return false;
-    if (std::memcmp(hdr.signature, kSignature, sizeof(hdr.signature)) != 0) return false;
-    if (hdr.version != kVersion) return false;
-    if (hdr.totalEvents < 0) return false;
-    if (hdr.totalEvents > 50'000'000) return false;  // sanity limit: ~1GB
+    if (!IsValidHeader(hdr)) return false;
+    if (static_cast<size_t>(hdr.totalEvents) > kMaxReadEvents) return false;
 
     std::vector<RawEvent> events;
-    events.resize(static_cast<size_t>(hdr.totalEvents));
-    if (!events.empty()) {
-        in.read(reinterpret_cast<char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(RawEvent)));
-        if (!in) return false;
+    if (hdr.version == kVersionRaw) {
+        events.resize(static_cast<size_t>(hdr.totalEvents));
+        if (!events.empty()) {
+            in.read(reinterpret_cast<char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(RawEvent)));
+            if (!in) return false;
+        }
+    } else {
+        const std::vector<uint8_t> body((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!DecodeBlocks(body.data(), body.size(), static_cast<size_t>(hdr.totalEvents), events)) return false;
     }
 
     out->header = hdr;
@@ -50,5 +83,423 @@ bool ReadTrcFile(const std::wstring& filename, TrcReadResult* out) {
     return true;
 }
 
-} // namespace trc
+bool TrcBlockReader::Open(const std::wstring& filename) {
+    in_ = std::ifstream(std::filesystem::path(filename), std::ios::binary);
+    failed_ = true;
+    remaining_ = 0;
+    if (!in_) return false;
+    in_.read(reinterpret_cast<char*>(&header_), sizeof(header_));
+    if (!in_ || !IsValidHeader(header_)) return false;
+    remaining_ = header_.totalEvents;
+    failed_ = false;
+    return true;
+}
+
+bool TrcBlockReader::Next(std::vector<RawEvent>& out) {
+    out.clear();
+    if (failed_ || remaining_ <= 0) return false;
+
+    if (header_.version == kVersionRaw) {
+        out.resize(static_cast<size_t>(std::min<int64_t>(remaining_, kBlockEvents)));
+        in_.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size() * sizeof(RawEvent)));
+    } else {
+        BlockHeader bh{};
+        in_.read(reinterpret_cast<char*>(&bh), sizeof(bh));
+        // The writer never stores more than the raw payload, and an encoded
+        // event takes at most 27 bytes. DecodeBlock validates the rest; this
+        // only bounds the read.
+        if (in_ && bh.storedBytes <= bh.rawBytes && bh.rawBytes <= kBlockEvents * 32u) {
+            block_.resize(sizeof(bh) + bh.storedBytes);
+            std::memcpy(block_.data(), &bh, sizeof(bh));
+            in_.read(reinterpret_cast<char*>(block_.data() + sizeof(bh)), bh.storedBytes);
+        } else {
+            in_.setstate(std::ios::failbit);
+        }
+        if (in_ && (!DecodeBlock(block_.data(), block_.size(), scratch_, out, nullptr)
+            || static_cast<int64_t>(out.size()) > remaining_)) {
+            in_.setstate(std::ios::failbit);
+        }
+    }
+
+    if (!in_) {
+        failed_ = true;
+        out.clear();
+        return false;
+    }
+    remaining_ -= static_cast<int64_t>(out.size());
+    return true;
+}
+
+std::vector<SeekEntry> BuildSeekIndex(std::span<const RawEvent> events) {
+    std::vector<SeekEntry> index;
+    index.reserve(events.size() / kIndexStride + 1);
+    int64_t t = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (i % kIndexStride == 0) index.push_back({ t, static_cast<int64_t>(i), 0 });
+        t += events[i].timeDelta;
+    }
+    return index;
+}
+
+// Where a scan for timeMicros can start: the event of the last index entry
+// strictly before it (every event ahead of that fires earlier than
+// timeMicros) and the recorded time before that event.
+static SeekPosition ScanStart(std::span<const SeekEntry> index, int64_t timeMicros, size_t eventCount) {
+    auto it = std::lower_bound(index.begin(), index.end(), timeMicros,
+        [](const SeekEntry& e, int64_t v) { return e.timeMicros < v; });
+    if (it == index.begin()) return {};
+    --it;
+    return { std::min(static_cast<size_t>(it->eventIndex), eventCount), it->timeMicros };
+}
+
+SeekPosition FindSeekPosition(std::span<const RawEvent> events, std::span<const SeekEntry> index, int64_t timeMicros) {
+    const SeekPosition start = ScanStart(index, timeMicros, events.size());
+    size_t i = start.eventIndex;
+    int64_t t = start.eventTimeMicros;
+    for (; i < events.size(); ++i) {
+        t += events[i].timeDelta;
+        if (t >= timeMicros) return { i, t };
+    }
+    return { events.size(), t };
+}
+
+// ─── TrcWriter ──────────────────────────────────────────────────────────────
+
+TrcWriter::~TrcWriter() {
+    if (IsOpen()) Finish();
+}
+
+bool TrcWriter::Open(const std::wstring& filename, int32_t version) {
+    if (IsOpen()) Finish();
+    if (version != kVersionRaw && version != kVersionPacked) return false;
+
+    out_.open(std::filesystem::path(filename), std::ios::binary | std::ios::trunc);
+    if (!out_) return false;
+
+    version_ = version;
+    eventCount_ = 0;
+    totalDurationMicros_ = 0;
+    bytesWritten_ = sizeof(FileHeader);
+    index_.clear();
+    pending_.clear();
+    pending_.reserve(version_ == kVersionPacked ? kBlockEvents : 0);
+
+    // Placeholder header; the totals are patched in by Finish().
+    FileHeader hdr{};
+    std::memcpy(hdr.signature, kSignature, sizeof(hdr.signature));
+    hdr.version = version_;
+    out_.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    ok_ = out_.good();
+    return ok_;
+}
+
+bool TrcWriter::Append(std::span<const RawEvent> events) {
+    if (!IsOpen() || !ok_) return false;
+    if (eventCount_ + static_cast<int64_t>(events.size()) > std::numeric_limits<int32_t>::max()) {
+        ok_ = false;   // header stores the count as int32
+        return false;
+    }
+
+    // Work in stride-sized pieces so every index entry lands on a v2 block start.
+    while (!events.empty()) {
+        const size_t intoStride = static_cast<size_t>(eventCount_ % kIndexStride);
+        if (intoStride == 0) index_.push_back({ totalDurationMicros_, eventCount_, bytesWritten_ });
+        const size_t take = std::min<size_t>(events.size(), kIndexStride - intoStride);
+        const auto chunk = events.first(take);
+        for (const auto& e : chunk) totalDurationMicros_ += e.timeDelta;
+        eventCount_ += static_cast<int64_t>(take);
+        events = events.subspan(take);
+
+        if (version_ == kVersionRaw) {
+            out_.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size() * sizeof(RawEvent)));
+            bytesWritten_ += static_cast<int64_t>(chunk.size() * sizeof(RawEvent));
+            ok_ = out_.good();
+        } else {
+            pending_.insert(pending_.end(), chunk.begin(), chunk.end());
+            if (pending_.size() == kBlockEvents) FlushBlock();
+        }
+        if (!ok_) return false;
+    }
+    return ok_;
+}
+
+bool TrcWriter::FlushBlock() {
+    if (pending_.empty()) return ok_;
+    block_.clear();
+    EncodeBlock(pending_, raw_, block_);
+    pending_.clear();
+    out_.write(reinterpret_cast<const char*>(block_.data()), static_cast<std::streamsize>(block_.size()));
+    bytesWritten_ += static_cast<int64_t>(block_.size());
+    ok_ = out_.good();
+    return ok_;
+}
+
+bool TrcWriter::Finish() {
+    if (!IsOpen()) return false;
+    if (version_ == kVersionPacked) FlushBlock();
+
+    if (ok_ && !index_.empty()) {
+        SeekTrailer trailer{};
+        std::memcpy(trailer.magic, kIndexMagic, sizeof(trailer.magic));
+        trailer.entryCount = static_cast<uint32_t>(index_.size());
+        trailer.stride = kIndexStride;
+        out_.write(reinterpret_cast<const char*>(index_.data()), static_cast<std::streamsize>(index_.size() * sizeof(SeekEntry)));
+        out_.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+        ok_ = out_.good();
+    }
 
+    if (ok_) {
+        FileHeader hdr{};
+        std::memcpy(hdr.signature, kSignature, sizeof(hdr.signature));
+        hdr.version = version_;
+        hdr.totalEvents = static_cast<int32_t>(eventCount_);
+        hdr.totalDurationMicros = totalDurationMicros_;
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        ok_ = out_.good();
+    }
+    out_.close();
+    return ok_ && !out_.fail();
+}
+
+// ─── TrcView ────────────────────────────────────────────────────────────────
+
+TrcView::~TrcView() {
+    Close();
+}
+
+bool TrcView::Open(const std::wstring& filename) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    base_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const std::string path = std::filesystem::path(filename).string();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* view = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps its own reference to the file
+    if (view == MAP_FAILED) return false;
+    ::madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    base_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    std::memcpy(&header_, base_, sizeof(header_));
+    if (!IsValidHeader(header_)) {
+        Close();
+        return false;
+    }
+
+    LoadIndex();
+
+    eventCount_ = static_cast<size_t>(header_.totalEvents);
+    if (header_.version == kVersionRaw) {
+        if (eventCount_ > (size_ - sizeof(FileHeader)) / sizeof(RawEvent)) {
+            Close();
+            return false;
+        }
+        rawEvents_ = reinterpret_cast<const RawEvent*>(base_ + sizeof(FileHeader));
+    } else {
+        if (!IndexBlocks()) {
+            Close();
+            return false;
+        }
+        cache_.reserve(kCachedBlocks);
+    }
+
+    path_ = filename;
+    open_ = true;
+    return true;
+}
+
+// Records where each v2 block starts. Only the block headers are read, so
+// this touches one page per block instead of the whole body.
+bool TrcView::IndexBlocks() {
+    blocks_.clear();
+    blocks_.reserve(std::min(eventCount_ / kBlockEvents + 1, size_ / sizeof(BlockHeader)));
+    size_t pos = sizeof(FileHeader);
+    size_t events = 0;
+    while (events < eventCount_) {
+        BlockHeader bh{};
+        if (size_ - pos < sizeof(bh)) return false;
+        std::memcpy(&bh, base_ + pos, sizeof(bh));
+        if (bh.eventCount == 0 || bh.eventCount > kBlockEvents || bh.eventCount > eventCount_ - events) return false;
+        if (bh.storedBytes > size_ - pos - sizeof(bh)) return false;
+        blocks_.push_back({ pos, events });
+        pos += sizeof(bh) + bh.storedBytes;
+        events += bh.eventCount;
+    }
+    return true;
+}
+
+std::shared_ptr<const std::vector<RawEvent>> TrcView::DecodedBlock(size_t block) const {
+    std::scoped_lock lock(cacheMutex_);
+    ++useClock_;
+    CachedBlock* victim = nullptr;
+    for (auto& c : cache_) {
+        if (c.block == block) {
+            c.lastUse = useClock_;
+            return c.events;
+        }
+        if (!victim || c.lastUse < victim->lastUse) victim = &c;
+    }
+
+    const BlockRef& ref = blocks_[block];
+    const size_t end = block + 1 < blocks_.size() ? blocks_[block + 1].firstEvent : eventCount_;
+    auto events = std::make_shared<std::vector<RawEvent>>();
+    events->reserve(end - ref.firstEvent);
+    if (!DecodeBlock(base_ + ref.offset, size_ - ref.offset, scratch_, *events, nullptr)
+        || events->size() != end - ref.firstEvent) {
+        return nullptr;
+    }
+    if (cache_.size() < kCachedBlocks) victim = &cache_.emplace_back();
+    victim->block = block;
+    victim->lastUse = useClock_;
+    victim->events = std::move(events);
+    return victim->events;
+}
+
+std::span<const RawEvent> TrcView::EventsFrom(size_t index, std::shared_ptr<const void>& hold) const {
+    if (index >= eventCount_) return {};
+    if (rawEvents_) return std::span<const RawEvent>(rawEvents_ + index, eventCount_ - index);
+
+    const auto it = std::upper_bound(blocks_.begin(), blocks_.end(), index,
+        [](size_t i, const BlockRef& b) { return i < b.firstEvent; });
+    const size_t block = static_cast<size_t>(it - blocks_.begin()) - 1;
+    auto events = DecodedBlock(block);
+    if (!events) return {};
+    const auto span = std::span<const RawEvent>(*events).subspan(index - blocks_[block].firstEvent);
+    hold = std::move(events);
+    return span;
+}
+
+bool TrcView::CopyEvents(size_t first, size_t count, std::vector<RawEvent>& out) const {
+    out.clear();
+    first = std::min(first, eventCount_);
+    count = std::min(count, eventCount_ - first);
+    out.reserve(count);
+    std::shared_ptr<const void> hold;
+    while (out.size() < count) {
+        const auto span = EventsFrom(first + out.size(), hold);
+        if (span.empty()) {
+            out.clear();
+            return false;
+        }
+        const size_t take = std::min(span.size(), count - out.size());
+        out.insert(out.end(), span.begin(), span.begin() + static_cast<std::ptrdiff_t>(take));
+    }
+    return true;
+}
+
+SeekPosition TrcView::Seek(int64_t timeMicros) const {
+    const SeekPosition start = ScanStart(index_, timeMicros, eventCount_);
+    size_t i = start.eventIndex;
+    int64_t t = start.eventTimeMicros;
+    std::shared_ptr<const void> hold;
+    while (i < eventCount_) {
+        const auto span = EventsFrom(i, hold);
+        if (span.empty()) break;   // undecodable block: nothing past it can play
+        for (const auto& e : span) {
+            t += e.timeDelta;
+            if (t >= timeMicros) return { i, t };
+            ++i;
+        }
+    }
+    return { eventCount_, t };
+}
+
+void TrcView::LoadIndex() {
+    index_.clear();
+    if (size_ < sizeof(FileHeader) + sizeof(SeekTrailer)) return;
+    SeekTrailer trailer{};
+    std::memcpy(&trailer, base_ + size_ - sizeof(trailer), sizeof(trailer));
+    if (std::memcmp(trailer.magic, kIndexMagic, sizeof(trailer.magic)) != 0) return;
+    if (trailer.stride == 0 || trailer.entryCount == 0) return;
+    const size_t room = (size_ - sizeof(FileHeader) - sizeof(trailer)) / sizeof(SeekEntry);
+    if (trailer.entryCount > room) return;
+
+    index_.resize(trailer.entryCount);
+    const uint8_t* src = base_ + size_ - sizeof(trailer) - index_.size() * sizeof(SeekEntry);
+    std::memcpy(index_.data(), src, index_.size() * sizeof(SeekEntry));
+
+    // A damaged index only costs speed, never correctness: drop it and let
+    // FindSeekPosition scan instead.
+    int64_t prevIndex = -1;
+    int64_t prevTime = 0;
+    for (const auto& e : index_) {
+        if (e.eventIndex <= prevIndex || e.eventIndex >= header_.totalEvents || e.timeMicros < prevTime) {
+            index_.clear();
+            return;
+        }
+        prevIndex = e.eventIndex;
+        prevTime = e.timeMicros;
+    }
+}
+
+void TrcView::Unmap() {
+#ifdef _WIN32
+    if (base_) UnmapViewOfFile(base_);
+    if (mapping_) CloseHandle(static_cast<HANDLE>(mapping_));
+    if (file_) CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (base_) ::munmap(const_cast<uint8_t*>(base_), size_);
+#endif
+    base_ = nullptr;
+    size_ = 0;
+}
+
+void TrcView::Close() {
+    Unmap();
+    if (removeOnClose_ && !path_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::path(path_), ec);
+    }
+    removeOnClose_ = false;
+    open_ = false;
+    header_ = FileHeader{};
+    eventCount_ = 0;
+    index_.clear();
+    rawEvents_ = nullptr;
+    blocks_.clear();
+    cache_.clear();
+    scratch_.clear();
+    path_.clear();
+}
+
+std::shared_ptr<const TrcView> OpenTrcView(const std::wstring& filename) {
+    auto view = std::make_shared<TrcView>();
+    if (!view->Open(filename)) return nullptr;
+    return view;
+}
+
+} // namespace trc
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -13,8 +17,159 @@ struct TrcReadResult {
     std::vector<RawEvent> events;
 };
 
-bool WriteTrcFile(const std::wstring& filename, const std::vector<RawEvent>& events, int64_t* totalDurationMicrosOut);
+// Writes events as a .trc file. version selects the layout (kVersionRaw or
+// kVersionPacked); readers accept both.
+bool WriteTrcFile(const std::wstring& filename, std::span<const RawEvent> events, int64_t* totalDurationMicrosOut,
+    int32_t version = kVersion);
 bool ReadTrcFile(const std::wstring& filename, TrcReadResult* out);
 
-} // namespace trc
+// Where replay should resume for a given elapsed time: the first event that
+// fires at or after it, and that event's absolute fire time.
+struct SeekPosition {
+    size_t eventIndex{ 0 };
+    int64_t eventTimeMicros{ 0 };
+};
+
+// Builds the index the writer stores in the file footer. fileOffset is left 0:
+// where a v2 block lands is only known once it has been encoded.
+std::vector<SeekEntry> BuildSeekIndex(std::span<const RawEvent> events);
+// Binary-searches index for timeMicros, then scans at most one stride of
+// events. With an empty index this degrades to a linear scan from event 0.
+SeekPosition FindSeekPosition(std::span<const RawEvent> events, std::span<const SeekEntry> index, int64_t timeMicros);
+
+// Incremental .trc writer: Append() as many times as needed, then Finish()
+// to flush the last partial block, write the seek index and patch the header.
+class TrcWriter {
+public:
+    TrcWriter() = default;
+    ~TrcWriter();
+
+    TrcWriter(const TrcWriter&) = delete;
+    TrcWriter& operator=(const TrcWriter&) = delete;
+
+    bool Open(const std::wstring& filename, int32_t version = kVersion);
+    bool Append(std::span<const RawEvent> events);
+    bool Finish();
+    bool IsOpen() const { return out_.is_open(); }
+
+    int64_t EventCount() const { return eventCount_; }
+    int64_t TotalDurationMicros() const { return totalDurationMicros_; }
+
+private:
+    bool FlushBlock();
+
+    std::ofstream out_;
+    int32_t version_{ kVersion };
+    int64_t eventCount_{ 0 };
+    int64_t totalDurationMicros_{ 0 };
+    int64_t bytesWritten_{ 0 };
+    bool ok_{ false };
+    std::vector<SeekEntry> index_;
+    std::vector<RawEvent> pending_;   // v2: events of the block being filled
+    std::vector<uint8_t> raw_;        // v2: scratch for the varint payload
+    std::vector<uint8_t> block_;      // v2: encoded block ready to write
+};
+
+// Sequential reader holding one block of events at a time (kBlockEvents raw
+// events for v1, one encoded block for v2), for tools that walk a whole
+// recording once and should not need memory proportional to its length.
+class TrcBlockReader {
+public:
+    bool Open(const std::wstring& filename);
+    const FileHeader& Header() const { return header_; }
+    // Replaces out with the next events of the recording. Returns false once
+    // every event has been read, or on a read/decode error (then Failed()).
+    bool Next(std::vector<RawEvent>& out);
+    bool Failed() const { return failed_; }
+
+private:
+    std::ifstream in_;
+    FileHeader header_{};
+    int64_t remaining_{ 0 };
+    bool failed_{ false };
+    std::vector<uint8_t> block_;     // v2: BlockHeader + stored bytes
+    std::vector<uint8_t> scratch_;   // v2: decompressed payload
+};
 
+// Read-only, memory-mapped view over a .trc file. For v1 files events are
+// served straight from the mapping, so opening a recording costs no heap copy
+// of the event array and pages are faulted in lazily as consumers walk it.
+// v2 files stay mapped too: Open() only indexes the block headers, and blocks
+// are decoded when first read and kept in a small LRU cache, so memory use
+// does not grow with the length of the recording. Share it via
+// std::shared_ptr so the storage outlives every reader (e.g. a replay thread);
+// all reads are thread-safe.
+class TrcView {
+public:
+    TrcView() = default;
+    ~TrcView();
+
+    TrcView(const TrcView&) = delete;
+    TrcView& operator=(const TrcView&) = delete;
+
+    bool Open(const std::wstring& filename);
+    void Close();
+    bool IsOpen() const { return open_; }
+    // Deletes the file when the view is closed or destroyed, i.e. once the
+    // last reader sharing it is done (temporary recordings).
+    void RemoveFileOnClose() { removeOnClose_ = true; }
+
+    const std::wstring& Path() const { return path_; }
+    const FileHeader& Header() const { return header_; }
+    size_t EventCount() const { return eventCount_; }
+    // Seek index from the file footer; empty for files written without one.
+    std::span<const SeekEntry> Index() const { return index_; }
+
+    // Events from index up to the end of its block (v1: to the end of the
+    // recording). hold keeps a decoded block alive for as long as the span is
+    // used. Empty if index is past the end or the block fails to decode.
+    std::span<const RawEvent> EventsFrom(size_t index, std::shared_ptr<const void>& hold) const;
+    // Replaces out with events [first, first + count), clamped to the
+    // recording. Returns false if a block fails to decode.
+    bool CopyEvents(size_t first, size_t count, std::vector<RawEvent>& out) const;
+    // FindSeekPosition() over the view: decodes at most one block per index
+    // stride it has to scan.
+    SeekPosition Seek(int64_t timeMicros) const;
+
+private:
+    struct BlockRef {
+        size_t offset;       // of its BlockHeader, from the start of the file
+        size_t firstEvent;
+    };
+    struct CachedBlock {
+        size_t block{ 0 };
+        uint64_t lastUse{ 0 };
+        std::shared_ptr<const std::vector<RawEvent>> events;
+    };
+    static constexpr size_t kCachedBlocks = 8;
+
+    void Unmap();
+    void LoadIndex();
+    bool IndexBlocks();
+    std::shared_ptr<const std::vector<RawEvent>> DecodedBlock(size_t block) const;
+
+    bool open_{ false };
+    bool removeOnClose_{ false };
+    const uint8_t* base_{ nullptr };
+    size_t size_{ 0 };
+#ifdef _WIN32
+    void* file_{ nullptr };      // HANDLE
+    void* mapping_{ nullptr };   // HANDLE
+#endif
+    std::wstring path_;
+    FileHeader header_{};
+    size_t eventCount_{ 0 };
+    std::vector<SeekEntry> index_;
+    const RawEvent* rawEvents_{ nullptr };   // v1 only
+    std::vector<BlockRef> blocks_;           // v2 only
+
+    mutable std::mutex cacheMutex_;
+    mutable std::vector<CachedBlock> cache_;
+    mutable std::vector<uint8_t> scratch_;
+    mutable uint64_t useClock_{ 0 };
+};
+
+// Convenience wrapper: returns nullptr if the file cannot be mapped or is not a valid .trc.
+std::shared_ptr<const TrcView> OpenTrcView(const std::wstring& filename);
+
+} // namespace trc
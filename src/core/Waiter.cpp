@@ -0,0 +1,170 @@
+#include "core/Waiter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "core/HighResClock.h"
+#include "core/Logger.h"
+
+namespace timing {
+
+#ifdef _WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace {
+
+// A waitable timer tracks a single due time, so each waiting thread gets its own.
+struct ThreadTimer {
+    ThreadTimer() {
+        handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        // Rejected before Windows 10 1803; a plain timer still beats a Sleep(1) loop.
+        if (!handle) handle = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+    ~ThreadTimer() {
+        if (handle) CloseHandle(handle);
+    }
+    ThreadTimer(const ThreadTimer&) = delete;
+    ThreadTimer& operator=(const ThreadTimer&) = delete;
+
+    HANDLE handle{ nullptr };
+};
+
+} // namespace
+#endif
+
+Waiter& Waiter::Instance() {
+    static Waiter waiter;
+    return waiter;
+}
+
+Waiter::Waiter() {
+    Calibrate();
+}
+
+void Waiter::Calibrate() {
+    static constexpr int kSamples = 16;
+    static constexpr int64_t kProbeMicros = 1'000;
+
+    std::vector<int64_t> overshoot;
+    overshoot.reserve(kSamples);
+    for (int i = 0; i < kSamples; ++i) {
+        const int64_t target = MicrosNow() + kProbeMicros;
+        SleepUntil(target);
+        overshoot.push_back(std::max<int64_t>(MicrosNow() - target, 0));
+    }
+    std::sort(overshoot.begin(), overshoot.end());
+
+    // Second-worst sample plus a margin: a single outlier should not make
+    // every later wait spin for it; misses grow the window anyway.
+    const int64_t base = overshoot[kSamples - 2];
+    const int64_t window = std::clamp(base + base / 4 + kMinSpinMicros, kMinSpinMicros, kMaxSpinMicros);
+    calibratedMicros_.store(window, std::memory_order_relaxed);
+    spinWindowMicros_.store(window, std::memory_order_relaxed);
+    LOG_INFO("Waiter::Calibrate", "Timer overshoot p50=%lld max=%lld us, spin window=%lld us",
+        static_cast<long long>(overshoot[kSamples / 2]), static_cast<long long>(overshoot.back()),
+        static_cast<long long>(window));
+}
+
+void Waiter::WaitUntil(int64_t deadlineMicros) {
+    const int64_t wake = deadlineMicros - SpinWindowMicros();
+    if (wake > MicrosNow()) {
+        SleepUntil(wake);
+        NoteOvershoot(MicrosNow() - wake);
+    }
+    SpinUntil(deadlineMicros);
+}
+
+bool Waiter::WaitUntil(int64_t deadlineMicros, const threading::Event& cancel) {
+    if (cancel.IsSet()) return false;
+    const int64_t wake = deadlineMicros - SpinWindowMicros();
+    if (wake > MicrosNow()) {
+        if (!SleepUntil(wake, &cancel)) return false;
+        NoteOvershoot(MicrosNow() - wake);
+    }
+    const int64_t deadlineQpc = MicrosToQpcCeil(deadlineMicros);
+    while (QpcNow() < deadlineQpc) {
+        if (cancel.IsSet()) return false;
+        CpuRelax();
+    }
+    return true;
+}
+
+void Waiter::WaitFor(int64_t micros) {
+    if (micros <= 0) return;
+    WaitUntil(MicrosNow() + micros);
+}
+
+bool Waiter::WaitFor(int64_t micros, const threading::Event& cancel) {
+    if (micros <= 0) return !cancel.IsSet();
+    return WaitUntil(MicrosNow() + micros, cancel);
+}
+
+bool Waiter::SleepUntil(int64_t wakeMicros, const threading::Event* cancel) {
+    const int64_t remaining = wakeMicros - MicrosNow();
+    if (remaining <= 0) return true;
+#ifdef _WIN32
+    thread_local ThreadTimer timer;
+    if (timer.handle) {
+        LARGE_INTEGER due{};
+        due.QuadPart = -remaining * 10;   // relative, in 100 ns units
+        if (SetWaitableTimer(timer.handle, &due, 0, nullptr, nullptr, FALSE)) {
+            if (!cancel) {
+                WaitForSingleObject(timer.handle, INFINITE);
+                return true;
+            }
+            const HANDLE handles[2] = { timer.handle, cancel->NativeHandle() };
+            const DWORD r = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            if (r == WAIT_OBJECT_0 + 1) {
+                CancelWaitableTimer(timer.handle);
+                return false;
+            }
+            return true;
+        }
+    }
+    if (cancel) return !cancel->WaitUntil(wakeMicros);
+    Sleep(static_cast<DWORD>(remaining / 1000));
+    return true;
+#else
+    // The event's condition variable doubles as the timer when cancellable.
+    if (cancel) return !cancel->WaitUntil(wakeMicros);
+    // Absolute deadline, so a signal interrupting the sleep does not stretch it.
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const int64_t ns = ts.tv_nsec + remaining * 1000;
+    ts.tv_sec += static_cast<time_t>(ns / 1'000'000'000LL);
+    ts.tv_nsec = static_cast<long>(ns % 1'000'000'000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+    return true;
+#endif
+}
+
+void Waiter::SpinUntil(int64_t deadlineMicros) {
+    const int64_t deadlineQpc = MicrosToQpcCeil(deadlineMicros);
+    while (QpcNow() < deadlineQpc) CpuRelax();
+}
+
+// Late wake-ups widen the spin window by a quarter of the miss, so repeated
+// misses converge on the real overshoot while a single hiccup (preemption,
+// page fault) does not make every later wait spin; otherwise the window drifts
+// back toward the calibrated value.
+void Waiter::NoteOvershoot(int64_t overshootMicros) {
+    const int64_t window = spinWindowMicros_.load(std::memory_order_relaxed);
+    if (overshootMicros > window) {
+        spinWindowMicros_.store(std::min(window + (overshootMicros - window + 3) / 4, kMaxSpinMicros), std::memory_order_relaxed);
+        return;
+    }
+    const int64_t calibrated = calibratedMicros_.load(std::memory_order_relaxed);
+    if (window > calibrated) {
+        spinWindowMicros_.store(window - std::max<int64_t>((window - calibrated) / 16, 1), std::memory_order_relaxed);
+    }
+}
+
+} // namespace timing
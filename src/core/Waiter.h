@@ -0,0 +1,51 @@
+#pragma once
+// Waiter.h — high-resolution waits without burning a core.
+// A wait sleeps on a high-resolution waitable timer (clock_nanosleep with
+// TIMER_ABSTIME elsewhere) until shortly before the deadline, then spins with
+// a CPU pause hint for the rest. The length of that spin window is the
+// timer's measured wake-up overshoot: calibrated once on first use and grown
+// whenever a wake-up turns out later than expected.
+
+#include <atomic>
+#include <cstdint>
+
+#include "core/SyncEvent.h"
+
+namespace timing {
+
+class Waiter {
+public:
+    // Process-wide instance; calibrates on first use.
+    static Waiter& Instance();
+
+    // Blocks until MicrosNow() >= deadlineMicros.
+    void WaitUntil(int64_t deadlineMicros);
+    // Same, but returns false as soon as cancel is set (the sleep wakes on
+    // the event itself); true once the deadline was reached.
+    bool WaitUntil(int64_t deadlineMicros, const threading::Event& cancel);
+
+    void WaitFor(int64_t micros);
+    bool WaitFor(int64_t micros, const threading::Event& cancel);
+
+    // Current spin window (expected worst wake-up overshoot of the timer).
+    int64_t SpinWindowMicros() const { return spinWindowMicros_.load(std::memory_order_relaxed); }
+    // Re-measures the timer overshoot; takes a few milliseconds.
+    void Calibrate();
+
+private:
+    Waiter();
+
+    // Coarse phase: sleeps until about wakeMicros (never spins). Returns
+    // false if cancel was set first.
+    bool SleepUntil(int64_t wakeMicros, const threading::Event* cancel = nullptr);
+    void SpinUntil(int64_t deadlineMicros);
+    void NoteOvershoot(int64_t overshootMicros);
+
+    static constexpr int64_t kMinSpinMicros = 20;
+    static constexpr int64_t kMaxSpinMicros = 20'000;
+
+    std::atomic<int64_t> spinWindowMicros_{ 2'000 };
+    std::atomic<int64_t> calibratedMicros_{ 2'000 };
+};
+
+} // namespace timing
@@ -0,0 +1,571 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+extern "C" {
+#include "lauxlib.h"
+#include "lua.h"
+}
+
+#include "core/Converter.h"
+#include "core/HighResClock.h"
+#include "core/Logger.h"
+#include "core/PathSimplify.h"
+#include "core/Recorder.h"
+#include "core/SpscRing.h"
+#include "core/TrcCodec.h"
+#include "core/TrcIO.h"
+#include "core/Waiter.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// CPU time consumed by the whole process so far.
+double ProcessCpuMs() {
+#ifdef _WIN32
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto toMs = [](const FILETIME& ft) {
+        return static_cast<double>((static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 10'000.0;
+    };
+    return toMs(kernel) + toMs(user);
+#else
+    return static_cast<double>(std::clock()) * 1000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+double Percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t idx = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+    return v[idx];
+}
+
+// Roughly what the hooks produce: a 1 kHz cursor stream with small steps and
+// jitter, interrupted by clicks, key presses and wheel ticks.
+std::vector<trc::RawEvent> MakeRecording(size_t n) {
+    std::mt19937 rng{ 2024 };
+    std::uniform_int_distribution<int> step(-4, 4);
+    std::uniform_int_distribution<int> jitter(-150, 150);
+    std::uniform_int_distribution<int> action(0, 199);
+
+    std::vector<trc::RawEvent> v;
+    v.reserve(n);
+    int x = 960;
+    int y = 540;
+    while (v.size() < n) {
+        trc::RawEvent e{};
+        x += step(rng);
+        y += step(rng);
+        e.x = x;
+        e.y = y;
+        e.timeDelta = 1000 + jitter(rng);
+        switch (action(rng)) {
+        case 0:
+            e.type = static_cast<uint8_t>(trc::EventType::MouseDown);
+            e.data = 1;
+            break;
+        case 1:
+            e.type = static_cast<uint8_t>(trc::EventType::MouseUp);
+            e.data = 1;
+            break;
+        case 2:
+            e.type = static_cast<uint8_t>(trc::EventType::KeyDown);
+            e.data = 0x41 + action(rng) % 26;
+            break;
+        case 3:
+            e.type = static_cast<uint8_t>(trc::EventType::Wheel);
+            e.data = (action(rng) & 1) ? 120 : -120;
+            break;
+        default:
+            e.type = static_cast<uint8_t>(trc::EventType::MouseMove);
+            break;
+        }
+        v.push_back(e);
+    }
+    return v;
+}
+
+void BenchVersion(const std::vector<trc::RawEvent>& events, int32_t version, int iterations) {
+    const auto path = std::filesystem::temp_directory_path() / (version == trc::kVersionRaw ? "acp_bench_v1.trc" : "acp_bench_v2.trc");
+
+    double writeMs = 0.0;
+    double readMs = 0.0;
+    double viewMs = 0.0;
+    size_t checksum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        if (!trc::WriteTrcFile(path.wstring(), events, nullptr, version)) {
+            std::printf("v%d: write failed\n", version);
+            return;
+        }
+        writeMs += MsSince(t0);
+
+        t0 = Clock::now();
+        trc::TrcReadResult rr{};
+        if (!trc::ReadTrcFile(path.wstring(), &rr)) {
+            std::printf("v%d: read failed\n", version);
+            return;
+        }
+        readMs += MsSince(t0);
+        checksum += rr.events.size();
+
+        t0 = Clock::now();
+        auto view = trc::OpenTrcView(path.wstring());
+        if (!view) {
+            std::printf("v%d: open view failed\n", version);
+            return;
+        }
+        // Touch every event so the v1 mapping is actually paged in.
+        int64_t total = 0;
+        std::shared_ptr<const void> hold;
+        for (size_t i = 0; i < view->EventCount();) {
+            const auto span = view->EventsFrom(i, hold);
+            for (const auto& e : span) total += e.timeDelta;
+            i += std::max<size_t>(span.size(), 1);
+        }
+        viewMs += MsSince(t0);
+        checksum += static_cast<size_t>(total & 1);
+    }
+
+    const auto bytes = std::filesystem::file_size(path);
+    std::printf("v%d: %10llu bytes (%5.2f B/event)  write %8.2f ms  read %8.2f ms  view %8.2f ms  [%zu]\n",
+        version, static_cast<unsigned long long>(bytes), static_cast<double>(bytes) / static_cast<double>(events.size()),
+        writeMs / iterations, readMs / iterations, viewMs / iterations, checksum);
+    std::filesystem::remove(path);
+}
+
+// How long an event pushed by the hook thread takes to become visible via
+// EventCount(), with the drain thread idle (parked) in between, and how much
+// CPU an idle recording burns.
+void BenchDrainWakeup() {
+    Recorder rec;
+    rec.Start();
+    trc::RawEvent e{};
+    e.type = static_cast<uint8_t>(trc::EventType::MouseMove);
+
+    std::vector<double> latencyUs;
+    for (int i = 0; i < 500; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        const auto t0 = Clock::now();
+        rec.PushRawEvent(e);
+        while (rec.EventCount() < static_cast<size_t>(i + 1)) std::this_thread::yield();
+        latencyUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+
+    const double cpu0 = ProcessCpuMs();
+    const auto t0 = Clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const double idleCpuPct = 100.0 * (ProcessCpuMs() - cpu0) / MsSince(t0);
+    rec.Stop();
+
+    std::printf("drain wakeup: p50 %.1f us  p99 %.1f us  max %.1f us  idle cpu %.2f%%\n",
+        Percentile(latencyUs, 0.50), Percentile(latencyUs, 0.99), Percentile(latencyUs, 1.0), idleCpuPct);
+}
+
+// Hook-to-drain throughput: a producer pushing one event at a time (as the
+// hook callbacks do) against a consumer draining contiguous runs.
+void BenchRingThroughput() {
+    static constexpr size_t kEvents = 20'000'000;
+    auto ring = std::make_unique<SpscRing<trc::RawEvent, (1u << 18)>>();
+    std::atomic<bool> running{ true };
+    int64_t sum = 0;
+
+    // Uncontended cost of the producer side (fill, then drain, repeatedly).
+    {
+        trc::RawEvent e{};
+        const auto t = Clock::now();
+        for (size_t round = 0; round < kEvents / decltype(ring)::element_type::kCapacity; ++round) {
+            while (ring->TryPush(e)) {}
+            for (auto run = ring->FrontSpan(); !run.empty(); run = ring->FrontSpan()) ring->Pop(run.size());
+        }
+        std::printf("spsc push (single thread): %.1f ns/event\n", MsSince(t) * 1e6 / kEvents);
+    }
+
+    const auto t0 = Clock::now();
+    std::thread consumer([&] {
+        size_t seen = 0;
+        while (seen < kEvents) {
+            const auto batch = ring->FrontSpan(4096);
+            if (batch.empty()) {
+                ring->WaitReadable(running);
+                continue;
+            }
+            for (const auto& e : batch) sum += e.timeDelta;
+            seen += batch.size();
+            ring->Pop(batch.size());
+        }
+    });
+    trc::RawEvent e{};
+    for (size_t i = 0; i < kEvents; ++i) {
+        e.timeDelta = static_cast<int64_t>(i & 0xFF);
+        while (!ring->TryPush(e)) timing::CpuRelax();
+    }
+    consumer.join();
+    const double sec = MsSince(t0) / 1000.0;
+    std::printf("spsc ring: %.1f M events/s  [%lld]\n", kEvents / sec / 1e6, static_cast<long long>(sum));
+
+    // Same path through Recorder (ring + chunked store under its lock).
+    Recorder rec;
+    rec.Start();
+    const auto t1 = Clock::now();
+    for (size_t i = 0; i < kEvents / 4; ++i) {
+        rec.PushRawEvent(e);
+        if ((i & 0xFFF) == 0) {
+            while (rec.EventCount() + 200'000 < i) std::this_thread::yield();
+        }
+    }
+    while (rec.EventCount() + rec.DroppedCount() < kEvents / 4) std::this_thread::yield();
+    const double sec1 = MsSince(t1) / 1000.0;
+    std::printf("recorder push->store: %.1f M events/s  dropped %llu\n", (kEvents / 4) / sec1 / 1e6,
+        static_cast<unsigned long long>(rec.DroppedCount()));
+    rec.Stop();
+}
+
+// The Sleep(1)/yield loop the waits used before timing::Waiter.
+void LegacyWaitMicros(int64_t microseconds) {
+    const int64_t start = timing::MicrosNow();
+    while (true) {
+        const int64_t remaining = microseconds - (timing::MicrosNow() - start);
+        if (remaining <= 0) break;
+        if (remaining > 2000) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Wake error (actual minus requested) and CPU time per wait.
+template <typename WaitFn>
+void BenchWait(const char* name, int64_t micros, int waits, WaitFn&& wait) {
+    std::vector<double> errorUs;
+    errorUs.reserve(waits);
+    const double cpu0 = ProcessCpuMs();
+    for (int i = 0; i < waits; ++i) {
+        const int64_t start = timing::MicrosNow();
+        wait(micros);
+        errorUs.push_back(static_cast<double>(timing::MicrosNow() - start - micros));
+    }
+    const double cpuUs = (ProcessCpuMs() - cpu0) * 1000.0 / waits;
+    std::printf("%-7s %5lld us: err p50 %6.1f  p99 %7.1f  p999 %7.1f us  cpu %6.1f us/wait (%3.0f%%)  window %lld us\n", name,
+        static_cast<long long>(micros), Percentile(errorUs, 0.50), Percentile(errorUs, 0.99), Percentile(errorUs, 0.999),
+        cpuUs, 100.0 * cpuUs / static_cast<double>(micros), static_cast<long long>(timing::Waiter::Instance().SpinWindowMicros()));
+}
+
+void BenchWaiter() {
+    auto& waiter = timing::Waiter::Instance();
+    const int64_t durations[] = { 200, 1'000, 5'000 };
+    for (int64_t us : durations) {
+        const int waits = static_cast<int>(std::min<int64_t>(2'000, 2'000'000 / us));
+        BenchWait("legacy", us, waits, LegacyWaitMicros);
+        BenchWait("waiter", us, waits, [&](int64_t d) { waiter.WaitFor(d); });
+    }
+}
+
+// Caller-side cost of LOG_INFO: bursts that fit the thread's ring, with the
+// writer draining (and writing the file) in between.
+void BenchLogger() {
+    static constexpr int kBursts = 200;
+    static constexpr int kPerBurst = 256;
+    auto& logger = Logger::Instance();
+    const double nsPerTick = 1e9 / static_cast<double>(timing::QpcFrequency());
+    const auto path = std::filesystem::temp_directory_path() / "acp_bench.log";
+    for (const bool toFile : { false, true }) {
+        logger.SetFileOutput(toFile, path.string());
+        std::vector<double> ns;
+        ns.reserve(kBursts * kPerBurst);
+        for (int b = 0; b < kBursts; ++b) {
+            for (int i = 0; i < kPerBurst; ++i) {
+                const int64_t q0 = timing::QpcNow();
+                LOG_INFO("Bench::Logger", "Executing task id=%d name='%s' run#%d", i, "nightly export", b);
+                ns.push_back(static_cast<double>(timing::QpcNow() - q0) * nsPerTick);
+            }
+            logger.Flush();
+        }
+        std::printf("LOG_INFO (%s): p50 %.0f ns  p99 %.0f ns  p999 %.0f ns\n", toFile ? "file" : "memory",
+            Percentile(ns, 0.50), Percentile(ns, 0.99), Percentile(ns, 0.999));
+    }
+    logger.SetFileOutput(false);
+    std::filesystem::remove(path);
+
+    // Filtered out at the default level: one atomic load, no formatting.
+    static constexpr int kDisabled = 10'000'000;
+    const auto t = Clock::now();
+    for (int i = 0; i < kDisabled; ++i) LOG_DEBUG("Bench::Logger", "Executing task id=%d name='%s' run#%d", i, "nightly export", i);
+    std::printf("LOG_DEBUG (disabled): %.2f ns\n", MsSince(t) * 1e6 / kDisabled);
+}
+
+// The recursive, std::set-based RDP Converter used before SimplifyRdp, on
+// the array-of-structs points it used to build.
+struct LegacyPoint {
+    int x;
+    int y;
+    int64_t tMicros;
+};
+
+double LegacyPerpDistance(const LegacyPoint& p, const LegacyPoint& a, const LegacyPoint& b) {
+    const double dx = static_cast<double>(b.x) - a.x;
+    const double dy = static_cast<double>(b.y) - a.y;
+    const double denom = std::sqrt(dx * dx + dy * dy);
+    if (denom < 1e-6) {
+        const double ex = static_cast<double>(p.x) - a.x;
+        const double ey = static_cast<double>(p.y) - a.y;
+        return std::sqrt(ex * ex + ey * ey);
+    }
+    return std::abs(dy * p.x - dx * p.y + static_cast<double>(b.x) * a.y - static_cast<double>(b.y) * a.x) / denom;
+}
+
+void LegacyRdp(const std::vector<LegacyPoint>& pts, int start, int end, double eps, std::set<int>& keep) {
+    if (end <= start + 1) return;
+    double maxD = 0.0;
+    int idx = -1;
+    for (int i = start + 1; i < end; ++i) {
+        const double d = LegacyPerpDistance(pts[i], pts[start], pts[end]);
+        if (d > maxD) {
+            maxD = d;
+            idx = i;
+        }
+    }
+    if (idx >= 0 && maxD > eps) {
+        keep.insert(idx);
+        LegacyRdp(pts, start, idx, eps, keep);
+        LegacyRdp(pts, idx, end, eps, keep);
+    }
+}
+
+// 10M cursor samples: hand jitter (many points survive) and straight drags
+// with +-1 px noise (long scans, few survivors).
+CursorPath MakeCursorPath(size_t points, bool drags) {
+    std::mt19937 rng{ 99 };
+    std::uniform_int_distribution<int> jitter(-3, 3);
+    std::uniform_int_distribution<int> noise(-1, 1);
+    std::uniform_int_distribution<int> target(0, 3840);
+    CursorPath path;
+    path.Reserve(points);
+    double x = 1000, y = 800;
+    double vx = 0, vy = 0;
+    for (size_t i = 0; i < points; ++i) {
+        if (drags) {
+            if (i % 20'000 == 0) {
+                vx = (target(rng) - x) / 20'000.0;
+                vy = (target(rng) / 2 - y) / 20'000.0;
+            }
+            x += vx;
+            y += vy;
+            path.Push(static_cast<int32_t>(x) + noise(rng), static_cast<int32_t>(y) + noise(rng), static_cast<int64_t>(i) * 125);
+        } else {
+            x = std::clamp(x + jitter(rng), 0.0, 3840.0);
+            y = std::clamp(y + jitter(rng), 0.0, 2160.0);
+            path.Push(static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int64_t>(i) * 125);
+        }
+    }
+    return path;
+}
+
+void BenchPathSimplify() {
+    static constexpr size_t kPoints = 10'000'000;
+    const char* levelNames[] = { "scalar", "sse4.1", "avx" };
+    for (const bool drags : { false, true }) {
+        const CursorPath path = MakeCursorPath(kPoints, drags);
+        std::vector<LegacyPoint> legacyPts(kPoints);
+        for (size_t i = 0; i < kPoints; ++i) legacyPts[i] = LegacyPoint{ path.x[i], path.y[i], path.tMicros[i] };
+
+        const auto t0 = Clock::now();
+        std::set<int> legacy{ 0, static_cast<int>(kPoints - 1) };
+        LegacyRdp(legacyPts, 0, static_cast<int>(kPoints - 1), 2.0, legacy);
+        const double legacyMs = MsSince(t0);
+
+        std::vector<uint8_t> keep;
+        RdpScratch scratch;
+        SimplifyRdp(path.x, path.y, 2.0, keep, scratch);   // warm the buffers
+        const auto t1 = Clock::now();
+        const size_t kept = SimplifyRdp(path.x, path.y, 2.0, keep, scratch);
+        const double iterMs = MsSince(t1);
+        std::printf("rdp %s, %zu points: legacy %.0f ms, iterative (%s) %.0f ms (%.1fx), kept %zu%s\n",
+            drags ? "drags " : "jitter", kPoints, legacyMs, levelNames[static_cast<int>(BestSimdLevel())], iterMs,
+            legacyMs / iterMs, kept, kept == legacy.size() ? "" : "  MISMATCH");
+    }
+
+    // A recording split into strokes (a click every 20k samples), one thread
+    // vs one per core.
+    {
+        const CursorPath path = MakeCursorPath(kPoints, true);
+        std::vector<size_t> starts;
+        for (size_t s = 20'000; s < kPoints; s += 20'000) starts.push_back(s);
+        std::vector<uint8_t> keep;
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        double oneMs = 0.0;
+        for (const unsigned threads : { 1u, cores }) {
+            const auto t = Clock::now();
+            const size_t kept = SimplifyRdpSegments(path.x, path.y, starts, 2.0, keep, threads);
+            const double ms = MsSince(t);
+            if (threads == 1) oneMs = ms;
+            std::printf("rdp %zu segments, %u thread(s): %.0f ms (%.1fx), kept %zu\n",
+                starts.size() + 1, threads, ms, oneMs / ms, kept);
+            if (cores == 1) break;
+        }
+    }
+
+    // The distance scan alone: a cache-resident stretch (compute bound) and
+    // the whole path (bound by memory bandwidth), one chord per pass.
+    const CursorPath path = MakeCursorPath(kPoints, true);
+    for (const size_t span : { size_t{ 16'000 }, kPoints }) {
+        const size_t passes = std::max<size_t>(10, 200'000'000 / span);
+        double scalarNs = 0.0;
+        for (int level = 0; level <= static_cast<int>(BestSimdLevel()); ++level) {
+            size_t sum = 0;
+            const auto t = Clock::now();
+            for (size_t pass = 0; pass < passes; ++pass) {
+                sum += ScanChord(path.x.data(), path.y.data(), 1, span - 1, 3.0 + static_cast<double>(pass % 64), -7.0, 11.0,
+                    static_cast<SimdLevel>(level)).index;
+            }
+            const double ns = MsSince(t) * 1e6 / (static_cast<double>(passes) * static_cast<double>(span));
+            if (level == 0) scalarNs = ns;
+            std::printf("chord scan %-6s, %8zu points: %.3f ns/point (%.1fx)  [%zu]\n",
+                levelNames[level], span, ns, scalarNs / ns, sum);
+        }
+    }
+}
+
+// TrcToLuaFull as it was before streaming: the whole recording decoded into
+// memory and one ofstream << chain per line.
+bool LegacyTrcToLuaFull(const std::wstring& trcFile, const std::wstring& luaFile) {
+    trc::TrcReadResult rr{};
+    if (!trc::ReadTrcFile(trcFile, &rr)) return false;
+    std::ofstream out(std::filesystem::path(luaFile), std::ios::binary);
+    if (!out) return false;
+    out << "set_speed(1.0)\n";
+    for (const auto& e : rr.events) {
+        if (e.timeDelta > 0) out << "wait_us(" << e.timeDelta << ")\n";
+        switch (static_cast<trc::EventType>(e.type)) {
+        case trc::EventType::MouseMove: out << "mouse_move(" << e.x << "," << e.y << ")\n"; break;
+        case trc::EventType::MouseDown: out << "mouse_down(" << e.data << "," << e.x << "," << e.y << ")\n"; break;
+        case trc::EventType::MouseUp: out << "mouse_up(" << e.data << "," << e.x << "," << e.y << ")\n"; break;
+        case trc::EventType::Wheel: {
+            const bool horizontal = (e.data & (1 << 30)) != 0 && (static_cast<uint32_t>(e.data) & 0xFFFF0000u) != 0xFFFF0000u;
+            out << "mouse_wheel(" << static_cast<int16_t>(e.data & 0xFFFF) << "," << e.x << "," << e.y << "," << (horizontal ? 1 : 0) << ")\n";
+            break;
+        }
+        case trc::EventType::KeyDown: out << "vk_down(" << e.x << "," << ((e.data & 0x01) ? 1 : 0) << ")\n"; break;
+        case trc::EventType::KeyUp: out << "vk_up(" << e.x << "," << ((e.data & 0x01) ? 1 : 0) << ")\n"; break;
+        default: break;
+        }
+    }
+    return out.good();
+}
+
+void BenchTrcToLuaFull() {
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::wstring trcPath = (dir / "acp_bench_export.trc").wstring();
+    const std::wstring luaPath = (dir / "acp_bench_export.lua").wstring();
+    const auto events = MakeRecording(5'000'000);
+    trc::WriteTrcFile(trcPath, events, nullptr, trc::kVersionPacked);
+
+    auto run = [&](const char* name, bool (*convert)(const std::wstring&, const std::wstring&)) {
+        double best = 1e30;
+        for (int rep = 0; rep < 3; ++rep) {
+            const auto t = Clock::now();
+            convert(trcPath, luaPath);
+            best = std::min(best, MsSince(t));
+        }
+        const double mb = static_cast<double>(std::filesystem::file_size(luaPath)) / (1024.0 * 1024.0);
+        std::printf("trc->lua %-9s 5M events: %.0f ms, %.0f MB of Lua, %.0f MB/s\n", name, best, mb, mb / (best / 1000.0));
+        return best;
+    };
+    const double legacyMs = run("ofstream", LegacyTrcToLuaFull);
+    const double streamMs = run("streaming", Converter::TrcToLuaFull);
+    std::printf("trc->lua speedup: %.1fx\n", legacyMs / streamMs);
+    std::filesystem::remove(trcPath);
+    std::filesystem::remove(luaPath);
+}
+
+// What a script costs before its first event plays: Lua compiling the
+// per-event script vs. the compact one plus unpacking its event data.
+void BenchLuaExportLoad() {
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::wstring trcPath = (dir / "acp_bench_load.trc").wstring();
+    const std::wstring luaPath = (dir / "acp_bench_load.lua").wstring();
+    static constexpr size_t kEvents = 1'000'000;
+    const auto events = MakeRecording(kEvents);
+    trc::WriteTrcFile(trcPath, events, nullptr, trc::kVersionPacked);
+
+    auto readAll = [&] {
+        std::ifstream in(std::filesystem::path(luaPath), std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+    auto compile = [](const std::string& script) {
+        lua_State* L = luaL_newstate();
+        const auto t = Clock::now();
+        const int rc = luaL_loadbuffer(L, script.data(), script.size(), "export");
+        const double ms = MsSince(t);
+        lua_close(L);
+        return rc == LUA_OK ? ms : -1.0;
+    };
+
+    Converter::TrcToLuaFull(trcPath, luaPath);
+    const std::string full = readAll();
+    const double fullMs = compile(full);
+
+    Converter::TrcToLuaCompact(trcPath, luaPath);
+    const std::string compact = readAll();
+    const double compactMs = compile(compact);
+    std::vector<trc::RawEvent> chunk;
+    size_t unpacked = 0;
+    const auto t = Clock::now();
+    for (size_t pos = 0; (pos = compact.find("[[\n", pos)) != std::string::npos;) {
+        pos += 3;
+        const size_t end = compact.find("]]", pos);
+        trc::UnpackEventsText(std::string_view(compact).substr(pos, end - pos), chunk);
+        unpacked += chunk.size();
+    }
+    const double unpackMs = MsSince(t);
+
+    const double compactTotalMs = compactMs + unpackMs;
+    std::printf("lua export 1M events: per-event %.1f MB, compile %.0f ms (%.0f ns/event)\n",
+        static_cast<double>(full.size()) / (1024.0 * 1024.0), fullMs, fullMs * 1e6 / kEvents);
+    std::printf("lua export 1M events: compact %.1f MB, compile %.1f ms + unpack %.1f ms (%zu events, %.0f ns/event, %.0fx faster)\n",
+        static_cast<double>(compact.size()) / (1024.0 * 1024.0), compactMs, unpackMs, unpacked,
+        compactTotalMs * 1e6 / kEvents, fullMs / compactTotalMs);
+    std::filesystem::remove(trcPath);
+    std::filesystem::remove(luaPath);
+}
+
+} // namespace
+
+int main() {
+    BenchPathSimplify();
+    BenchTrcToLuaFull();
+    BenchLuaExportLoad();
+    BenchLogger();
+    BenchWaiter();
+    BenchDrainWakeup();
+    BenchRingThroughput();
+    const size_t counts[] = { 100'000, 1'000'000, 5'000'000 };
+    for (size_t n : counts) {
+        const auto events = MakeRecording(n);
+        std::printf("== %zu events ==\n", n);
+        BenchVersion(events, trc::kVersionRaw, 5);
+        BenchVersion(events, trc::kVersionPacked, 5);
+    }
+    return 0;
+}
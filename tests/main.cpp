@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdarg>
 #include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -9,9 +12,21 @@
 #include <thread>
 
 #include "core/Converter.h"
+#include "core/EventStore.h"
+#include "core/HighResClock.h"
+#include "core/InputSink.h"
+#include "core/LogFormat.h"
+#include "core/Logger.h"
+#include "core/MoveFilter.h"
+#include "core/PathSimplify.h"
+#include "core/Recorder.h"
 #include "core/Replayer.h"
 #include "core/Scheduler.h"
+#include "core/SpscRing.h"
+#include "core/SyncEvent.h"
+#include "core/TrcCodec.h"
 #include "core/TrcIO.h"
+#include "core/Waiter.h"
 
 static std::vector<trc::RawEvent> MakeEvents(size_t n) {
     std::mt19937 rng{ 12345 };
@@ -56,6 +71,496 @@ static void TestTrcRoundTrip() {
     }
 }
 
+static void TestTrcViewMapsEvents() {
+    const auto temp = std::filesystem::temp_directory_path() / "acp_test_view.trc";
+    auto events = MakeEvents(5000);
+    const bool wrote = trc::WriteTrcFile(temp.wstring(), events, nullptr, trc::kVersionRaw);
+    assert(wrote);
+
+    auto view = trc::OpenTrcView(temp.wstring());
+    assert(view);
+    assert(view->EventCount() == events.size());
+    std::shared_ptr<const void> hold;
+    const auto mapped = view->EventsFrom(0, hold);
+    assert(mapped.size() == events.size() && !hold);
+    assert(std::memcmp(mapped.data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+
+    // Replay straight out of the mapping; the replayer keeps the view alive.
+    Replayer r;
+    r.SetDryRun(true);
+    const bool started = r.Start(std::move(view), false, 10.0);
+    assert(started);
+    while (r.IsRunning()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(r.Progress01() == 1.0f);
+
+    // Truncated files must be rejected rather than mapped past their end.
+    std::filesystem::resize_file(temp, sizeof(trc::FileHeader) + 10 * sizeof(trc::RawEvent));
+    const auto truncatedView = trc::OpenTrcView(temp.wstring());
+    assert(!truncatedView);
+}
+
+static void TestTrcPackedMatchesRaw() {
+    const auto rawPath = std::filesystem::temp_directory_path() / "acp_test_v1.trc";
+    const auto packedPath = std::filesystem::temp_directory_path() / "acp_test_v2.trc";
+
+    // A cursor path with small steps plus a few clicks/keys, spanning several blocks.
+    std::mt19937 rng{ 777 };
+    std::uniform_int_distribution<int> step(-3, 3);
+    std::vector<trc::RawEvent> events;
+    int x = 500, y = 400;
+    for (int i = 0; i < 10000; ++i) {
+        trc::RawEvent e{};
+        x += step(rng);
+        y += step(rng);
+        e.x = x;
+        e.y = y;
+        e.timeDelta = 1000 + step(rng);
+        e.type = static_cast<uint8_t>(trc::EventType::MouseMove);
+        if (i % 997 == 0) {
+            e.type = static_cast<uint8_t>(trc::EventType::KeyDown);
+            e.data = 0x41;
+        }
+        events.push_back(e);
+    }
+    events[10].type = 0xFE;   // unknown types must survive the packed encoding
+    events[10].data = -7;
+
+    int64_t rawTotal = 0;
+    int64_t packedTotal = 0;
+    const bool wroteRaw = trc::WriteTrcFile(rawPath.wstring(), events, &rawTotal, trc::kVersionRaw);
+    const bool wrotePacked = trc::WriteTrcFile(packedPath.wstring(), events, &packedTotal, trc::kVersionPacked);
+    assert(wroteRaw && wrotePacked);
+    assert(rawTotal == packedTotal);
+    assert(std::filesystem::file_size(packedPath) * 4 < std::filesystem::file_size(rawPath));
+
+    trc::TrcReadResult rawRead{};
+    trc::TrcReadResult packedRead{};
+    const bool readRaw = trc::ReadTrcFile(rawPath.wstring(), &rawRead);
+    const bool readPacked = trc::ReadTrcFile(packedPath.wstring(), &packedRead);
+    assert(readRaw && readPacked);
+    assert(rawRead.header.version == trc::kVersionRaw);
+    assert(packedRead.header.version == trc::kVersionPacked);
+    assert(packedRead.header.totalDurationMicros == rawRead.header.totalDurationMicros);
+    assert(packedRead.events.size() == events.size());
+    assert(std::memcmp(packedRead.events.data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+    assert(std::memcmp(rawRead.events.data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+
+    auto view = trc::OpenTrcView(packedPath.wstring());
+    assert(view);
+    assert(view->EventCount() == events.size());
+    std::vector<trc::RawEvent> copied;
+    assert(view->CopyEvents(0, events.size(), copied));
+    assert(std::memcmp(copied.data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+
+    // Blocks are decoded on demand: a read returns the rest of one block only,
+    // and stays valid after the cache has moved on to other blocks.
+    std::shared_ptr<const void> hold;
+    const auto inBlock = view->EventsFrom(trc::kBlockEvents + 5, hold);
+    assert(inBlock.size() == trc::kBlockEvents - 5 && hold);
+    for (size_t i = 0; i < 4 * events.size(); i += 997) {
+        std::shared_ptr<const void> other;
+        assert(!view->EventsFrom(i % events.size(), other).empty());
+    }
+    assert(std::memcmp(inBlock.data(), &events[trc::kBlockEvents + 5], inBlock.size() * sizeof(trc::RawEvent)) == 0);
+    assert(view->CopyEvents(9990, 100, copied) && copied.size() == 10);
+    assert(std::memcmp(copied.data(), &events[9990], 10 * sizeof(trc::RawEvent)) == 0);
+
+    // A truncated block must fail to decode instead of yielding partial data.
+    std::filesystem::resize_file(packedPath, std::filesystem::file_size(packedPath) / 2);
+    trc::TrcReadResult truncated{};
+    const bool readTruncated = trc::ReadTrcFile(packedPath.wstring(), &truncated);
+    assert(!readTruncated);
+    const auto truncatedView = trc::OpenTrcView(packedPath.wstring());
+    assert(!truncatedView);
+}
+
+static void TestTrcSeekIndex() {
+    const auto temp = std::filesystem::temp_directory_path() / "acp_test_seek.trc";
+    auto events = MakeEvents(20000);
+    events[5000].timeDelta = 0;   // equal timestamps must not confuse the search
+    const bool wrote = trc::WriteTrcFile(temp.wstring(), events, nullptr);
+    assert(wrote);
+
+    auto view = trc::OpenTrcView(temp.wstring());
+    assert(view);
+    const auto index = view->Index();
+    const auto expected = trc::BuildSeekIndex(events);
+    assert(index.size() == (events.size() + trc::kIndexStride - 1) / trc::kIndexStride);
+    assert(index.size() == expected.size());
+    for (size_t i = 0; i < index.size(); ++i) {
+        assert(index[i].eventIndex == expected[i].eventIndex);
+        assert(index[i].timeMicros == expected[i].timeMicros);
+    }
+
+    // Indexed lookups must agree with a plain scan, including exact event times.
+    std::vector<int64_t> fireTimes;
+    int64_t t = 0;
+    for (const auto& e : events) fireTimes.push_back(t += e.timeDelta);
+    std::mt19937 rng{ 99 };
+    std::uniform_int_distribution<int64_t> pick(0, t + 10);
+    for (int i = 0; i < 2000; ++i) {
+        const int64_t target = (i % 2) ? pick(rng) : fireTimes[static_cast<size_t>(pick(rng)) % fireTimes.size()];
+        const auto fast = trc::FindSeekPosition(events, index, target);
+        const auto slow = trc::FindSeekPosition(events, {}, target);
+        const auto viewed = view->Seek(target);
+        assert(fast.eventIndex == slow.eventIndex && viewed.eventIndex == slow.eventIndex);
+        assert(fast.eventTimeMicros == slow.eventTimeMicros && viewed.eventTimeMicros == slow.eventTimeMicros);
+        if (fast.eventIndex < events.size()) assert(fireTimes[fast.eventIndex] >= target);
+        if (fast.eventIndex > 0 && fast.eventIndex < events.size()) assert(fireTimes[fast.eventIndex - 1] < target);
+    }
+
+    // Resuming near the end plays only the tail.
+    Replayer r;
+    r.SetDryRun(true);
+    const bool started = r.StartAt(view, fireTimes[19990] - 1, false, 10.0);
+    assert(started);
+    assert(r.Progress01() >= 0.99f);
+    while (r.IsRunning()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(r.Progress01() == 1.0f);
+    const bool pastEnd = r.StartAt(view, t + 1, false, 1.0);
+    assert(!pastEnd);
+}
+
+static void TestEventStoreChunks() {
+    const auto events = MakeEvents(3 * EventStore::kChunkEvents + 123);
+    EventStore store;
+    // Odd batch sizes so appends straddle chunk boundaries.
+    for (size_t i = 0; i < events.size();) {
+        const size_t n = std::min<size_t>(1 + (i * 7) % 1500, events.size() - i);
+        store.Append(std::span<const trc::RawEvent>(events).subspan(i, n));
+        i += n;
+    }
+    assert(store.Size() == events.size());
+
+    const auto snap = store.TakeSnapshot();
+    const auto all = snap.ToVector();
+    assert(std::memcmp(all.data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+    assert(snap[4100].x == events[4100].x);
+
+    size_t spans = 0;
+    size_t seen = 0;
+    snap.ForEachSpan([&](std::span<const trc::RawEvent> s) { ++spans; seen += s.size(); });
+    assert(spans == 4);
+    assert(seen == events.size());
+
+    std::vector<trc::RawEvent> range;
+    snap.CopyRange(4000, 200, range);
+    assert(range.size() == 200);
+    assert(std::memcmp(range.data(), &events[4000], 200 * sizeof(trc::RawEvent)) == 0);
+
+    // Snapshots are unaffected by later appends, trims and clears.
+    store.Append(events);
+    store.TrimFront(10);
+    assert(store.FirstIndex() % EventStore::kChunkEvents == 0);
+    assert(store.Size() >= 10 && store.Size() < 10 + EventStore::kChunkEvents);
+    store.Clear();
+    assert(snap.Size() == events.size());
+    assert(std::memcmp(snap.ToVector().data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+}
+
+static void TestSpscRingBulkAndThreads() {
+    SpscRing<uint32_t, 8> small;
+    const uint32_t items[] = { 1, 2, 3, 4, 5, 6 };
+    assert(small.TryPushBulk(items) == 6);
+    uint32_t out[4]{};
+    assert(small.PopBulk(out) == 4);
+    assert(out[0] == 1 && out[3] == 4);
+    // Wraps: 2 left + 6 pushed, only 6 fit.
+    assert(small.TryPushBulk(items) == 6);
+    assert(!small.TryPush(99));
+    const auto run = small.FrontSpan();
+    assert(run.size() == 4);   // contiguous up to the end of the buffer
+    assert(run[0] == 5 && run[1] == 6 && run[2] == 1 && run[3] == 2);
+    small.Pop(run.size());
+    assert(small.FrontSpan().size() == 4);
+
+    // Threaded: every value arrives exactly once and in order, with the
+    // consumer parking whenever the producer pauses.
+    static constexpr uint32_t kCount = 1'000'000;
+    SpscRing<uint32_t, 1024> ring;
+    std::atomic<bool> running{ true };
+    uint32_t expected = 0;
+    bool ordered = true;
+    std::thread consumer([&] {
+        while (expected < kCount) {
+            const auto batch = ring.FrontSpan();
+            if (batch.empty()) {
+                ring.WaitReadable(running);
+                continue;
+            }
+            for (uint32_t v : batch) ordered = ordered && (v == expected++);
+            ring.Pop(batch.size());
+        }
+    });
+    std::vector<uint32_t> chunk(300);
+    for (uint32_t next = 0; next < kCount;) {
+        if (next % 100'000 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        const uint32_t n = std::min<uint32_t>(static_cast<uint32_t>(chunk.size()), kCount - next);
+        for (uint32_t i = 0; i < n; ++i) chunk[i] = next + i;
+        next += static_cast<uint32_t>(ring.TryPushBulk(std::span<const uint32_t>(chunk.data(), n)));
+    }
+    consumer.join();
+    assert(ordered);
+    assert(expected == kCount);
+}
+
+static void TestRecorderStreamsToFile() {
+    const auto temp = std::filesystem::temp_directory_path() / "acp_test_stream.trc";
+    const auto copyPath = std::filesystem::temp_directory_path() / "acp_test_stream_copy.trc";
+    const auto events = MakeEvents(20000);
+
+    Recorder rec;
+    const bool started = rec.StartStreaming(temp.wstring(), 100);
+    assert(started);
+    for (size_t i = 0; i < 10000; ++i) rec.PushRawEvent(events[i]);
+    while (rec.EventCount() < 10000) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // Only the tail is held in memory, but counts cover the whole recording.
+    size_t first = 0;
+    const auto tail = rec.EventsCopy(&first);
+    assert(tail.size() >= 100 && tail.size() < 100 + EventStore::kChunkEvents);
+    assert(first + tail.size() == 10000);
+    assert(std::memcmp(tail.data(), &events[first], tail.size() * sizeof(trc::RawEvent)) == 0);
+    const bool savedWhileStreaming = rec.SaveToFile(copyPath.wstring());
+    assert(!savedWhileStreaming);
+
+    // Range reads see the same tail; reads before it are clamped.
+    const auto range = rec.AvailableRange();
+    assert(range.firstIndex == first && range.count == tail.size());
+    std::vector<trc::RawEvent> rows;
+    size_t rowFirst = rec.CopyRange(first + 5, 50, rows);
+    assert(rowFirst == first + 5 && rows.size() == 50);
+    assert(std::memcmp(rows.data(), &events[first + 5], 50 * sizeof(trc::RawEvent)) == 0);
+    rowFirst = rec.CopyRange(0, 10, rows);
+    assert(rowFirst == first && rows.size() == 10);
+    rec.CopyRange(10000, 10, rows);
+    assert(rows.empty());
+
+    // Events still in the ring when Stop() is called must reach the file.
+    for (size_t i = 10000; i < events.size(); ++i) rec.PushRawEvent(events[i]);
+    rec.Stop();
+
+    const auto view = rec.MappedView();
+    assert(view);
+    assert(rec.EventCount() == events.size());
+    const auto mapped = rec.AvailableRange();
+    assert(mapped.generation != range.generation && mapped.firstIndex == 0 && mapped.count == events.size());
+    rowFirst = rec.CopyRange(events.size() - 3, 10, rows);
+    assert(rowFirst == events.size() - 3 && rows.size() == 3);
+    assert(std::memcmp(rows.data(), &events[events.size() - 3], 3 * sizeof(trc::RawEvent)) == 0);
+    std::vector<trc::RawEvent> all;
+    assert(view->CopyEvents(0, view->EventCount(), all));
+    assert(std::memcmp(all.data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+    int64_t total = 0;
+    for (const auto& e : events) total += e.timeDelta;
+    assert(rec.TotalDurationMicros() == total);
+
+    const bool saved = rec.SaveToFile(copyPath.wstring());
+    assert(saved);
+    trc::TrcReadResult rr{};
+    const bool read = trc::ReadTrcFile(copyPath.wstring(), &rr);
+    assert(read);
+    assert(rr.events.size() == events.size());
+
+    // A temporary stream file lives until the last reader of the recording
+    // (here a view handed out before the recording was discarded) lets go.
+    const auto spill = std::filesystem::temp_directory_path() / "acp_test_stream_tmp.trc";
+    assert(rec.StartStreaming(spill.wstring(), 100, true));
+    for (size_t i = 0; i < 100; ++i) rec.PushRawEvent(events[i]);
+    rec.Stop();
+    auto spillView = rec.MappedView();
+    assert(spillView && spillView->EventCount() == 100);
+    rec.Clear();
+    assert(std::filesystem::exists(spill));
+    spillView.reset();
+    assert(!std::filesystem::exists(spill));
+    std::filesystem::remove(temp);
+    std::filesystem::remove(copyPath);
+}
+
+// An 8 kHz-style cursor stream (125 us apart, a 1 px step every other report)
+// with a click and a key press every 500 moves.
+static std::vector<trc::RawEvent> MakeHighRateMoves(size_t moves) {
+    std::vector<trc::RawEvent> v;
+    int32_t x = 100;
+    int32_t y = 100;
+    for (size_t i = 0; i < moves; ++i) {
+        trc::RawEvent e{};
+        e.type = static_cast<uint8_t>(trc::EventType::MouseMove);
+        e.timeDelta = 125;
+        if (i % 2) {
+            x += (i / 200) % 2 ? 1 : 0;
+            y += (i / 200) % 2 ? 0 : 1;
+        }
+        e.x = x;
+        e.y = y;
+        v.push_back(e);
+        if (i % 500 == 499) {
+            trc::RawEvent down = e;
+            down.type = static_cast<uint8_t>(trc::EventType::MouseDown);
+            down.data = 1;
+            down.timeDelta = 40;
+            trc::RawEvent up = down;
+            up.type = static_cast<uint8_t>(trc::EventType::MouseUp);
+            trc::RawEvent key{};
+            key.type = static_cast<uint8_t>(trc::EventType::KeyDown);
+            key.data = 0x41;
+            key.timeDelta = 300;
+            v.push_back(down);
+            v.push_back(up);
+            v.push_back(key);
+        }
+    }
+    return v;
+}
+
+static void TestMoveFilterKeepsNonMoves() {
+    const auto input = MakeHighRateMoves(20000);
+    const auto isMove = [](const trc::RawEvent& e) { return e.type == static_cast<uint8_t>(trc::EventType::MouseMove); };
+    int64_t inputTotal = 0;
+    std::vector<trc::RawEvent> inputOthers;
+    for (const auto& e : input) {
+        inputTotal += e.timeDelta;
+        if (!isMove(e)) inputOthers.push_back(e);
+    }
+
+    const MoveFilterMode modes[] = { MoveFilterMode::Off, MoveFilterMode::MinInterval, MoveFilterMode::MinDistance, MoveFilterMode::RdpLite };
+    for (MoveFilterMode mode : modes) {
+        MoveFilterConfig config;
+        config.mode = mode;
+        MoveFilter filter;
+        filter.Configure(config);
+
+        std::vector<trc::RawEvent> out;
+        trc::RawEvent buf[MoveFilter::kMaxOutput];
+        for (const auto& e : input) {
+            const size_t n = filter.Push(e, buf);
+            out.insert(out.end(), buf, buf + n);
+        }
+        out.insert(out.end(), buf, buf + filter.Flush(buf));
+
+        // Every click/key survives in order, at its original absolute time,
+        // and the cursor is where the click happened.
+        int64_t inTime = 0;
+        int64_t outTime = 0;
+        size_t inPos = 0;
+        size_t others = 0;
+        size_t moves = 0;
+        for (size_t i = 0; i < out.size(); ++i) {
+            outTime += out[i].timeDelta;
+            if (isMove(out[i])) {
+                ++moves;
+                continue;
+            }
+            while (isMove(input[inPos])) inTime += input[inPos++].timeDelta;
+            inTime += input[inPos].timeDelta;
+            assert(others < inputOthers.size());
+            assert(out[i].type == inputOthers[others].type && out[i].data == inputOthers[others].data);
+            assert(outTime == inTime);
+            ++inPos;
+            ++others;
+            if (out[i].type == static_cast<uint8_t>(trc::EventType::MouseDown)) {
+                assert(i > 0 && isMove(out[i - 1]));
+                assert(out[i - 1].x == out[i].x && out[i - 1].y == out[i].y);
+            }
+        }
+        assert(others == inputOthers.size());
+        assert(outTime == inputTotal);
+        assert(filter.InputMoves() == 20000 && filter.OutputMoves() == moves);
+        if (mode == MoveFilterMode::Off) {
+            assert(out.size() == input.size());
+        } else {
+            assert(moves < 20000 / 2);
+        }
+    }
+
+    // RdpLite keeps a corner even when the hold time runs out on the point after it.
+    {
+        MoveFilterConfig rdp;
+        rdp.mode = MoveFilterMode::RdpLite;
+        MoveFilter filter;
+        filter.Configure(rdp);
+        const int32_t path[][2] = { { 0, 0 }, { 10, 0 }, { 20, 0 }, { 30, 0 }, { 40, 0 }, { 40, 10 } };
+        std::vector<trc::RawEvent> out;
+        trc::RawEvent buf[MoveFilter::kMaxOutput];
+        for (const auto& p : path) {
+            trc::RawEvent e{};
+            e.type = static_cast<uint8_t>(trc::EventType::MouseMove);
+            e.x = p[0];
+            e.y = p[1];
+            e.timeDelta = 10'000;
+            out.insert(out.end(), buf, buf + filter.Push(e, buf));
+        }
+        out.insert(out.end(), buf, buf + filter.Flush(buf));
+        assert(out.size() == 3);
+        assert(out[1].x == 40 && out[1].y == 0 && out[1].timeDelta == 40'000);
+        assert(out[2].x == 40 && out[2].y == 10 && out[2].timeDelta == 10'000);
+    }
+
+    // Through the recorder: the held move is flushed on Stop().
+    Recorder rec;
+    MoveFilterConfig config;
+    config.mode = MoveFilterMode::MinInterval;
+    rec.SetMoveFilter(config);
+    rec.Start();
+    for (size_t i = 0; i < 100; ++i) rec.PushRawEvent(input[i]);
+    rec.Stop();
+    const auto recorded = rec.EventsCopy();
+    assert(!recorded.empty());
+    assert(recorded.back().x == input[99].x && recorded.back().y == input[99].y);
+    assert(rec.TotalDurationMicros() == 100 * 125);
+    assert(rec.MoveStats().inputMoves == 100 && rec.MoveStats().outputMoves == recorded.size());
+}
+
+static void TestWaiterDeadlinesAndCancel() {
+    auto& waiter = timing::Waiter::Instance();
+    for (int64_t us : { 50, 700, 3'000 }) {
+        const int64_t start = timing::MicrosNow();
+        waiter.WaitFor(us);
+        assert(timing::MicrosNow() - start >= us);
+    }
+    // Deadlines in the past return immediately.
+    waiter.WaitUntil(timing::MicrosNow() - 1'000);
+
+    // A cancelled wait returns as soon as the event is set, not on a poll tick.
+    threading::Event cancel;
+    int64_t setAt = 0;
+    std::thread canceller([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        setAt = timing::MicrosNow();
+        cancel.Set();
+    });
+    const bool completed = waiter.WaitFor(5'000'000, cancel);
+    const int64_t wokeAt = timing::MicrosNow();
+    canceller.join();
+    assert(!completed);
+    assert(wokeAt - setAt < 20'000);
+    cancel.Reset();
+    assert(!cancel.IsSet() && waiter.WaitFor(100, cancel));
+}
+
+static void TestReplayerStopWhilePaused() {
+    // Ten-second gaps: stop and pause must not wait for the next event.
+    std::vector<trc::RawEvent> events(3);
+    for (auto& e : events) {
+        e.type = static_cast<uint8_t>(trc::EventType::MouseMove);
+        e.timeDelta = 10'000'000;
+    }
+    Replayer r;
+    r.SetDryRun(true);
+    assert(r.Start(events, false, 1.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    r.Pause();
+    r.SetSpeed(2.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto t0 = std::chrono::steady_clock::now();
+    r.Stop();
+    const auto stopMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    assert(!r.IsRunning());
+    assert(stopMs < 100.0);
+    assert(r.TimingStats().events == 0);
+}
+
 static void TestReplayerRestartNoTerminate() {
     Replayer r;
     r.SetDryRun(true);
@@ -88,6 +593,160 @@ static std::string ReadAllBytes(const std::filesystem::path& p) {
     return ss.str();
 }
 
+static void TestReplayerDeadlineClock() {
+    // 2000 events, 1 ms apart, at 4x: 500 ms of schedule. Relative waits would
+    // add every wake-up overshoot on top of that; deadlines must not.
+    std::vector<trc::RawEvent> events(2000);
+    for (auto& e : events) {
+        e.type = static_cast<uint8_t>(trc::EventType::MouseMove);
+        e.timeDelta = 1000;
+    }
+
+    Replayer r;
+    r.SetDryRun(true);
+    const auto t0 = std::chrono::steady_clock::now();
+    assert(r.Start(events, false, 4.0));
+    // Halve the speed partway: the remaining 1000 ms of recording takes 500 ms.
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    r.SetSpeed(2.0);
+    while (r.IsRunning()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const auto elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    const ReplayTimingStats stats = r.TimingStats();
+    assert(stats.events == events.size());
+    assert(elapsedMs >= 700.0 && elapsedMs < 900.0);
+    assert(stats.finalDriftMicros < 50'000);
+    assert(stats.PercentileMicros(0.5) <= stats.PercentileMicros(0.99));
+    assert(stats.PercentileMicros(1.0) <= stats.maxLatenessMicros);
+}
+
+class RecordingSink final : public InputSink {
+public:
+    void FocusAt(int x, int y) override {
+        focus.push_back(POINT{ x, y });
+        calls += 'F';
+    }
+    size_t Send(std::span<INPUT> inputs) override {
+        batches.emplace_back(inputs.begin(), inputs.end());
+        calls += 'S';
+        return inputs.size();
+    }
+
+    std::vector<POINT> focus;
+    std::vector<std::vector<INPUT>> batches;
+    std::string calls;   // 'F' per FocusAt, 'S' per Send, in call order
+};
+
+static void TestReplayerBatchesDueEvents() {
+    auto make = [](trc::EventType type, int32_t x, int32_t y, int32_t data, int64_t delta) {
+        trc::RawEvent e{};
+        e.type = static_cast<uint8_t>(type);
+        e.x = x;
+        e.y = y;
+        e.data = data;
+        e.timeDelta = delta;
+        return e;
+    };
+    std::vector<trc::RawEvent> events;
+    // A burst all due at once: moves, a click, a wheel tick and a key press.
+    for (int i = 0; i < 10; ++i) events.push_back(make(trc::EventType::MouseMove, 100 + i, 200, 0, 0));
+    events.push_back(make(trc::EventType::MouseDown, 110, 200, 1, 0));
+    events.push_back(make(trc::EventType::MouseUp, 110, 200, 1, 0));
+    events.push_back(make(trc::EventType::Wheel, 110, 200, 120, 0));
+    events.push_back(make(trc::EventType::KeyDown, 0x41, 0, 0, 0));
+    // Two later keystrokes at the same spot: focus once, not per key.
+    events.push_back(make(trc::EventType::KeyUp, 0x41, 0, 0, 20'000));
+    events.push_back(make(trc::EventType::KeyDown, 0x42, 0, 0, 20'000));
+
+    auto sink = std::make_shared<RecordingSink>();
+    Replayer r;
+    r.SetInputSink(sink);
+    assert(r.IdleEvent().IsSet());
+    assert(r.Start(events, false, 1.0));
+    assert(!r.IdleEvent().IsSet());
+    assert(!r.WaitIdleUntil(timing::MicrosNow() + 5'000));   // the keys are 20 ms apart
+    assert(r.WaitIdleUntil(timing::MicrosNow() + 5'000'000) && !r.IsRunning());
+
+    // The click goes out before the wheel's focus; wheel and key share the next Send.
+    assert(sink->batches.size() == 4);
+    const auto& burst = sink->batches[0];
+    assert(burst.size() == 10 + 2 + 2);
+    assert(burst[11].type == INPUT_MOUSE && burst[11].mi.dwFlags == MOUSEEVENTF_LEFTDOWN);
+    const auto& focused = sink->batches[1];
+    assert(focused.size() == 2 + 1);
+    assert(focused[1].mi.dwFlags == MOUSEEVENTF_WHEEL && focused[1].mi.mouseData == 120);
+    assert(focused[2].type == INPUT_KEYBOARD && focused[2].ki.wVk == 0x41 && focused[2].ki.dwFlags == 0);
+    assert(sink->batches[2].size() == 1 && (sink->batches[2][0].ki.dwFlags & KEYEVENTF_KEYUP) != 0);
+    assert(sink->calls.rfind("SFS", 0) == 0);
+    assert(sink->focus.size() == 2);
+    assert(sink->focus[0].x == 110 && sink->focus[0].y == 200);
+    assert(r.TimingStats().events == events.size());
+
+    // Wheel ticks due together over two different windows: each one gets its
+    // own focus, so the batch is split at the second one.
+    const std::vector<trc::RawEvent> wheels = {
+        make(trc::EventType::Wheel, 10, 10, 120, 0),
+        make(trc::EventType::Wheel, 10, 10, 120, 0),
+        make(trc::EventType::Wheel, 300, 300, 120, 0),
+    };
+    auto wheelSink = std::make_shared<RecordingSink>();
+    Replayer wheelReplay;
+    wheelReplay.SetInputSink(wheelSink);
+    assert(wheelReplay.Start(wheels, false, 1.0));
+    assert(wheelReplay.WaitIdleUntil(timing::MicrosNow() + 5'000'000));
+    assert(wheelSink->focus.size() == 2);
+    assert(wheelSink->focus[0].x == 10 && wheelSink->focus[1].x == 300);
+    assert(wheelSink->batches.size() == 2);
+    assert(wheelSink->batches[0].size() == 4 && wheelSink->batches[1].size() == 2);
+
+    // A click followed by a key over another window: the click is injected
+    // before that window is focused, not after.
+    const std::vector<trc::RawEvent> clickThenKey = {
+        make(trc::EventType::MouseDown, 50, 60, 1, 0),
+        make(trc::EventType::MouseUp, 50, 60, 1, 0),
+        make(trc::EventType::MouseMove, 400, 500, 0, 0),
+        make(trc::EventType::KeyDown, 0x43, 0, 0, 0),
+    };
+    auto orderSink = std::make_shared<RecordingSink>();
+    Replayer orderReplay;
+    orderReplay.SetInputSink(orderSink);
+    assert(orderReplay.Start(clickThenKey, false, 1.0));
+    assert(orderReplay.WaitIdleUntil(timing::MicrosNow() + 5'000'000));
+    assert(orderSink->calls == "SFS");
+    assert(orderSink->batches[0].size() == 2 + 2 + 1);
+    assert(orderSink->batches[0][1].mi.dwFlags == MOUSEEVENTF_LEFTDOWN);
+    assert(orderSink->focus.size() == 1 && orderSink->focus[0].x == 400 && orderSink->focus[0].y == 500);
+    assert(orderSink->batches[1].size() == 1 && orderSink->batches[1][0].ki.wVk == 0x43);
+
+    // Absolute moves must land on the exact pixel (Windows maps dx * w / 65536).
+    const input::VirtualScreen screen{ -1280, 0, 1280 + 2560, 1440 };
+    for (int x = screen.x; x < screen.x + screen.width; ++x) {
+        const INPUT in = input::MakeAbsoluteMove(screen, x, 17);
+        assert(screen.x + static_cast<int>((static_cast<int64_t>(in.mi.dx) * screen.width) >> 16) == x);
+        assert(static_cast<int>((static_cast<int64_t>(in.mi.dy) * screen.height) >> 16) == 17);
+    }
+
+    // A packed file replays block by block; every event still goes out once
+    // and in order across the block boundaries.
+    const auto packedPath = std::filesystem::temp_directory_path() / "acp_test_replay_v2.trc";
+    std::vector<trc::RawEvent> moves;
+    for (int i = 0; i < 3 * static_cast<int>(trc::kBlockEvents) + 7; ++i) {
+        moves.push_back(make(trc::EventType::MouseMove, i % 1000, i / 1000, 0, 0));
+    }
+    assert(trc::WriteTrcFile(packedPath.wstring(), moves, nullptr, trc::kVersionPacked));
+    auto packedSink = std::make_shared<RecordingSink>();
+    Replayer packed;
+    packed.SetInputSink(packedSink);
+    assert(packed.Start(trc::OpenTrcView(packedPath.wstring()), false, 1.0));
+    assert(packed.WaitIdleUntil(timing::MicrosNow() + 5'000'000));
+    size_t sent = 0;
+    for (const auto& batch : packedSink->batches) sent += batch.size();
+    assert(sent == moves.size());
+    const INPUT last = input::MakeAbsoluteMove(input::QueryVirtualScreen(), moves.back().x, moves.back().y);
+    assert(packedSink->batches.back().back().mi.dx == last.mi.dx && packedSink->batches.back().back().mi.dy == last.mi.dy);
+    std::filesystem::remove(packedPath);
+}
+
 static void TestTrcToLuaFullIncludesWheelAndKey() {
     const auto trcPath = std::filesystem::temp_directory_path() / "acp_test_full.trc";
     const auto luaPath = std::filesystem::temp_directory_path() / "acp_test_full.lua";
@@ -134,6 +793,66 @@ static void TestTrcToLuaFullIncludesWheelAndKey() {
     assert(lua.find("vk_up(65,0)") != std::string::npos);
 }
 
+// TrcToLuaFull streams block by block; its output must match a plain
+// per-event formatting of the whole recording for both file versions, and a
+// truncated file must fail rather than yield a silently short script.
+static void TestTrcToLuaFullStreamsBlocks() {
+    const auto trcPath = std::filesystem::temp_directory_path() / "acp_test_stream.trc";
+    const auto luaPath = std::filesystem::temp_directory_path() / "acp_test_stream.lua";
+
+    std::mt19937 rng{ 2024 };
+    std::vector<trc::RawEvent> events(3 * trc::kBlockEvents + 123);
+    std::ostringstream expected;
+    expected << "set_speed(1.0)\n";
+    for (auto& e : events) {
+        const int kind = int(rng() % 8);
+        e.type = static_cast<uint8_t>(kind < 4 ? trc::EventType::MouseMove
+            : kind == 4 ? trc::EventType::MouseDown : kind == 5 ? trc::EventType::MouseUp
+            : kind == 6 ? trc::EventType::KeyDown : trc::EventType::KeyUp);
+        e.x = int32_t(rng() % 7680) - 3840;
+        e.y = int32_t(rng() % 4320);
+        e.data = kind < 6 ? int32_t(rng() % 3) : 0;
+        e.timeDelta = rng() % 3 == 0 ? 0 : int64_t(rng() % 2'000'000);
+        if (e.timeDelta > 0) expected << "wait_us(" << e.timeDelta << ")\n";
+        switch (kind) {
+        case 4: expected << "mouse_down(" << e.data << "," << e.x << "," << e.y << ")\n"; break;
+        case 5: expected << "mouse_up(" << e.data << "," << e.x << "," << e.y << ")\n"; break;
+        case 6: expected << "vk_down(" << e.x << ",0)\n"; break;
+        case 7: expected << "vk_up(" << e.x << ",0)\n"; break;
+        default: expected << "mouse_move(" << e.x << "," << e.y << ")\n"; break;
+        }
+    }
+
+    for (const int32_t version : { trc::kVersionRaw, trc::kVersionPacked }) {
+        assert(trc::WriteTrcFile(trcPath.wstring(), events, nullptr, version));
+        assert(Converter::TrcToLuaFull(trcPath.wstring(), luaPath.wstring()));
+        assert(ReadAllBytes(luaPath) == expected.str());
+
+        // The compact export carries the same events as play_events() data.
+        assert(Converter::TrcToLuaCompact(trcPath.wstring(), luaPath.wstring()));
+        const std::string compact = ReadAllBytes(luaPath);
+        std::vector<trc::RawEvent> unpacked;
+        std::vector<trc::RawEvent> chunk;
+        for (size_t pos = 0; (pos = compact.find("play_events([[\n", pos)) != std::string::npos;) {
+            pos += 15;
+            const size_t end = compact.find("]])", pos);
+            assert(end != std::string::npos);
+            assert(trc::UnpackEventsText(std::string_view(compact).substr(pos, end - pos), chunk));
+            unpacked.insert(unpacked.end(), chunk.begin(), chunk.end());
+        }
+        assert(unpacked.size() == events.size());
+        assert(std::memcmp(unpacked.data(), events.data(), events.size() * sizeof(trc::RawEvent)) == 0);
+        assert(!trc::UnpackEventsText("AAAA!AAA", chunk));
+        assert(!trc::UnpackEventsText(compact.substr(compact.find("[[\n") + 3, 200), chunk));
+
+        std::filesystem::resize_file(trcPath, std::filesystem::file_size(trcPath) / 2);
+        assert(!Converter::TrcToLuaFull(trcPath.wstring(), luaPath.wstring()));
+        assert(!Converter::TrcToLuaCompact(trcPath.wstring(), luaPath.wstring()));
+    }
+    std::filesystem::remove(trcPath);
+    std::filesystem::remove(luaPath);
+}
+
 static void TestTrcReadRejectHugeEventCount() {
     const auto temp = std::filesystem::temp_directory_path() / "acp_test_huge.trc";
 
@@ -153,6 +872,16 @@ static void TestTrcReadRejectHugeEventCount() {
     trc::TrcReadResult rr{};
     const bool read = trc::ReadTrcFile(temp.wstring(), &rr);
     assert(!read); // Should be rejected
+
+    // Under the limit but far more than the (empty) body can hold: rejected
+    // without trying to allocate for it.
+    hdr.totalEvents = 40'000'000;
+    {
+        std::ofstream out(temp, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    }
+    assert(!trc::ReadTrcFile(temp.wstring(), &rr));
+    assert(!trc::OpenTrcView(temp.wstring()));
 }
 
 static void TestSchedulerSerializeRoundTrip() {
@@ -197,6 +926,523 @@ static void TestSchedulerSerializeRoundTrip() {
     assert(tasks[1].description == "line1\nline2|pipes\\backslash");
 }
 
+static void TestSchedulerNextWindowStart() {
+    // The window opens on the local hour, whatever the zone's UTC offset.
+    const int64_t now = Scheduler::NowEpochSeconds();
+    for (int hour : { 9, 13, 23 }) {
+        const int64_t start = Scheduler::NextWindowStart(hour, now);
+        assert(start > now && start - now <= 25 * 3600);
+        time_t sec = (time_t)start;
+        struct tm t{}; localtime_s(&t, &sec);
+        assert(t.tm_hour == hour && t.tm_min == 0 && t.tm_sec == 0);
+    }
+}
+
+static void TestSchedulerWakesOnDeadlineAndScales() {
+    // Run-now no longer waits for a polling tick.
+    {
+        Scheduler sched;
+        std::atomic<int> runs{ 0 };
+        sched.Start([&](const ScheduledTask&) { runs.fetch_add(1); });
+        ScheduledTask t;
+        t.type = TaskType::Periodic;
+        t.interval = 3600;
+        const int id = sched.AddTask(t);
+        const auto t0 = std::chrono::steady_clock::now();
+        sched.RunTaskNow(id);
+        while (runs.load() == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        assert(ms < 100.0);
+        sched.Stop();
+    }
+
+    // 100k tasks due at about the same time: queue inserts stay cheap and
+    // every task fires exactly once right after its deadline.
+    static constexpr int kTasks = 100'000;
+    Scheduler sched;
+    std::vector<uint8_t> fired(kTasks + 1, 0);
+    std::atomic<int> runs{ 0 };
+    std::atomic<int64_t> maxLateMicros{ 0 };
+    sched.Start([&](const ScheduledTask& task) {
+        ++fired[task.id];
+        runs.fetch_add(1);
+        const int64_t nowMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        maxLateMicros.store(std::max(maxLateMicros.load(), nowMicros - task.nextRunTime * 1'000'000));
+    });
+
+    ScheduledTask t;
+    t.type = TaskType::Periodic;
+    t.interval = 1;
+    t.maxRuns = 1;
+    const auto addStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTasks; ++i) {
+        t.priority = i % 3;
+        sched.AddTask(t);
+    }
+    const auto addMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - addStart).count();
+
+    const auto waitStart = std::chrono::steady_clock::now();
+    while (runs.load() < kTasks && std::chrono::steady_clock::now() - waitStart < std::chrono::seconds(30))
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sched.Stop();
+    assert(runs.load() == kTasks);
+    for (int id = 1; id <= kTasks; ++id) assert(fired[id] == 1);
+    assert(sched.ActiveTaskCount() == 0);
+    assert(maxLateMicros.load() < 5'000'000);
+    std::printf("scheduler: %d tasks added in %.1f ms, last one fired %.1f ms after its deadline\n", kTasks, addMs,
+        maxLateMicros.load() / 1000.0);
+}
+
+static void TestSchedulerExecutorPool() {
+    using namespace std::chrono_literals;
+    std::atomic<int> inputActive{ 0 }, inputOverlap{ 0 };
+    std::atomic<int> sameActive{ 0 }, sameOverlap{ 0 };
+    std::atomic<int> fastRuns{ 0 }, inputRuns{ 0 }, sameRuns{ 0 };
+    std::atomic<bool> slowDone{ false };
+
+    Scheduler sched;
+    sched.SetMaxConcurrency(3);
+    sched.Start([&](const ScheduledTask& task) {
+        if (task.name == "slow") {
+            std::this_thread::sleep_for(400ms);
+            slowDone.store(true);
+        } else if (task.name == "fast") {
+            fastRuns.fetch_add(1);
+        } else if (task.name == "input") {
+            if (inputActive.fetch_add(1) != 0) inputOverlap.fetch_add(1);
+            std::this_thread::sleep_for(30ms);
+            inputActive.fetch_sub(1);
+            inputRuns.fetch_add(1);
+        } else if (task.name == "same") {
+            if (sameActive.fetch_add(1) != 0) sameOverlap.fetch_add(1);
+            std::this_thread::sleep_for(30ms);
+            sameActive.fetch_sub(1);
+            sameRuns.fetch_add(1);
+        }
+    });
+
+    ScheduledTask t;
+    t.type = TaskType::Periodic;
+    t.interval = 3600;
+    t.exclusiveInput = false;
+    t.name = "slow";
+    const int slow = sched.AddTask(t);
+    t.name = "fast";
+    const int fast = sched.AddTask(t);
+    t.name = "same";
+    t.maxConcurrent = 1;
+    const int same = sched.AddTask(t);
+    t.name = "input";
+    t.exclusiveInput = true;
+    int input[3]{};
+    for (int& id : input) id = sched.AddTask(t);
+
+    // A slow task occupies one executor; the others keep going.
+    sched.RunTaskNow(slow);
+    std::this_thread::sleep_for(20ms);
+    sched.RunTaskNow(fast);
+    const auto t0 = std::chrono::steady_clock::now();
+    while (fastRuns.load() == 0 && std::chrono::steady_clock::now() - t0 < 2s) std::this_thread::sleep_for(1ms);
+    assert(fastRuns.load() == 1);
+    assert(!slowDone.load());
+
+    // Input tasks never overlap each other, and a task never overlaps itself.
+    for (int id : input) sched.RunTaskNow(id);
+    for (int i = 0; i < 3; ++i) {
+        sched.RunTaskNow(same);
+        std::this_thread::sleep_for(15ms);
+    }
+    auto busy = [&] {
+        const SchedulerMetrics m = sched.Metrics();
+        return m.running > 0 || m.queued > 0;
+    };
+    while ((inputRuns.load() < 3 || !slowDone.load() || busy()) &&
+        std::chrono::steady_clock::now() - t0 < 5s)
+        std::this_thread::sleep_for(5ms);
+    sched.Stop();
+    assert(inputRuns.load() == 3);
+    assert(inputOverlap.load() == 0);
+    assert(sameOverlap.load() == 0);
+    assert(sameRuns.load() >= 2);
+
+    const SchedulerMetrics m = sched.Metrics();
+    assert(m.peakRunning <= 3);
+    assert(m.running == 0 && m.queued == 0);
+    assert(m.completed == m.started);
+    assert(m.completed == m.dispatched);
+    assert(m.maxRunMicros >= 400'000);
+    std::printf("scheduler pool: %llu runs, queue wait mean %.2f ms max %.2f ms\n",
+        static_cast<unsigned long long>(m.completed), m.MeanQueueMillis(), m.maxQueueMicros / 1000.0);
+}
+
+static void TestSchedulerSnapshotCopyOnWrite() {
+    Scheduler sched;
+    ScheduledTask t;
+    t.type = TaskType::Periodic;
+    t.interval = 3600;
+    int ids[3]{};
+    for (int& id : ids) id = sched.AddTask(t);
+
+    const auto a = sched.Snapshot();
+    assert(a->tasks.size() == 3 && a->activeCount == 3);
+    // Unchanged table: the very same snapshot comes back.
+    assert(sched.Snapshot() == a);
+
+    // One task changes: only its entry is copied, the others are shared.
+    sched.SetTaskEnabled(ids[1], false);
+    const auto b = sched.Snapshot();
+    assert(b != a && b->version > a->version);
+    assert(b->tasks[0] == a->tasks[0] && b->tasks[2] == a->tasks[2]);
+    assert(b->tasks[1] != a->tasks[1]);
+    assert(a->tasks[1]->enabled && !b->tasks[1]->enabled);
+    assert(b->activeCount == 2);
+
+    // Old snapshots stay valid after removal.
+    sched.RemoveTask(ids[0]);
+    const auto c = sched.Snapshot();
+    assert(c->tasks.size() == 2 && c->tasks[0] == b->tasks[1] && c->tasks[1] == b->tasks[2]);
+    assert(a->tasks[0]->id == ids[0]);
+    sched.SetTaskEnabled(ids[2], false);
+    assert(sched.Snapshot()->tasks[1]->id == ids[2] && !sched.Snapshot()->tasks[1]->enabled);
+}
+
+static void TestLoggerAsyncPipeline() {
+    static constexpr int kThreads = 4;
+    static constexpr int kPerThread = 3000;   // more than one ring's worth, so the fallback path runs too
+    auto& logger = Logger::Instance();
+    const int oldMax = logger.GetMaxEntries();
+    const auto path = std::filesystem::temp_directory_path() / "acp_logger_test.log";
+    std::filesystem::remove(path);
+
+    logger.SetMaxEntries(0);
+    logger.Flush();
+    logger.Clear();
+    logger.SetFileOutput(true, path.string());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < kPerThread; ++i) LOG_INFO("LoggerTest", "t%d #%d", t, i);
+        });
+    }
+    for (auto& th : threads) th.join();
+    LOG_DEBUG("LoggerTest", "filtered out at the default level");
+    logger.Flush();
+
+    // Every entry arrives once, in call order per thread.
+    int next[kThreads]{};
+    size_t seen = 0;
+    for (const auto& e : logger.GetEntries()) {
+        if (e.source != "LoggerTest") continue;
+        int t = -1, i = -1;
+        assert(std::sscanf(e.message.c_str(), "t%d #%d", &t, &i) == 2);
+        assert(t >= 0 && t < kThreads && i == next[t]);
+        ++next[t];
+        ++seen;
+    }
+    assert(seen == size_t(kThreads) * kPerThread);
+
+    // Error waits for its own batch to reach the file.
+    LOG_ERROR("LoggerTest", "error line");
+    logger.SetFileOutput(false, path.string());
+    std::ifstream in(path);
+    std::string line, last;
+    size_t lines = 0;
+    while (std::getline(in, line)) {
+        if (line.find("[LoggerTest]") == std::string::npos) continue;
+        ++lines;
+        last = line;
+    }
+    assert(lines == size_t(kThreads) * kPerThread + 1);
+    assert(last.find("[ERROR]") != std::string::npos && last.find("[LoggerTest] error line") != std::string::npos);
+    in.close();
+    std::filesystem::remove(path);
+
+    // The UI ring keeps the newest entries.
+    logger.SetMaxEntries(100);
+    for (int i = 0; i < 250; ++i) LOG_WARN("LoggerTest", "ring %d", i);
+    logger.Flush();
+    const auto ring = logger.GetEntries(LogLevel::Warn);
+    assert(logger.EntryCount() == 100 && ring.size() == 100);
+    assert(ring.front().message == "ring 150" && ring.back().message == "ring 249");
+
+    // Sequence numbers let a poller copy only what is new.
+    const uint64_t lastSeen = ring.back().seq;
+    assert(logger.LastSequence() == lastSeen && logger.OldestSequence() == lastSeen - 99);
+    LOG_INFO("LoggerTest", "after %d", 1);
+    LOG_WARN("LoggerTest", "after %d", 2);
+    logger.Flush();
+    const auto since = logger.GetEntriesSince(lastSeen);
+    assert(since.size() == 2 && since[0].seq == lastSeen + 1 && since[1].message == "after 2");
+    const auto warnSince = logger.GetEntriesSince(lastSeen, LogLevel::Warn);
+    assert(warnSince.size() == 1 && warnSince[0].seq == lastSeen + 2);
+    assert(logger.GetEntriesSince(0).front().seq == logger.OldestSequence());
+    logger.Clear();
+    assert(logger.GetEntriesSince(0).empty() && logger.OldestSequence() == lastSeen + 3);
+    logger.SetMaxEntries(oldMax);
+}
+
+static void TestLoggerLevelGateAndFormat() {
+    auto& logger = Logger::Instance();
+    const LogLevel oldLevel = logger.GetLevel();
+    logger.SetLevel(LogLevel::Info);
+
+    // Disabled levels never evaluate their arguments.
+    int evaluated = 0;
+    auto touch = [&] { return ++evaluated; };
+    LOG_DEBUG("LoggerGate", "%d", touch());
+    assert(evaluated == 0);
+    LOG_INFO("LoggerGate", "%d", touch());
+    assert(evaluated == 1);
+
+#if ACP_LOG_HAS_FORMAT
+    // Arguments are captured by value; the temporary string is gone long
+    // before the writer formats the entry.
+    LOGF_INFO("LoggerGate", "{} of {} at {:.1f}x by {} ({})", 3, 7u, 1.5, std::string("replayer"), "ok");
+    LOGF_DEBUG("LoggerGate", "{}", touch());
+    assert(evaluated == 1);
+#endif
+    logger.Flush();
+    std::vector<std::string> messages;
+    for (const auto& e : logger.GetEntries()) {
+        if (e.source == "LoggerGate") messages.push_back(e.message);
+    }
+    assert(!messages.empty() && messages[0] == "1");
+#if ACP_LOG_HAS_FORMAT
+    assert(messages.size() == 2 && messages[1] == "3 of 7 at 1.5x by replayer (ok)");
+#endif
+    logger.SetLevel(oldLevel);
+}
+
+// Captures like Logger::Log, then formats like the writer thread / acp_logdump.
+static bool CaptureAndFormat(std::string& out, std::string& expected, const char* fmt, ...) {
+    char args[512];
+    size_t used = 0;
+    va_list va;
+    va_start(va, fmt);
+    va_list copy;
+    va_copy(copy, va);
+    const bool ok = logfmt::CapturePrintfArgs(fmt, copy, args, sizeof(args), used);
+    va_end(copy);
+    char buf[512];
+    std::vsnprintf(buf, sizeof(buf), fmt, va);
+    va_end(va);
+    expected = buf;
+    if (ok) logfmt::FormatPrintf(out, fmt, std::string_view(args, used));
+    return ok;
+}
+
+static void TestLogFormatPrintfMatchesVsnprintf() {
+    auto check = [](std::string got, const std::string& expected, bool ok) {
+        assert(ok && got == expected);
+    };
+    std::string got, expected;
+    bool ok = false;
+#define CHECK_FMT(...) (got.clear(), ok = CaptureAndFormat(got, expected, __VA_ARGS__), check(got, expected, ok))
+    CHECK_FMT("plain text, 100%% sure");
+    CHECK_FMT("%d %i %5d|%-5d|%05d %+d", -42, 7, 3, 4, 5, 6);
+    CHECK_FMT("%u %x %X %#o %08llx", 4000000000u, 255u, 0xABCDu, 8u, 0x1234ULL);
+    CHECK_FMT("%hhd %hd %ld %lld %zu %zd", 300, 70000, -5L, -1234567890123LL, size_t(99), ptrdiff_t(-3));
+    CHECK_FMT("%c%c %s|%10s|%-6s|%.3s|%.*s", 'o', 'k', "str", "right", "left", "truncate", 2, "xyz");
+    CHECK_FMT("%f %.2f %10.3e %g %G %a", 3.5, 2.125, 12345.678, 0.0001, 1e20, 1.0);
+    CHECK_FMT("%*d|%-*d|%*.*f", 6, 1, 4, 2, 8, 3, 3.14159);
+    CHECK_FMT("%s", static_cast<const char*>(nullptr));
+    CHECK_FMT("%.1f%% done, %s", 99.5, "\xe4\xbd\xa0\xe5\xa5\xbd");
+#undef CHECK_FMT
+
+    // %n is never captured.
+    int n = 0;
+    got.clear();
+    char args[64];
+    size_t used = 0;
+    auto capture = [&](const char* fmt, ...) {
+        va_list va;
+        va_start(va, fmt);
+        const bool r = logfmt::CapturePrintfArgs(fmt, va, args, sizeof(args), used);
+        va_end(va);
+        return r;
+    };
+    assert(!capture("%n", &n));
+    // Arguments that do not fit are rejected rather than truncated.
+    assert(!capture("%s", std::string(100, 'x').c_str()));
+
+    // std::format-style rendering used for LOGF_* entries in binary files.
+    char braced[128];
+    char* w = logfmt::PutInt(braced, -3);
+    w = logfmt::PutUInt(w, 255);
+    w = logfmt::PutFloat(w, 1.5);
+    w = logfmt::PutStr(w, "ab");
+    w = logfmt::PutUInt(w, 1, logfmt::ArgTag::Bool);
+    got.clear();
+    logfmt::FormatBraces(got, "{} {:#x} {:.2f} [{:>4}] {} {{}} {3}", std::string_view(braced, size_t(w - braced)));
+    assert(got == "-3 0xff 1.50 [  ab] true {} ab");
+}
+
+static void TestLoggerBinaryFileAndRotation() {
+    auto& logger = Logger::Instance();
+    const auto dir = std::filesystem::temp_directory_path() / "acp_logger_binary";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const auto path = (dir / "bin.log").string();
+
+    logger.Flush();
+    logger.SetFileFormat(LogFileFormat::Binary);
+    logger.SetFileRotation(4096, 3);
+    logger.SetFileOutput(true, path);
+    for (int i = 0; i < 2000; ++i) LOG_INFO("LoggerBinary", "entry %d of %s at %.2f", i, "run", i * 0.5);
+#if ACP_LOG_HAS_FORMAT
+    LOGF_WARN("LoggerBinary", "{} and {:>5}", 42, "fmt");
+#endif
+    logger.LogWithStack(LogLevel::Error, "LoggerBinary", "with stack", "frame0\nframe1");
+    logger.SetFileOutput(false, path);
+    logger.SetFileFormat(LogFileFormat::Text);
+    logger.SetFileRotation(16 * 1024 * 1024, 5);
+
+    // Rotation keeps at most three files, none (much) over the limit, and
+    // every one of them decodes on its own.
+    std::vector<std::string> files;
+    for (const auto& f : std::filesystem::directory_iterator(dir)) files.push_back(f.path().string());
+    assert(files.size() == 3);
+    std::vector<std::string> messages;
+    for (const auto& name : { path + ".2", path + ".1", path }) {
+        assert(std::filesystem::file_size(name) <= 4096 + 256);
+        std::ifstream in(name, std::ios::binary);
+        const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        logfmt::BinaryReader reader;
+        assert(reader.Open(data));
+        logfmt::BinaryEntry e;
+        while (reader.Next(e)) {
+            if (e.source != "LoggerBinary") continue;
+            std::string text;
+            logfmt::RenderMessage(text, e.style, e.fmt, e.args);
+            messages.push_back(text);
+        }
+        assert(!reader.Failed());
+    }
+    // The newest entries survive, in order.
+    assert(messages.size() > 10);
+    assert(messages.back() == "with stack");
+#if ACP_LOG_HAS_FORMAT
+    assert(messages[messages.size() - 2] == "42 and   fmt");
+    messages.pop_back();
+#endif
+    messages.pop_back();
+    assert(messages.back() == "entry 1999 of run at 999.50");
+    int first = -1;
+    assert(std::sscanf(messages.front().c_str(), "entry %d", &first) == 1);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        char expected[64];
+        std::snprintf(expected, sizeof(expected), "entry %d of run at %.2f", first + int(i), (first + int(i)) * 0.5);
+        assert(messages[i] == expected);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// The recursive RDP Converter used before SimplifyRdp.
+static void ReferenceRdp(const CursorPath& p, size_t start, size_t end, double eps, std::vector<uint8_t>& keep) {
+    if (end <= start + 1) return;
+    double maxD = 0.0;
+    size_t idx = 0;
+    for (size_t i = start + 1; i < end; ++i) {
+        const double dx = double(p.x[end]) - p.x[start];
+        const double dy = double(p.y[end]) - p.y[start];
+        const double denom = std::sqrt(dx * dx + dy * dy);
+        const double ex = double(p.x[i]) - p.x[start];
+        const double ey = double(p.y[i]) - p.y[start];
+        const double d = denom < 1e-6 ? std::sqrt(ex * ex + ey * ey)
+            : std::abs(dy * p.x[i] - dx * p.y[i] + double(p.x[end]) * p.y[start] - double(p.y[end]) * p.x[start]) / denom;
+        if (d > maxD) {
+            maxD = d;
+            idx = i;
+        }
+    }
+    if (idx != 0 && maxD > eps) {
+        keep[idx] = 1;
+        ReferenceRdp(p, start, idx, eps, keep);
+        ReferenceRdp(p, idx, end, eps, keep);
+    }
+}
+
+static void TestPathSimplifyMatchesRecursive() {
+    std::mt19937 rng{ 777 };
+    std::uniform_int_distribution<int> step(-6, 6);
+    std::vector<uint8_t> keep;
+    RdpScratch scratch;
+    for (const size_t n : { size_t(0), size_t(1), size_t(2), size_t(3), size_t(50), size_t(20000) }) {
+        CursorPath path;
+        int x = 500, y = 500;
+        for (size_t i = 0; i < n; ++i) {
+            x += step(rng);
+            y += step(rng);
+            // Return to the start now and then to exercise closed chords.
+            if (i % 997 == 996) { x = 500; y = 500; }
+            path.Push(x, y, int64_t(i) * 1000);
+        }
+        for (const double eps : { 0.5, 2.0, 7.5 }) {
+            std::vector<uint8_t> expected(n, 0);
+            if (n > 0) expected.front() = expected.back() = 1;
+            if (n > 2) ReferenceRdp(path, 0, n - 1, eps, expected);
+            const size_t kept = SimplifyRdp(path.x, path.y, eps, keep, scratch);
+            assert(keep == expected);
+            assert(kept == size_t(std::count(expected.begin(), expected.end(), 1)));
+        }
+    }
+
+    // Segments are simplified on their own, and the result does not depend on
+    // how many threads share them.
+    {
+        CursorPath path;
+        int x = 500, y = 500;
+        std::vector<size_t> starts;
+        std::uniform_int_distribution<int> gap(1, 40000);
+        for (size_t i = 0; i < 300000; ++i) {
+            x += step(rng);
+            y += step(rng);
+            path.Push(x, y, int64_t(i) * 1000);
+        }
+        for (size_t s = gap(rng); s < path.Size(); s += gap(rng)) starts.push_back(s);
+        starts.push_back(starts.back());   // duplicates are ignored
+
+        std::vector<uint8_t> expected(path.Size());
+        size_t expectedKept = 0;
+        for (size_t k = 0; k <= starts.size(); ++k) {
+            const size_t begin = k == 0 ? 0 : starts[k - 1];
+            const size_t end = k < starts.size() ? starts[k] : path.Size();
+            if (end <= begin) continue;
+            std::vector<uint8_t> part;
+            expectedKept += SimplifyRdp(std::span(path.x).subspan(begin, end - begin), std::span(path.y).subspan(begin, end - begin), 2.0, part, scratch);
+            std::copy(part.begin(), part.end(), expected.begin() + begin);
+        }
+        for (const unsigned threads : { 1u, 3u, 8u }) {
+            assert(SimplifyRdpSegments(path.x, path.y, starts, 2.0, keep, threads) == expectedKept);
+            assert(keep == expected);
+        }
+    }
+
+    // Every SIMD level this CPU has returns exactly what the scalar scan does,
+    // for all start offsets and tail lengths, including ties and all-zero runs.
+    std::uniform_int_distribution<int> coord(-40000, 40000);
+    std::uniform_int_distribution<int> small(0, 3);
+    std::vector<int32_t> xs(300), ys(300);
+    for (int round = 0; round < 50; ++round) {
+        auto& gen = round % 2 ? coord : small;   // small coordinates tie a lot
+        for (size_t i = 0; i < xs.size(); ++i) {
+            xs[i] = gen(rng);
+            ys[i] = gen(rng);
+        }
+        const double dx = gen(rng), dy = gen(rng), c = gen(rng);
+        for (size_t begin = 0; begin < 9; ++begin) {
+            for (size_t end = begin; end < xs.size(); end += 7) {
+                const ChordScan scalar = ScanChord(xs.data(), ys.data(), begin, end, dx, dy, c, SimdLevel::Scalar);
+                for (int level = 1; level <= int(BestSimdLevel()); ++level) {
+                    const ChordScan simd = ScanChord(xs.data(), ys.data(), begin, end, dx, dy, c, SimdLevel(level));
+                    assert(simd.index == scalar.index && std::memcmp(&simd.cross, &scalar.cross, sizeof(double)) == 0);
+                }
+            }
+        }
+    }
+}
+
 static void TestScrollAlgorithmTerminates() {
     // Test the Humanizer::Scroll algorithm logic without Windows APIs
     auto simulate = [](int delta) {
@@ -233,11 +1479,32 @@ static void TestScrollAlgorithmTerminates() {
 
 int main() {
     TestTrcRoundTrip();
+    TestTrcViewMapsEvents();
+    TestTrcPackedMatchesRaw();
+    TestTrcSeekIndex();
+    TestEventStoreChunks();
+    TestSpscRingBulkAndThreads();
+    TestRecorderStreamsToFile();
+    TestMoveFilterKeepsNonMoves();
+    TestWaiterDeadlinesAndCancel();
     TestReplayerRestartNoTerminate();
+    TestReplayerStopWhilePaused();
     TestReplayerStop();
+    TestReplayerDeadlineClock();
+    TestReplayerBatchesDueEvents();
     TestTrcToLuaFullIncludesWheelAndKey();
+    TestTrcToLuaFullStreamsBlocks();
+    TestPathSimplifyMatchesRecursive();
     TestTrcReadRejectHugeEventCount();
     TestSchedulerSerializeRoundTrip();
+    TestSchedulerNextWindowStart();
+    TestSchedulerWakesOnDeadlineAndScales();
+    TestSchedulerExecutorPool();
+    TestSchedulerSnapshotCopyOnWrite();
+    TestLoggerAsyncPipeline();
+    TestLoggerLevelGateAndFormat();
+    TestLogFormatPrintfMatchesVsnprintf();
+    TestLoggerBinaryFileAndRotation();
     TestScrollAlgorithmTerminates();
     return 0;
 }
@@ -0,0 +1,155 @@
+// logdump.cpp - decode binary AutoClicker Pro logs (LogFileFormat::Binary)
+//
+//   acp_logdump [--json] <file>...
+//
+// Text output matches the lines of the text log sink. --json writes one JSON
+// object per entry (JSON Lines) with the raw format string and arguments too.
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "core/LogFormat.h"
+
+namespace {
+
+const char* StyleName(logfmt::FormatStyle style) {
+    switch (style) {
+    case logfmt::FormatStyle::Printf:    return "printf";
+    case logfmt::FormatStyle::StdFormat: return "format";
+    default:                             return "text";
+    }
+}
+
+// The stack trace of a LogWithStack entry is its second string argument.
+std::string_view StackOf(const logfmt::BinaryEntry& e) {
+    if (e.style != logfmt::FormatStyle::Text) return {};
+    const char* p = e.args.data();
+    const char* end = p + e.args.size();
+    logfmt::ArgValue v;
+    if (!logfmt::NextArg(p, end, v) || !logfmt::NextArg(p, end, v) || v.tag != logfmt::ArgTag::Str) return {};
+    return v.s;
+}
+
+void AppendJsonArgs(std::string& out, std::string_view args) {
+    out += '[';
+    const char* p = args.data();
+    const char* end = p + args.size();
+    logfmt::ArgValue v;
+    for (bool first = true; logfmt::NextArg(p, end, v); first = false) {
+        if (!first) out += ',';
+        char buf[64];
+        switch (v.tag) {
+        case logfmt::ArgTag::Int:   snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v.i)); out += buf; break;
+        case logfmt::ArgTag::UInt:  snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v.u)); out += buf; break;
+        case logfmt::ArgTag::Float: snprintf(buf, sizeof(buf), "%.17g", v.f); out += buf; break;
+        case logfmt::ArgTag::Bool:  out += v.u ? "true" : "false"; break;
+        case logfmt::ArgTag::Char:  logfmt::AppendJsonString(out, std::string(1, static_cast<char>(v.u))); break;
+        case logfmt::ArgTag::Ptr:
+            snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(v.u));
+            logfmt::AppendJsonString(out, buf);
+            break;
+        case logfmt::ArgTag::Str:   logfmt::AppendJsonString(out, v.s); break;
+        }
+    }
+    out += ']';
+}
+
+void AppendText(std::string& out, const logfmt::BinaryEntry& e, const std::string& message) {
+    char prefix[96];
+    snprintf(prefix, sizeof(prefix), " [%s] [T:%u] [", logfmt::LevelName(e.level), e.threadId);
+    out += logfmt::FormatTimestamp(e.timestampMs);
+    out += prefix;
+    out += e.source;
+    out += "] ";
+    out += message;
+    const std::string_view stack = StackOf(e);
+    if (!stack.empty()) {
+        out += "\n  Stack: ";
+        out += stack;
+    }
+    out += '\n';
+}
+
+void AppendJson(std::string& out, const logfmt::BinaryEntry& e, const std::string& message) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "{\"ts\":%lld,\"time\":", static_cast<long long>(e.timestampMs));
+    out += buf;
+    logfmt::AppendJsonString(out, logfmt::FormatTimestamp(e.timestampMs));
+    out += ",\"level\":";
+    logfmt::AppendJsonString(out, logfmt::LevelName(e.level));
+    snprintf(buf, sizeof(buf), ",\"thread\":%u,\"source\":", e.threadId);
+    out += buf;
+    logfmt::AppendJsonString(out, e.source);
+    out += ",\"message\":";
+    logfmt::AppendJsonString(out, message);
+    if (e.style != logfmt::FormatStyle::Text) {
+        out += ",\"style\":";
+        logfmt::AppendJsonString(out, StyleName(e.style));
+        out += ",\"format\":";
+        logfmt::AppendJsonString(out, e.fmt);
+        out += ",\"args\":";
+        AppendJsonArgs(out, e.args);
+    }
+    const std::string_view stack = StackOf(e);
+    if (!stack.empty()) {
+        out += ",\"stack\":";
+        logfmt::AppendJsonString(out, stack);
+    }
+    out += "}\n";
+}
+
+bool DumpFile(const char* path, bool json) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "acp_logdump: cannot open %s\n", path);
+        return false;
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    logfmt::BinaryReader reader;
+    if (!reader.Open(data)) {
+        std::fprintf(stderr, "acp_logdump: %s is not a binary log\n", path);
+        return false;
+    }
+
+    std::string out;
+    std::string message;
+    logfmt::BinaryEntry e;
+    while (reader.Next(e)) {
+        message.clear();
+        logfmt::RenderMessage(message, e.style, e.fmt, e.args);
+        if (json) AppendJson(out, e, message);
+        else AppendText(out, e, message);
+        if (out.size() >= (1 << 16)) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    if (reader.Failed()) {
+        // A file cut short by a crash still dumps everything before the damage.
+        std::fprintf(stderr, "acp_logdump: %s: malformed or truncated record, stopped\n", path);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool json = false;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0) json = true;
+        else files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "usage: acp_logdump [--json] <file>...\n");
+        return 2;
+    }
+    bool ok = true;
+    for (const char* f : files) ok = DumpFile(f, json) && ok;
+    return ok ? 0 : 1;
+}